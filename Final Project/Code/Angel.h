@@ -15,6 +15,8 @@
 //
 
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 
 //  Define M_PI in the case it's not defined in the math header file
@@ -31,7 +33,9 @@
 //     this this "include" directory.
 //
 
-#ifdef __APPLE__  // include Mac OS X verions of headers
+#if defined(HEADLESS)  // simulation only build, no GL context
+#  include "HeadlessGL.h"
+#elif defined(__APPLE__)  // include Mac OS X verions of headers
 #  include <OpenGL/OpenGL.h>
 #  include <GLUT/glut.h>
 #else // non-Mac OS X operating systems
@@ -0,0 +1,53 @@
+#include "AssetID.h"
+
+#include <map>
+#include <vector>
+
+namespace {
+
+struct AssetNameTable
+{
+	static AssetNameTable& Get () {
+		static AssetNameTable s;
+		return s;
+	}
+
+	unsigned int Intern (const std::string& name) {
+		std::map<std::string, unsigned int>::iterator iter = m_indexes.find(name);
+
+		if (iter != m_indexes.end())
+			return iter->second;
+
+		unsigned int index = m_names.size();
+		m_names.push_back(name);
+		m_indexes[name] = index;
+
+		return index;
+	}
+
+	std::map<std::string, unsigned int> m_indexes;
+	std::vector<std::string> m_names;
+
+private:
+	AssetNameTable () {
+		Intern("");
+	}
+};
+
+}
+
+AssetID::AssetID (const char* name)
+	: m_index(AssetNameTable::Get().Intern(name))
+{}
+
+AssetID::AssetID (const std::string& name)
+	: m_index(AssetNameTable::Get().Intern(name))
+{}
+
+const std::string& AssetID::GetName () const {
+	return AssetNameTable::Get().m_names[m_index];
+}
+
+unsigned int AssetID::GetCount () {
+	return AssetNameTable::Get().m_names.size();
+}
@@ -0,0 +1,34 @@
+#ifndef __ASSETID_H__
+#define __ASSETID_H__
+
+#include <string>
+
+// Interned asset name.  Constructing an AssetID from a name looks it up in a
+// global table once; after that it is just a small index that the managers
+// use to find their assets in a flat array.  Index 0 is the empty name and
+// never refers to an asset.
+class AssetID
+{
+public:
+	AssetID ()
+		: m_index(0)
+	{}
+
+	AssetID (const char* name);
+	AssetID (const std::string& name);
+
+	unsigned int GetIndex () const { return m_index; }
+	const std::string& GetName () const;
+
+	bool operator== (const AssetID& other) const { return m_index == other.m_index; }
+	bool operator!= (const AssetID& other) const { return m_index != other.m_index; }
+	bool operator< (const AssetID& other) const { return m_index < other.m_index; }
+
+	// Number of names interned so far, every index is below this
+	static unsigned int GetCount ();
+
+private:
+	unsigned int m_index;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "AssetLoader.h"
+
+#include <stdio.h>
+
+#include "Timer.h"
+
+AssetLoadJob::AssetLoadJob (const std::string& name)
+	: m_name(name), m_loader(NULL), m_loaded(false), m_loadTime(0.0f), m_uploadTime(0.0f)
+{
+}
+
+void AssetLoadJob::Run () {
+	Timer loadTimer;
+
+	m_loaded = Load();
+	m_loadTime = loadTimer.GetElapsedTime();
+
+	m_loader->JobLoaded(this);
+}
+
+AssetLoader::AssetLoader (WorkerPool& workerPool)
+	: m_workerPool(workerPool)
+{
+}
+
+AssetLoader::~AssetLoader () {
+	// Jobs still queued reference this loader
+	if (!m_jobs.empty())
+		Finish();
+}
+
+void AssetLoader::Load (AssetLoadJob* job) {
+	job->m_loader = this;
+	m_jobs.push_back(job);
+
+	m_workerPool.Submit(job);
+}
+
+void AssetLoader::JobLoaded (AssetLoadJob* job) {
+	MutexLock lock(m_mutex);
+
+	m_uploadQueue.push_back(job);
+	m_jobLoaded.Signal();
+}
+
+void AssetLoader::Finish () {
+	Timer finishTimer;
+
+	for (unsigned int numUploaded = 0; numUploaded < m_jobs.size(); ++numUploaded) {
+		AssetLoadJob* job;
+
+		{
+			MutexLock lock(m_mutex);
+
+			while (m_uploadQueue.empty())
+				m_jobLoaded.Wait(m_mutex);
+
+			job = m_uploadQueue.front();
+			m_uploadQueue.pop_front();
+		}
+
+		if (job->m_loaded) {
+			Timer uploadTimer;
+
+			job->Upload();
+			job->m_uploadTime = uploadTimer.GetElapsedTime();
+		}
+		else {
+			job->LoadFailed();
+		}
+	}
+
+	float loadTime = 0.0f;
+	float uploadTime = 0.0f;
+	unsigned int numFailed = 0;
+
+	for (unsigned int i = 0; i < m_jobs.size(); ++i) {
+		loadTime += m_jobs[i]->m_loadTime;
+		uploadTime += m_jobs[i]->m_uploadTime;
+		numFailed += m_jobs[i]->m_loaded ? 0 : 1;
+	}
+
+	printf("AssetLoader::Finish: Loaded %u assets (%u failed) on %u threads, %.1f ms waiting for loads and uploads, %.1f ms loading, %.1f ms uploading.\n",
+		(unsigned int)m_jobs.size(), numFailed, m_workerPool.GetNumThreads(), finishTimer.GetElapsedTime() * 1000.0f, loadTime * 1000.0f, uploadTime * 1000.0f);
+
+	for (unsigned int i = 0; i < m_jobs.size(); ++i) {
+		printf("  %8.2f ms load %8.2f ms upload  %s%s\n", m_jobs[i]->m_loadTime * 1000.0f, m_jobs[i]->m_uploadTime * 1000.0f,
+			m_jobs[i]->GetName().c_str(), m_jobs[i]->m_loaded ? "" : " (failed)");
+
+		delete m_jobs[i];
+	}
+
+	m_jobs.clear();
+}
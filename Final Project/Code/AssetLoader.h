@@ -0,0 +1,77 @@
+#ifndef __ASSETLOADER_H__
+#define __ASSETLOADER_H__
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "Mutex.h"
+#include "WorkerPool.h"
+
+class AssetLoader;
+
+// One asset's load, split into the file reading and decoding that can run on
+// any thread and the GL upload that has to run on the GL thread.
+class AssetLoadJob : public WorkerJob
+{
+public:
+	AssetLoadJob (const std::string& name);
+	virtual ~AssetLoadJob () {}
+
+	// Worker thread, must not make GL calls or touch any other asset.  A
+	// failed load is not uploaded.
+	virtual bool Load () = 0;
+
+	// GL thread, called once Load has succeeded
+	virtual void Upload () = 0;
+
+	// GL thread, called instead of Upload when Load failed
+	virtual void LoadFailed () {}
+
+	const std::string& GetName () const { return m_name; }
+
+private:
+	friend class AssetLoader;
+
+	virtual void Run ();
+
+	std::string m_name;
+	AssetLoader* m_loader;
+
+	bool m_loaded;
+	float m_loadTime;
+	float m_uploadTime;
+};
+
+// Runs asset loads on a worker pool and hands each one back to the thread
+// calling Finish as soon as it is decoded, so uploads overlap the decoding of
+// the assets still in flight.
+class AssetLoader
+{
+public:
+	AssetLoader (WorkerPool& workerPool);
+	~AssetLoader ();
+
+	// Takes ownership of the job
+	void Load (AssetLoadJob* job);
+
+	// Uploads every queued job on the calling thread as its load finishes,
+	// then prints the load report and deletes the jobs
+	void Finish ();
+
+private:
+	friend class AssetLoadJob;
+
+	void JobLoaded (AssetLoadJob* job);
+
+	WorkerPool& m_workerPool;
+
+	// In submission order for the report
+	std::vector<AssetLoadJob*> m_jobs;
+
+	Mutex m_mutex;
+	Condition m_jobLoaded;
+	std::deque<AssetLoadJob*> m_uploadQueue;
+};
+
+#endif
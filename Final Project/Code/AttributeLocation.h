@@ -1,14 +1,22 @@
 #ifndef __ATTRIBUTELOCATION__
 #define __ATTRIBUTELOCATION__
 
+#include "Vertex.h"
+
 struct AttributeLocation
 {
 	AttributeLocation () 
-		: m_animatedGeometry(0), m_position0(0), m_normal0(0), m_texCoord0(0), m_position1(0) ,m_normal1(0), m_texCoord1(0)
+		: m_animatedGeometry(0), m_vertexBuffer(0), m_vertexFormat(e_VertexFormatFull), m_position0(0), m_normal0(0), m_texCoord0(0), m_position1(0) ,m_normal1(0), m_texCoord1(0)
 	{}
 
 	bool m_animatedGeometry;
 
+	// Buffer the offsets below point into
+	GLuint m_vertexBuffer;
+
+	VertexFormat m_vertexFormat;
+	VertexDecode m_vertexDecode;
+
 	GLuint m_position0;
 	GLuint m_normal0;
 	GLuint m_texCoord0;
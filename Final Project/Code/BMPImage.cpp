@@ -0,0 +1,118 @@
+#include "BMPImage.h"
+
+#include <string.h>
+
+#include "TextureCompression.h"
+
+// Largest side accepted, keeps stride * height well inside 32 bits
+static const unsigned int c_max_bmp_size = 16384;
+
+static const unsigned int c_bmp_file_header_size = 14;
+static const unsigned int c_bmp_info_header_size = 40;
+
+static const unsigned int c_bmp_compression_rgb = 0;
+static const unsigned int c_bmp_compression_bitfields = 3;
+
+// The header fields aren't aligned, so they are copied out
+static unsigned int ReadUInt (const char* data, unsigned int offset) {
+	unsigned int value;
+	memcpy(&value, data + offset, 4);
+	return value;
+}
+
+static unsigned short ReadUShort (const char* data, unsigned int offset) {
+	unsigned short value;
+	memcpy(&value, data + offset, 2);
+	return value;
+}
+
+bool ParseBMPFile (const char* data, unsigned int size, BMPImage& image, std::string& error) {
+	if (size < c_bmp_file_header_size + c_bmp_info_header_size || data[0] != 'B' || data[1] != 'M') {
+		error = "not a BMP file";
+		return false;
+	}
+
+	unsigned int dataBegin = ReadUInt(data, 10);
+	unsigned int infoSize = ReadUInt(data, 14);
+	int width = (int)ReadUInt(data, 18);
+	int height = (int)ReadUInt(data, 22);
+	unsigned short planes = ReadUShort(data, 26);
+	unsigned short bitsPerPixel = ReadUShort(data, 28);
+	unsigned int compression = ReadUInt(data, 30);
+
+	// BITMAPINFOHEADER or one of the later versions that extend it, the
+	// older OS/2 core header stores 16 bit sizes
+	if (infoSize < c_bmp_info_header_size || c_bmp_file_header_size + infoSize > size || planes != 1) {
+		error = "unsupported header";
+		return false;
+	}
+
+	if (bitsPerPixel != 24 && bitsPerPixel != 32) {
+		error = "only 24 and 32 bit images are supported";
+		return false;
+	}
+
+	// Bitfields are only accepted when they describe plain BGRA, the masks
+	// follow the info header or sit inside the V4/V5 header
+	if (compression == c_bmp_compression_bitfields && bitsPerPixel == 32) {
+		unsigned int masks = c_bmp_file_header_size + c_bmp_info_header_size;
+
+		if (masks + 12 > size || ReadUInt(data, masks) != 0x00ff0000 ||
+			ReadUInt(data, masks + 4) != 0x0000ff00 || ReadUInt(data, masks + 8) != 0x000000ff) {
+			error = "unsupported bitfields";
+			return false;
+		}
+	}
+	else if (compression != c_bmp_compression_rgb) {
+		error = "unsupported compression";
+		return false;
+	}
+
+	// A negative height stores the rows top down
+	bool topDown = height < 0;
+	unsigned int absHeight = topDown ? (unsigned int)-(long long)height : (unsigned int)height;
+
+	if (width <= 0 || absHeight == 0 || (unsigned int)width > c_max_bmp_size || absHeight > c_max_bmp_size) {
+		error = "bad dimensions";
+		return false;
+	}
+
+	unsigned int bytesPerPixel = bitsPerPixel / 8;
+	unsigned int stride = ((unsigned int)width * bytesPerPixel + 3) & ~3u;
+
+	if (dataBegin < c_bmp_file_header_size + infoSize || dataBegin > size || stride * absHeight > size - dataBegin) {
+		error = "pixel data runs past the end of the file";
+		return false;
+	}
+
+	image.m_width = width;
+	image.m_height = absHeight;
+	image.m_bytesPerPixel = bytesPerPixel;
+	image.m_stride = stride;
+	image.m_topDown = topDown;
+	image.m_pixels = (const unsigned char*)data + dataBegin;
+
+	return true;
+}
+
+void DecodeBMPImage (const BMPImage& bmpImage, TextureImageRGBA& image) {
+	unsigned int width = bmpImage.m_width;
+	unsigned int height = bmpImage.m_height;
+	unsigned int bytesPerPixel = bmpImage.m_bytesPerPixel;
+
+	image.m_width = width;
+	image.m_height = height;
+	image.m_pixels.resize(width * height * 4);
+
+	for (unsigned int y = 0; y < height; ++y) {
+		const unsigned char* row = bmpImage.GetRow(y);
+		unsigned char* pixel = &image.m_pixels[y * width * 4];
+
+		for (unsigned int x = 0; x < width; ++x, pixel += 4, row += bytesPerPixel) {
+			pixel[0] = row[2];
+			pixel[1] = row[1];
+			pixel[2] = row[0];
+			pixel[3] = bytesPerPixel == 4 ? row[3] : 255;
+		}
+	}
+}
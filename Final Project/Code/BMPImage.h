@@ -0,0 +1,37 @@
+#ifndef __BMPIMAGE_H__
+#define __BMPIMAGE_H__
+
+#include <string>
+
+struct TextureImageRGBA;
+
+// Uncompressed 24 or 32 bit BMP, parsed in place.  The pixel pointer points
+// into the data it was parsed from, in the file's own BGR(A) byte order.
+struct BMPImage
+{
+	unsigned int m_width;
+	unsigned int m_height;
+	unsigned int m_bytesPerPixel;
+
+	// Bytes per row including the padding to 4 bytes, which is also GL's
+	// default unpack alignment
+	unsigned int m_stride;
+
+	// Rows stored top row first, GL and most BMPs have the bottom row first
+	bool m_topDown;
+
+	const unsigned char* m_pixels;
+
+	// Row y counted from the bottom, whichever order the file stores them in
+	const unsigned char* GetRow (unsigned int y) const {
+		return m_pixels + m_stride * (m_topDown ? m_height - 1 - y : y);
+	}
+};
+
+// Checks the header against the data size, on failure error says why
+bool ParseBMPFile (const char* data, unsigned int size, BMPImage& image, std::string& error);
+
+// Copies the pixels out as bottom up RGBA, opaque when the file has no alpha
+void DecodeBMPImage (const BMPImage& bmpImage, TextureImageRGBA& image);
+
+#endif
@@ -1,132 +1,508 @@
 #include "BMPTexture.h"
 
-BMPTexture::BMPTexture (TextureType type, TextureMode mode, TextureFormat format, const std::vector<const std::string>& fileNames)
-  : m_type(type), m_format(format), m_textureID(0) 
+#include <string.h>
+
+#include "BMPImage.h"
+#include "MappedFile.h"
+#include "TextureCompression.h"
+#include "GLStateCache.h"
+
+// Granularity the mapped files are paged in at
+static const unsigned int c_page_size = 4096;
+
+// Largest mip a streamed texture starts out with
+static const unsigned int c_stream_initial_size = 64;
+
+static const GLuint c_texture_faces[6] = {
+	GL_TEXTURE_CUBE_MAP_POSITIVE_X,
+	GL_TEXTURE_CUBE_MAP_POSITIVE_Y,
+	GL_TEXTURE_CUBE_MAP_POSITIVE_Z,
+	GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
+	GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+	GL_TEXTURE_CUBE_MAP_NEGATIVE_Z
+};
+
+// One source image, the mapped BMP or the mip chain of its cooked DDS.  Both
+// point into their mapping, nothing is copied until GL takes the pixels,
+// except for array layers that had to be resampled.
+struct TextureImage
 {
+	MappedFile m_bmpFile;
+	BMPImage m_bmpImage;
+	TextureImageRGBA m_resampled;
+
+	MappedFile m_ddsFile;
+	DDSImage m_ddsImage;
+};
+
+static GLenum GetBMPFormat (const BMPImage& image) {
+	return image.m_bytesPerPixel == 4 ? GL_BGRA : GL_BGR;
+}
+
+static GLint GetBMPInternalFormat (const BMPImage& image) {
+	return image.m_bytesPerPixel == 4 ? GL_RGBA8 : GL_RGB8;
+}
+
+static GLenum GetCompressedFormat (TextureCompression compression) {
+	switch (compression) {
+		case e_TextureCompressionBC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case e_TextureCompressionBC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case e_TextureCompressionBC5: return GL_COMPRESSED_RG_RGTC2;
+		default: return 0;
+	}
+}
+
+BMPTexture::BMPTexture (TextureType type, TextureMode mode, TextureFormat format, const std::vector<std::string>& fileNames, unsigned int layerWidth, unsigned int layerHeight)
+  : m_fileNames(fileNames), m_images(fileNames.size(), (TextureImage*)NULL), m_numRead(0), m_cookedDecided(false), m_cooked(false), m_type(type), m_mode(mode), m_format(format), m_textureID(0),
+	m_layerWidth(layerWidth), m_layerHeight(layerHeight), m_width(0), m_height(0), m_numMips(0), m_memorySize(0),
+	m_streamable(false), m_minimumMip(0), m_residentMip(0), m_requestedMip(0), m_lastUseFrame(0)
+{
+}
+
+unsigned int BMPTexture::GetMemorySize (unsigned int mip) const {
+	if (!m_streamable)
+		return m_memorySize;
 
-	switch (type) {
-		case e_TextureType2d:
-			Load2dTexture(fileNames);	 
-		break;
+	unsigned int memorySize = 0;
 
-		case e_TextureTypeCube:
-			LoadCubeTexture(fileNames);
-		break;
+	for (unsigned int i = 0; i < m_images.size(); ++i) {
+		for (unsigned int level = mip; level < m_numMips; ++level)
+			memorySize += m_images[i]->m_ddsImage.m_mipSizes[level];
 	}
 
-	if (mode == e_TextureModeNearest) {
+	return memorySize;
+}
+
+void BMPTexture::MarkUsed (unsigned int frame, unsigned int screenPixels) {
+	// A texture stretched over screenPixels needs about that many texels
+	// across, every halving beyond that is a mip it can do without
+	unsigned int mip = 0;
+	unsigned int size = m_width > m_height ? m_width : m_height;
+
+	while (mip < m_minimumMip && (size >> (mip + 1)) >= screenPixels)
+		++mip;
+
+	if (m_lastUseFrame != frame || mip < m_requestedMip)
+		m_requestedMip = mip;
+
+	m_lastUseFrame = frame;
+}
+
+void BMPTexture::SetResidentMip (unsigned int mip) {
+	if (!m_streamable || mip == m_residentMip || mip > m_minimumMip)
+		return;
+
+	// Levels can't be released one at a time, so the texture is rebuilt with
+	// the new chain out of the mapped DDS files
+	GLStateCache::Get().DeleteTexture(m_textureID);
+	glGenTextures(1, &m_textureID);
+	GLStateCache::Get().BindTexture(e_TextureChannelDiffuse, m_type, m_textureID);
+
+	UploadCompressedMips(mip);
+	SetTextureMode(m_numMips - mip);
+
+	m_residentMip = mip;
+}
+
+// numMips is the number of levels uploaded, 1 when the driver has to build
+// the chain
+void BMPTexture::SetTextureMode (unsigned int numMips) {
+	if (m_mode == e_TextureModeNearest) {
 		glTexParameteri(m_type, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexParameteri(m_type, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	}
-	else if (mode == e_TextureModeBiLinear) {
+	else if (m_mode == e_TextureModeBiLinear) {
 		glTexParameteri(m_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(m_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	}
-	else if (mode == e_TextureModeTriLinear) {
+	else if (m_mode == e_TextureModeTriLinear) {
 		glTexParameteri(m_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 		glTexParameteri(m_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(m_type, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTexParameteri(m_type, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-		glGenerateMipmap(m_type);
+		if (numMips > 1)
+			glTexParameteri(m_type, GL_TEXTURE_MAX_LEVEL, numMips - 1);
+		else
+			glGenerateMipmap(m_type);
 	}                    
 }
                                    
 BMPTexture::~BMPTexture() {
-	glDeleteTextures(1, &m_textureID);
+	ReleaseImages();
+
+	GLStateCache::Get().DeleteTexture(m_textureID);
 }
 
-char* BMPTexture::ReadTextureFile (const std::string& fileName) {
-	std::ifstream is;
-	is.open (fileName.c_str(), std::ios::binary);
+void BMPTexture::ReleaseImages () {
+	for (unsigned int i = 0; i < m_images.size(); ++i) {
+		delete m_images[i];
+		m_images[i] = NULL;
+	}
+}
 
-	if( !is.is_open() ) {
-		printf("BMPTexture::ReadTextureFile: Error loading Texture %s", fileName.c_str());
-		return NULL;
+bool BMPTexture::ReadBMPFile (const std::string& fileName, TextureImage& image) {
+	if (!image.m_bmpFile.Open(fileName)) {
+		printf("BMPTexture::ReadBMPFile: Error loading Texture %s.\n", fileName.c_str());
+		return false;
 	}
 
-	int length;
-	char* data;
+	std::string error;
 
-	is.seekg (0, std::ios::end);
-	length = is.tellg();
-	is.seekg (0, std::ios::beg);
+	if (!ParseBMPFile(image.m_bmpFile.GetData(), image.m_bmpFile.GetSize(), image.m_bmpImage, error)) {
+		printf("BMPTexture::ReadBMPFile: Invalid %s, %s.\n", fileName.c_str(), error.c_str());
+		image.m_bmpFile.Close();
+		return false;
+	}
 
-	data = new char [length];
+	// Touch every page so the disk reads happen here on the loading thread
+	// rather than as page faults in the middle of the upload
+	const char* data = image.m_bmpFile.GetData();
+	unsigned int size = image.m_bmpFile.GetSize();
+	volatile char touch = 0;
 
-	is.read (data,length);
-	is.close();
+	for (unsigned int offset = 0; offset < size; offset += c_page_size)
+		touch ^= data[offset];
 
-	return data;
+	const BMPImage& bmpImage = image.m_bmpImage;
+
+	if (m_type == e_TextureType2dArray && (bmpImage.m_width != m_layerWidth || bmpImage.m_height != m_layerHeight)) {
+		TextureImageRGBA decoded;
+		DecodeBMPImage(bmpImage, decoded);
+		ResampleImage(decoded, m_layerWidth, m_layerHeight, image.m_resampled);
+
+		image.m_bmpFile.Close();
+	}
+
+	return true;
 }
 
-void BMPTexture::Load2dTexture (const std::vector<const std::string>& fileNames) {
-	if (fileNames.size() != 1)
-		return;
+bool BMPTexture::ReadDDSFile (const std::string& fileName, TextureImage& image) {
+	std::string ddsFile = fileName.substr(0, fileName.rfind('.')) + ".dds";
 
-	char* data = ReadTextureFile(fileNames[0]);
+	if (!image.m_ddsFile.Open(ddsFile))
+		return false;
 
-	if (data == NULL)
-		return;
-	
-	unsigned int dataBegin = *((unsigned int*)(data+10)); 
+	if (!ParseDDSFile(image.m_ddsFile.GetData(), image.m_ddsFile.GetSize(), image.m_ddsImage)) {
+		printf("BMPTexture::ReadDDSFile: Invalid %s.\n", ddsFile.c_str());
+		image.m_ddsFile.Close();
+		return false;
+	}
 
-	unsigned int width = *((unsigned int*)(data+18));
-	unsigned int height = *((unsigned int*)(data+22));
+	// Without the BMP the cooked file is all there is
+	long long sourceSize;
+	long long sourceTime;
 
-	glGenTextures(1, &m_textureID); 
+	if (GetFileStamp(fileName, sourceSize, sourceTime) &&
+		(image.m_ddsImage.m_sourceSize != sourceSize || image.m_ddsImage.m_sourceTime != sourceTime)) {
+		printf("BMPTexture::ReadDDSFile: %s is out of date, run texcook.\n", ddsFile.c_str());
+		image.m_ddsFile.Close();
+		return false;
+	}
 
-	glBindTexture(m_type, m_textureID);
-	glTexImage2D(m_type, 0, 4, width, height, 0, m_format, GL_UNSIGNED_BYTE, &data[dataBegin]);
+	if (m_type == e_TextureType2dArray && (image.m_ddsImage.m_width != m_layerWidth || image.m_ddsImage.m_height != m_layerHeight)) {
+		printf("BMPTexture::ReadDDSFile: %s doesn't match the array's layer size, run texcook.\n", ddsFile.c_str());
+		image.m_ddsFile.Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool BMPTexture::ReadImage (unsigned int image) {
+	if (image >= m_fileNames.size())
+		return false;
+
+	delete m_images[image];
+	m_images[image] = new TextureImage();
+
+	const std::string& fileName = m_fileNames[image];
+	bool read;
+
+	if (m_images.size() == 1)
+		read = ReadDDSFile(fileName, *m_images[image]) || ReadBMPFile(fileName, *m_images[image]);
+	else if (UseCookedImages())
+		read = ReadDDSFile(fileName, *m_images[image]);
+	else
+		read = ReadBMPFile(fileName, *m_images[image]);
+
+	if (!read) {
+		delete m_images[image];
+		m_images[image] = NULL;
+	}
 
-	delete[] data;
+	return read;
 }
 
-void BMPTexture::LoadCubeTexture (const std::vector<const std::string>& fileNames) {
-	if (fileNames.size() != 6)
+bool BMPTexture::UseCookedImages () {
+	MutexLock lock(m_cookedMutex);
+
+	if (m_cookedDecided)
+		return m_cooked;
+
+	// Mapping a DDS file only pages in its header, the mips stay on disk
+	TextureCompression compression = e_TextureCompressionNone;
+	m_cooked = true;
+
+	for (unsigned int i = 0; i < m_fileNames.size() && m_cooked; ++i) {
+		TextureImage image;
+
+		if (!ReadDDSFile(m_fileNames[i], image))
+			m_cooked = false;
+		else if (i > 0 && image.m_ddsImage.m_compression != compression)
+			m_cooked = false;
+
+		compression = image.m_ddsImage.m_compression;
+	}
+
+	m_cookedDecided = true;
+	return m_cooked;
+}
+
+void BMPTexture::UploadImage (unsigned int image) {
+	if (image >= m_images.size())
+		return;
+
+	if (++m_numRead == m_images.size())
+		UploadImages();
+}
+
+void BMPTexture::UploadImages () {
+	unsigned int numFailed = 0;
+
+	for (unsigned int i = 0; i < m_images.size(); ++i)
+		numFailed += m_images[i] == NULL ? 1 : 0;
+
+	if (numFailed > 0) {
+		printf("BMPTexture::UploadImages: %u of %u images of %s failed to read, the texture stays empty.\n", numFailed, (unsigned int)m_images.size(), m_fileNames[0].c_str());
+		ReleaseImages();
+		return;
+	}
+
+	if (m_type == e_TextureTypeCube && m_images.size() != 6) {
+		ReleaseImages();
 		return;
+	}
 
-	bool error = false;
-	char* data[6];
+	// ReadImage already chose DDS or BMP for the whole set
+	bool compressed = true;
+	unsigned int numMips = 0;
 
-	for (int i = 0; i < 6; ++i) {
-		data[i] = ReadTextureFile(fileNames[i]);
-		error = error || data[i] == NULL;
+	for (unsigned int i = 0; i < m_images.size(); ++i) {
+		const TextureImage* textureImage = m_images[i];
+
+		if (textureImage->m_ddsFile.GetData() == NULL || textureImage->m_ddsImage.m_compression != m_images[0]->m_ddsImage.m_compression) {
+			compressed = false;
+			break;
+		}
+
+		unsigned int imageMips = textureImage->m_ddsImage.m_mipData.size();
+		numMips = numMips == 0 || imageMips < numMips ? imageMips : numMips;
 	}
 
-	if (error) {
-		for (int i = 0; i < 6; ++i) {
-			if (data[i] != NULL)
-				delete[] data[i];
+	if (!compressed) {
+		numMips = 1;
+
+		// Only when a DDS file changed after UseCookedImages checked it
+		for (unsigned int i = 0; i < m_images.size(); ++i) {
+			if (m_images[i]->m_bmpFile.GetData() == NULL && m_images[i]->m_resampled.m_pixels.empty()) {
+				printf("BMPTexture::UploadImages: %s changed while it was read, the texture stays empty.\n", m_fileNames[i].c_str());
+				ReleaseImages();
+				return;
+			}
 		}
+	}
+
+	if (m_textureID == 0)
+		glGenTextures(1, &m_textureID); 
 
-		printf("BMPTexture::LoadCubeTexture: Error loading Texture");
+	GLStateCache::Get().BindTexture(e_TextureChannelDiffuse, m_type, m_textureID);
+
+	m_numMips = numMips;
+
+	// Cooked textures keep their DDS files mapped and start out with only
+	// the mips up to c_stream_initial_size, the rest is streamed in on
+	// request.  Pages of the larger mips aren't read from disk until then.
+	if (compressed) {
+		m_width = m_images[0]->m_ddsImage.m_width;
+		m_height = m_images[0]->m_ddsImage.m_height;
+		m_streamable = true;
+
+		while (m_minimumMip + 1 < m_numMips && ((m_width >> m_minimumMip) > c_stream_initial_size || (m_height >> m_minimumMip) > c_stream_initial_size))
+			++m_minimumMip;
+
+		m_residentMip = m_minimumMip;
+
+		UploadCompressedMips(m_residentMip);
+		SetTextureMode(m_numMips - m_residentMip);
 		return;
 	}
-	
-	glGenTextures(1, &m_textureID); 
-	glBindTexture(m_type, m_textureID);
 
-	static const GLuint textureFaces[6] = {
-		GL_TEXTURE_CUBE_MAP_POSITIVE_X,
-		GL_TEXTURE_CUBE_MAP_POSITIVE_Y,
-		GL_TEXTURE_CUBE_MAP_POSITIVE_Z,
-		GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
-		GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
-		GL_TEXTURE_CUBE_MAP_NEGATIVE_Z
-	};
+	const TextureImage* image = m_images[0];
+
+	m_width = m_type == e_TextureType2dArray ? m_layerWidth : image->m_bmpImage.m_width;
+	m_height = m_type == e_TextureType2dArray ? m_layerHeight : image->m_bmpImage.m_height;
+
+	// Driver built mips add a third
+	m_memorySize = m_width * m_height * 4 * m_images.size();
+	m_memorySize += m_mode == e_TextureModeTriLinear ? m_memorySize / 3 : 0;
+
+	if (m_type == e_TextureType2dArray)
+		UploadArrayLayers();
+	else if (m_type == e_TextureTypeCube)
+		UploadCubeFaces(c_texture_faces);
+	else
+		UploadBMPImage(m_type, image->m_bmpImage);
+
+	ReleaseImages();
+
+	SetTextureMode(numMips);
+}
+
+// Levels firstMip and smaller of every image become levels 0 and up of the
+// texture
+void BMPTexture::UploadCompressedMips (unsigned int firstMip) {
+	GLenum compressedFormat = GetCompressedFormat(m_images[0]->m_ddsImage.m_compression);
+	GLsizei numImages = m_images.size();
+
+	unsigned int width = m_width;
+	unsigned int height = m_height;
+
+	for (unsigned int mip = 0; mip < m_numMips; ++mip) {
+		if (mip >= firstMip) {
+			GLint level = mip - firstMip;
+
+			if (m_type == e_TextureType2dArray) {
+				GLsizei mipSize = m_images[0]->m_ddsImage.m_mipSizes[mip];
+				glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, compressedFormat, width, height, numImages, 0, mipSize * numImages, NULL);
+			}
+
+			for (GLsizei i = 0; i < numImages; ++i) {
+				const DDSImage& ddsImage = m_images[i]->m_ddsImage;
+
+				if (m_type == e_TextureType2dArray)
+					glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, i, width, height, 1, compressedFormat, ddsImage.m_mipSizes[mip], ddsImage.m_mipData[mip]);
+				else
+					glCompressedTexImage2D(m_type == e_TextureTypeCube ? c_texture_faces[i] : m_type, level, compressedFormat, width, height, 0, ddsImage.m_mipSizes[mip], ddsImage.m_mipData[mip]);
+			}
+		}
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+}
+
+// BMP rows are padded to 4 bytes, which is GL's default unpack alignment, so
+// the mapped pixels are handed to GL as they are
+void BMPTexture::UploadBMPImage (GLenum target, const BMPImage& image) {
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (!image.m_topDown) {
+		glTexImage2D(target, 0, GetBMPInternalFormat(image), image.m_width, image.m_height, 0, GetBMPFormat(image), GL_UNSIGNED_BYTE, image.m_pixels);
+		return;
+	}
 
-	for (int i = 0; i < 6; ++i) {
-		unsigned int dataBegin = *((unsigned int*)(data[i]+10)); 
-		unsigned int width = *((unsigned int*)(data[i]+18));
-		unsigned int height = *((unsigned int*)(data[i]+22));
+	// GL wants the bottom row first, so top down files go a row at a time
+	glTexImage2D(target, 0, GetBMPInternalFormat(image), image.m_width, image.m_height, 0, GetBMPFormat(image), GL_UNSIGNED_BYTE, NULL);
+
+	for (unsigned int y = 0; y < image.m_height; ++y)
+		glTexSubImage2D(target, 0, 0, y, image.m_width, 1, GetBMPFormat(image), GL_UNSIGNED_BYTE, image.GetRow(y));
+}
+
+// The six faces are staged in one pixel unpack buffer, one copy out of the
+// mappings instead of the driver copying each face out of client memory
+// during its glTexImage2D
+void BMPTexture::UploadCubeFaces (const GLuint* faces) {
+	unsigned int bufferSize = 0;
+
+	for (unsigned int i = 0; i < m_images.size(); ++i)
+		bufferSize += m_images[i]->m_bmpImage.m_stride * m_images[i]->m_bmpImage.m_height;
+
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	GLStateCache::Get().BindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, bufferSize, NULL, GL_STREAM_DRAW);
+
+	unsigned char* bufferData = (unsigned char*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+	bool uploaded = false;
+
+	if (bufferData != NULL) {
+		unsigned int offset = 0;
+
+		for (unsigned int i = 0; i < m_images.size(); ++i) {
+			const BMPImage& image = m_images[i]->m_bmpImage;
+			unsigned int imageSize = image.m_stride * image.m_height;
+
+			if (image.m_topDown) {
+				for (unsigned int y = 0; y < image.m_height; ++y)
+					memcpy(bufferData + offset + image.m_stride * y, image.GetRow(y), image.m_stride);
+			}
+			else
+				memcpy(bufferData + offset, image.m_pixels, imageSize);
+
+			offset += imageSize;
+		}
+
+		// The contents can be lost while mapped, then the faces go the slow way
+		if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE) {
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+			offset = 0;
+
+			for (unsigned int i = 0; i < m_images.size(); ++i) {
+				const BMPImage& image = m_images[i]->m_bmpImage;
+
+				glTexImage2D(faces[i], 0, GetBMPInternalFormat(image), image.m_width, image.m_height, 0, GetBMPFormat(image), GL_UNSIGNED_BYTE, BUFFER_OFFSET(offset));
+				offset += image.m_stride * image.m_height;
+			}
+
+			uploaded = true;
+		}
+	}
+
+	// GL keeps the storage alive until the uploads have read it
+	GLStateCache::Get().BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	GLStateCache::Get().DeleteBuffer(buffer);
+
+	if (uploaded)
+		return;
+
+	printf("BMPTexture::UploadCubeFaces: Mapping the unpack buffer failed, uploading from client memory.\n");
+
+	for (unsigned int i = 0; i < m_images.size(); ++i)
+		UploadBMPImage(faces[i], m_images[i]->m_bmpImage);
+}
+
+// Storage for every layer is allocated first and the layers are copied in
+// one at a time, straight from their mapping unless they were resampled
+void BMPTexture::UploadArrayLayers () {
+	GLsizei numLayers = m_images.size();
+
+	GLint internalFormat = m_format == e_TextureFormatRGBA ? GL_RGBA8 : GL_RGB8;
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, m_layerWidth, m_layerHeight, numLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	for (GLsizei layer = 0; layer < numLayers; ++layer) {
+		const TextureImage* image = m_images[layer];
+
+		if (!image->m_resampled.m_pixels.empty()) {
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_layerWidth, m_layerHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, &image->m_resampled.m_pixels[0]);
+			continue;
+		}
+
+		const BMPImage& bmpImage = image->m_bmpImage;
+
+		if (!bmpImage.m_topDown) {
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_layerWidth, m_layerHeight, 1, GetBMPFormat(bmpImage), GL_UNSIGNED_BYTE, bmpImage.m_pixels);
+			continue;
+		}
 
-		glTexImage2D(textureFaces[i], 0, 4, width, height, 0, m_format, GL_UNSIGNED_BYTE, &data[i][dataBegin]);
-		delete[] data[i];
+		for (unsigned int y = 0; y < bmpImage.m_height; ++y)
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, y, layer, m_layerWidth, 1, 1, GetBMPFormat(bmpImage), GL_UNSIGNED_BYTE, bmpImage.GetRow(y));
 	}
 }
  
 void BMPTexture::Apply (TextureChannel channel) {
-	glActiveTexture(channel);
-	glBindTexture(m_type, m_textureID); 
+	GLStateCache::Get().BindTexture(channel, m_type, m_textureID);
 }
@@ -3,32 +3,114 @@
 
 #include <string>
 #include <vector>
-#include <fstream>
 
 #include "Angel.h"
 
 #include "GraphicsSettings.h"
+#include "Mutex.h"
 
+struct BMPImage;
+struct TextureImage;
+
+// Loaded one image at a time, a single image for 2d textures and one per face
+// for cube maps.  Each image comes from the DDS texcook made of its BMP when
+// that is still up to date, otherwise straight from the memory mapped BMP
+// itself, without a copy on the heap.  Cube faces and array layers must share
+// one format, so they only come from their DDS files when every one of them
+// is up to date.  The images can be read on any thread, but the texture
+// stays empty until every image has been uploaded on the GL thread, and for
+// good if any of them failed to read.
+//
+// A 2d array texture takes one image per layer, all at layerWidth by
+// layerHeight.  Layers of another size are resampled when they are read, so
+// texcook cooks them at the layer size up front.
 class BMPTexture
 {
 public:
-	BMPTexture (TextureType type, TextureMode mode, TextureFormat format, const std::vector<const std::string>& fileNames);
+	BMPTexture (TextureType type, TextureMode mode, TextureFormat format, const std::vector<std::string>& fileNames,
+		unsigned int layerWidth = 0, unsigned int layerHeight = 0);
 	~BMPTexture (); 
 
 	void Apply (TextureChannel channel);
 	TextureFormat GetFormat () { return m_format; }
 
+	unsigned int GetNumImages () const { return m_fileNames.size(); }
+	const std::string& GetFileName (unsigned int image) const { return m_fileNames[image]; }
+
+	// No GL calls, different images may be read at the same time
+	bool ReadImage (unsigned int image);
+
+	// Called for every image once its read succeeded or failed, the GL
+	// texture is created after the last one
+	void UploadImage (unsigned int image);
+
+	// Residency.  Textures uploaded from cooked DDS files can drop and stream
+	// back their larger mips, textures built from BMPs always stay at full
+	// resolution.  Mips are counted from the full resolution image, so a
+	// resident mip of 0 is everything.
+	bool IsStreamable () const { return m_streamable; }
+	unsigned int GetMinimumMip () const { return m_minimumMip; }
+	unsigned int GetResidentMip () const { return m_residentMip; }
+	unsigned int GetRequestedMip () const { return m_requestedMip; }
+	unsigned int GetLastUseFrame () const { return m_lastUseFrame; }
+
+	// Bytes of texture memory with mip and everything smaller resident
+	unsigned int GetMemorySize (unsigned int mip) const;
+	unsigned int GetMemorySize () const { return GetMemorySize(m_residentMip); }
+
+	// Drawn this frame covering screenPixels of the screen height
+	void MarkUsed (unsigned int frame, unsigned int screenPixels);
+
+	// Rebuilds the texture with the new mip chain, no more than the minimum
+	void SetResidentMip (unsigned int mip);
+
 private:
-     
-    char* ReadTextureFile (const std::string& fileName);
-	void Load2dTexture (const std::vector<const std::string>& fileNames);
-    void LoadCubeTexture (const std::vector<const std::string>& fileNames);
 
-	std::string file;
+	bool ReadBMPFile (const std::string& fileName, TextureImage& image);
+	bool ReadDDSFile (const std::string& fileName, TextureImage& image);
+
+	// Whether a set of images is read from the DDS files, the first image
+	// read checks the headers of all of them
+	bool UseCookedImages ();
+
+	void ReleaseImages ();
+	void UploadImages ();
+	void UploadBMPImage (GLenum target, const BMPImage& image);
+	void UploadCubeFaces (const GLuint* faces);
+	void UploadArrayLayers ();
+	void UploadCompressedMips (unsigned int firstMip);
+	void SetTextureMode (unsigned int numMips);
+
+	std::vector<std::string> m_fileNames;
+	// NULL for images that failed to read
+	std::vector<TextureImage*> m_images;
+	unsigned int m_numRead;
+
+	Mutex m_cookedMutex;
+	bool m_cookedDecided;
+	bool m_cooked;
      
 	TextureType m_type;
+	TextureMode m_mode;
 	TextureFormat m_format;
 	GLuint m_textureID;
+
+	unsigned int m_layerWidth;
+	unsigned int m_layerHeight;
+
+	// Size of the full resolution image and its mip chain
+	unsigned int m_width;
+	unsigned int m_height;
+	unsigned int m_numMips;
+
+	// Only used when not streamable
+	unsigned int m_memorySize;
+
+	bool m_streamable;
+	unsigned int m_minimumMip;
+	unsigned int m_residentMip;
+	unsigned int m_requestedMip;
+	unsigned int m_lastUseFrame;
 };
 
 #endif
\ No newline at end of file
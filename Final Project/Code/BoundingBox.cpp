@@ -1,6 +1,6 @@
 #include "BoundingBox.h"
 
-BoundingBox::BoundingBox(vec2& center, float hw, float hl)
+BoundingBox::BoundingBox(const vec2& center, float hw, float hl)
 {
 	m_hw = hw;
 	m_hl = hl;
@@ -45,7 +45,7 @@ void BoundingBox::update(GLfloat x, GLfloat z, float size)
 
 BoundingBox::~BoundingBox(){}
 
-vec2 BoundingBox::calc(vec2& A, vec2& B)
+vec2 BoundingBox::calc(const vec2& A, const vec2& B)
 {
 	float min = 10000;
 	float max = 0;
@@ -108,7 +108,7 @@ vec2 BoundingBox::getAxis()
 	return normalize(m_c1-m_c2);
 }
 
-void BoundingBox::setCenter(vec2& center)
+void BoundingBox::setCenter(const vec2& center)
 {
 	m_center = center;
 	rotate(0.f);
@@ -119,7 +119,7 @@ vec2 BoundingBox::getCenter()
 	return m_center;
 }
 
-void BoundingBox::setDirection(vec2& w)
+void BoundingBox::setDirection(const vec2& w)
 {
 	vec2 v = normalize(w);
 	vec2 u = normal(v);
@@ -133,7 +133,7 @@ void BoundingBox::setDirection(vec2& w)
 	m_c4 = m_center+m_v4;
 }
 
-bool collide(vec2& a, vec2& b)
+bool collide(const vec2& a, const vec2& b)
 {
 	return (a.y > b.x && b.y > a.x);
 }
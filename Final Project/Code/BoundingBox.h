@@ -7,12 +7,12 @@
 class BoundingBox
 {
 public:
-	BoundingBox(vec2& center, float hw, float hl);
+	BoundingBox(const vec2& center, float hw, float hl);
 	~BoundingBox();
-	vec2 calc(vec2& A, vec2& B);
+	vec2 calc(const vec2& A, const vec2& B);
 	void rotate(double theta);
-	void setDirection(vec2& v);
-	void setCenter(vec2& center);
+	void setDirection(const vec2& v);
+	void setCenter(const vec2& center);
 	vec2 getAxis();
 	vec2 getCenter();
 	RenderBatch* getRenderBatch ();
@@ -25,6 +25,6 @@ private:
 	float m_hw, m_hl;
 };
 
-bool collide(vec2& a, vec2& b);
+bool collide(const vec2& a, const vec2& b);
 bool collision(BoundingBox& a, BoundingBox& b);
 #endif
\ No newline at end of file
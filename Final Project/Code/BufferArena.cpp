@@ -0,0 +1,176 @@
+#include "BufferArena.h"
+
+#include "GLStateCache.h"
+
+BufferArena::BufferArena (GLenum target, unsigned int elementSize, unsigned int pageSize)
+	: m_target(target), m_elementSize(elementSize), m_pageSize(pageSize), m_used(0)
+{}
+
+BufferArena::~BufferArena () {
+	for (unsigned int i = 0; i < m_pages.size(); ++i) {
+		if (m_pages[i] != NULL) {
+			GLStateCache::Get().DeleteBuffer(m_pages[i]->m_buffer);
+			delete m_pages[i];
+		}
+	}
+}
+
+unsigned int BufferArena::GetNumPages () const {
+	unsigned int numPages = 0;
+
+	for (unsigned int i = 0; i < m_pages.size(); ++i) {
+		if (m_pages[i] != NULL)
+			++numPages;
+	}
+
+	return numPages;
+}
+
+unsigned int BufferArena::GetCapacity () const {
+	unsigned int capacity = 0;
+
+	for (unsigned int i = 0; i < m_pages.size(); ++i) {
+		if (m_pages[i] != NULL)
+			capacity += m_pages[i]->m_size;
+	}
+
+	return capacity;
+}
+
+bool BufferArena::Allocate (unsigned int count, BufferRange& range) {
+	if (count == 0) {
+		printf("BufferArena::Allocate: Empty allocation.\n");
+		return false;
+	}
+
+	for (unsigned int i = 0; i < m_pages.size(); ++i) {
+		if (AllocateFromPage(i, count, range))
+			return true;
+	}
+
+	unsigned int pageIndex;
+
+	// Grow, oversized requests get a page of their own
+	if (!AddPage(count > m_pageSize ? count : m_pageSize, pageIndex))
+		return false;
+
+	return AllocateFromPage(pageIndex, count, range);
+}
+
+void BufferArena::Release (const BufferRange& range) {
+	if (range.m_count == 0)
+		return;
+
+	if (range.m_page >= m_pages.size() || m_pages[range.m_page] == NULL) {
+		printf("BufferArena::Release: Invalid page %u.\n", range.m_page);
+		return;
+	}
+
+	Page* page = m_pages[range.m_page];
+	std::vector<FreeBlock>& freeBlocks = page->m_freeBlocks;
+
+	unsigned int insert = 0;
+	while (insert < freeBlocks.size() && freeBlocks[insert].m_start < range.m_start)
+		++insert;
+
+	FreeBlock block;
+	block.m_start = range.m_start;
+	block.m_count = range.m_count;
+
+	freeBlocks.insert(freeBlocks.begin() + insert, block);
+
+	// Merge with the following and then the preceding block
+	if (insert + 1 < freeBlocks.size() && freeBlocks[insert].m_start + freeBlocks[insert].m_count == freeBlocks[insert + 1].m_start) {
+		freeBlocks[insert].m_count += freeBlocks[insert + 1].m_count;
+		freeBlocks.erase(freeBlocks.begin() + insert + 1);
+	}
+
+	if (insert > 0 && freeBlocks[insert - 1].m_start + freeBlocks[insert - 1].m_count == freeBlocks[insert].m_start) {
+		freeBlocks[insert - 1].m_count += freeBlocks[insert].m_count;
+		freeBlocks.erase(freeBlocks.begin() + insert);
+	}
+
+	m_used -= range.m_count;
+
+	// Give empty overflow pages back to the driver
+	if (range.m_page > 0 && freeBlocks.size() == 1 && freeBlocks[0].m_count == page->m_size) {
+		GLStateCache::Get().DeleteBuffer(page->m_buffer);
+		delete page;
+		m_pages[range.m_page] = NULL;
+	}
+}
+
+void BufferArena::Upload (const BufferRange& range, unsigned int first, unsigned int count, const void* data) {
+	if (first + count > range.m_count) {
+		printf("BufferArena::Upload: Upload outside of range.\n");
+		return;
+	}
+
+	GLStateCache::Get().BindBuffer(m_target, range.m_buffer);
+	glBufferSubData(m_target, (range.m_start + first) * m_elementSize, count * m_elementSize, data);
+}
+
+bool BufferArena::AllocateFromPage (unsigned int pageIndex, unsigned int count, BufferRange& range) {
+	Page* page = m_pages[pageIndex];
+
+	if (page == NULL)
+		return false;
+
+	std::vector<FreeBlock>& freeBlocks = page->m_freeBlocks;
+
+	for (unsigned int i = 0; i < freeBlocks.size(); ++i) {
+		if (freeBlocks[i].m_count < count)
+			continue;
+
+		range.m_buffer = page->m_buffer;
+		range.m_page = pageIndex;
+		range.m_start = freeBlocks[i].m_start;
+		range.m_count = count;
+
+		freeBlocks[i].m_start += count;
+		freeBlocks[i].m_count -= count;
+
+		if (freeBlocks[i].m_count == 0)
+			freeBlocks.erase(freeBlocks.begin() + i);
+
+		m_used += count;
+		return true;
+	}
+
+	return false;
+}
+
+bool BufferArena::AddPage (unsigned int size, unsigned int& pageIndex) {
+	Page* page = new Page();
+	page->m_size = size;
+
+	glGenBuffers(1, &page->m_buffer);
+	GLStateCache::Get().BindBuffer(m_target, page->m_buffer);
+	glBufferData(m_target, size * m_elementSize, NULL, GL_STATIC_DRAW);
+
+	GLenum error = glGetError();
+	if (error) {
+		printf("BufferArena::AddPage: Error %u allocating %u bytes.\n", error, size * m_elementSize);
+		GLStateCache::Get().DeleteBuffer(page->m_buffer);
+		delete page;
+		return false;
+	}
+
+	FreeBlock block;
+	block.m_start = 0;
+	block.m_count = size;
+	page->m_freeBlocks.push_back(block);
+
+	// Reuse a slot left by a released page
+	for (unsigned int i = 0; i < m_pages.size(); ++i) {
+		if (m_pages[i] == NULL) {
+			m_pages[i] = page;
+			pageIndex = i;
+			return true;
+		}
+	}
+
+	m_pages.push_back(page);
+	pageIndex = m_pages.size() - 1;
+	return true;
+}
@@ -0,0 +1,74 @@
+#ifndef __BUFFERARENA_H__
+#define __BUFFERARENA_H__
+
+#include <vector>
+
+#include "Angel.h"
+
+// A range of elements handed out by a BufferArena
+struct BufferRange
+{
+	BufferRange ()
+		: m_buffer(0), m_page(0), m_start(0), m_count(0)
+	{}
+
+	GLuint m_buffer;
+	unsigned int m_page;
+
+	// In elements, not bytes
+	unsigned int m_start;
+	unsigned int m_count;
+};
+
+// Sub-allocates ranges out of one or more GL buffers.  Each buffer (page)
+// keeps a first fit free list sorted by offset that merges neighbours on
+// release.  A new page is created whenever no existing one has room, and
+// pages other than the first are deleted again once they are empty.
+class BufferArena
+{
+public:
+	BufferArena (GLenum target, unsigned int elementSize, unsigned int pageSize);
+	~BufferArena ();
+
+	bool Allocate (unsigned int count, BufferRange& range);
+	void Release (const BufferRange& range);
+
+	// Copies count elements into the range starting at element first
+	void Upload (const BufferRange& range, unsigned int first, unsigned int count, const void* data);
+
+	unsigned int GetNumPages () const;
+	unsigned int GetCapacity () const;
+	unsigned int GetUsed () const { return m_used; }
+
+private:
+	// Not copyable, the buffers are owned
+	BufferArena (const BufferArena&);
+	BufferArena& operator= (const BufferArena&);
+
+	struct FreeBlock
+	{
+		unsigned int m_start;
+		unsigned int m_count;
+	};
+
+	struct Page
+	{
+		GLuint m_buffer;
+		unsigned int m_size;
+		std::vector<FreeBlock> m_freeBlocks;
+	};
+
+	bool AllocateFromPage (unsigned int pageIndex, unsigned int count, BufferRange& range);
+	bool AddPage (unsigned int size, unsigned int& pageIndex);
+
+	GLenum m_target;
+	unsigned int m_elementSize;
+	unsigned int m_pageSize;
+	unsigned int m_used;
+
+	// Pages are never reordered, released pages leave a NULL slot so the page
+	// indexes held by live ranges stay valid
+	std::vector<Page*> m_pages;
+};
+
+#endif
@@ -2,16 +2,23 @@
 #define __CACHEDRENDERBATCH__
 
 #include "RenderBatch.h"
-#include "RenderParameters.h"
 
+// Plain data, a frame's batches are dropped by clearing the array that holds
+// them
 struct CachedRenderBatch 
 {
-	CachedRenderBatch (const RenderBatch& renderBatch, const RenderParameters& renderParameters)
-		: m_renderBatch(renderBatch), m_renderParameters(renderParameters) 
+	CachedRenderBatch (const RenderBatch& renderBatch, unsigned int renderParameters, unsigned int lod = 0, float screenSize = 1.0f)
+		: m_renderBatch(renderBatch), m_renderParameters(renderParameters), m_lod(lod), m_screenSize(screenSize)
 	{}
 	
 	RenderBatch m_renderBatch;
-	RenderParameters m_renderParameters;
+
+	// Index of the frame's parameter block the batch was submitted with
+	unsigned int m_renderParameters;
+	unsigned int m_lod;
+
+	// Fraction of the screen height the batch covers, picks texture mips
+	float m_screenSize;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,265 @@
+// ------------------------
+// Draw list microbenchmark
+// ------------------------
+//
+// Builds the draw lists of a synthetic frame the way GraphicsManager::Render
+// does, once on this thread alone and once split over a worker pool, and
+// checks both come out the same.  The draw builder below stands in for
+// GraphicsManager::BuildDraw with the same frustum test, screen size, level
+// of detail and sort key work, so no GL context is needed.  Also times the
+// dispatch of an empty job, which with the cost of a batch gives the
+// smallest range worth handing to a worker.  Built by the drawlistbench
+// target in the Makefile.
+//
+//   drawlistbench [-batches N] [-threads N] [-frames N]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "Angel.h"
+
+#include "DrawListJob.h"
+#include "RenderBatch.h"
+#include "RenderQueue.h"
+#include "Timer.h"
+#include "ViewFrustum.h"
+#include "WorkerPool.h"
+
+// Side of the square the batches are scattered over, the camera sees about
+// half of it
+static const float c_world_size = 200.0f;
+
+// Screen sizes below which each coarser level is drawn, as in GeometryManager
+static const unsigned int c_max_lods = 4;
+static const float c_lod_screen_sizes[c_max_lods - 1] = { 0.2f, 0.1f, 0.05f };
+
+// Scenery the game places, with their bounding radii
+static const char* c_geometry_names[] = { "tree", "rock", "bush", "wall", "crate" };
+static const float c_geometry_radii[] = { 2.5f, 0.8f, 0.6f, 1.5f, 0.7f };
+static const unsigned int c_num_geometry = sizeof(c_geometry_radii) / sizeof(c_geometry_radii[0]);
+
+class BenchDrawBuilder : public DrawBuilder
+{
+public:
+	BenchDrawBuilder (const mat4& viewProjectionMatrix)
+		: m_viewProjectionMatrix(viewProjectionMatrix), m_frustum(viewProjectionMatrix)
+	{
+		for (unsigned int i = 0; i < c_num_geometry; ++i) {
+			AssetID geometryID = c_geometry_names[i];
+
+			if (geometryID.GetIndex() >= m_radii.size())
+				m_radii.resize(geometryID.GetIndex() + 1, 1.0f);
+
+			m_radii[geometryID.GetIndex()] = c_geometry_radii[i];
+		}
+
+		m_projectionScale = length(vec3(viewProjectionMatrix[1][0], viewProjectionMatrix[1][1], viewProjectionMatrix[1][2]));
+	}
+
+	virtual bool BuildDraw (const RenderBatch& batch, unsigned int& lod, float& screenSize, SortKey& sortKey) const {
+		lod = 0;
+		screenSize = 1.0f;
+
+		if (batch.m_effectParameters.m_HUDRender) {
+			sortKey = RenderQueue::MakeOrderedKey(e_GeometryTypeHUD, 0);
+			return true;
+		}
+
+		const mat4& model = batch.m_effectParameters.m_modelviewMatrix;
+		float radius = batch.m_geometryID.GetIndex() < m_radii.size() ? m_radii[batch.m_geometryID.GetIndex()] : 1.0f;
+
+		vec4 worldCenter = model * vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+		if (!m_frustum.IntersectsSphere(vec3(worldCenter.x, worldCenter.y, worldCenter.z), radius))
+			return false;
+
+		vec4 center = m_viewProjectionMatrix * worldCenter;
+		float depth = center.w;
+
+		if (center.w > radius) {
+			screenSize = radius * m_projectionScale / center.w;
+			screenSize = screenSize < 1.0f ? screenSize : 1.0f;
+		}
+
+		while (lod + 1 < c_max_lods && screenSize < c_lod_screen_sizes[lod])
+			++lod;
+
+		DrawState drawState;
+		drawState.m_diffuseTexture = batch.m_effectParameters.m_diffuseTexture.GetIndex();
+		drawState.m_normalMap = batch.m_effectParameters.m_normalMap.GetIndex();
+		drawState.m_geometry = batch.m_geometryID.GetIndex();
+		drawState.m_twoSided = batch.m_effectParameters.m_twoSided;
+
+		if (batch.m_effectParameters.m_materialOpacity < 1.0f)
+			sortKey = RenderQueue::MakeTransparentKey(drawState, depth);
+		else
+			sortKey = RenderQueue::MakeOpaqueKey(drawState, depth);
+
+		return true;
+	}
+
+private:
+	mat4 m_viewProjectionMatrix;
+	ViewFrustum m_frustum;
+	float m_projectionScale;
+
+	std::vector<float> m_radii;
+};
+
+// The split and merge of GraphicsManager::Render, numJobs of the jobs with
+// this thread building the last range
+static void BuildDrawLists (WorkerPool* workerPool, std::vector<DrawListJob*>& jobs, unsigned int numJobs,
+	const std::vector<const RenderBatch*>& batches, std::vector<CachedRenderBatch>& cachedRenderBatches, std::vector<DrawPacket>& packets) {
+	cachedRenderBatches.clear();
+	packets.clear();
+
+	for (unsigned int i = 0; i < numJobs; ++i) {
+		unsigned int first = batches.size() * i / numJobs;
+		unsigned int last = batches.size() * (i + 1) / numJobs;
+
+		jobs[i]->Start(&batches[first], last - first, 0);
+
+		if (i + 1 < numJobs)
+			workerPool->Submit(jobs[i]);
+		else
+			jobs[i]->Run();
+	}
+
+	for (unsigned int i = 0; i < numJobs; ++i) {
+		DrawListJob& job = *jobs[i];
+		job.Wait();
+
+		unsigned int firstBatch = cachedRenderBatches.size();
+		cachedRenderBatches.insert(cachedRenderBatches.end(), job.m_cachedRenderBatches.begin(), job.m_cachedRenderBatches.end());
+
+		for (unsigned int j = 0; j < job.m_packets.size(); ++j) {
+			DrawPacket packet = job.m_packets[j];
+			packet.m_batch += firstBatch;
+			packets.push_back(packet);
+		}
+	}
+}
+
+static bool IsSameDrawList (const std::vector<DrawPacket>& first, const std::vector<DrawPacket>& second) {
+	if (first.size() != second.size())
+		return false;
+
+	for (unsigned int i = 0; i < first.size(); ++i) {
+		if (first[i].m_sortKey != second[i].m_sortKey || first[i].m_batch != second[i].m_batch)
+			return false;
+	}
+
+	return true;
+}
+
+int main (int argc, char** argv) {
+	int numBatches = 8000;
+	int numThreads = 0;
+	int frames = 200;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-batches") == 0 && i + 1 < argc)
+			numBatches = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			numThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else {
+			printf("usage: %s [-batches N] [-threads N] [-frames N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (numBatches <= 0 || numThreads < 0 || frames <= 0) {
+		printf("usage: %s [-batches N] [-threads N] [-frames N]\n", argv[0]);
+		return 1;
+	}
+
+	// The game's camera, behind and above the player looking down the field
+	mat4 viewProjectionMatrix = Perspective(45.0f, 4.0f / 3.0f, 0.5f, 150.0f) *
+		LookAt(vec4(0.0f, 15.0f, 15.0f, 1.0f), vec4(0.0f, 0.0f, -20.0f, 1.0f), vec4(0.0f, 1.0f, 0.0f, 0.0f));
+
+	BenchDrawBuilder drawBuilder(viewProjectionMatrix);
+
+	std::vector<RenderBatch> renderBatches(numBatches);
+	std::vector<const RenderBatch*> batches(numBatches);
+
+	srand(1);
+
+	for (int i = 0; i < numBatches; ++i) {
+		RenderBatch& batch = renderBatches[i];
+		float x = (rand() / (float)RAND_MAX - 0.5f) * c_world_size;
+		float z = (rand() / (float)RAND_MAX - 1.0f) * c_world_size;
+
+		batch.m_geometryID = c_geometry_names[i % c_num_geometry];
+		batch.m_effectParameters.m_diffuseTexture = c_geometry_names[(i / c_num_geometry) % c_num_geometry];
+		batch.m_effectParameters.m_modelviewMatrix = Translate(x, 0.0f, z);
+
+		batches[i] = &batch;
+	}
+
+	// No pool is the game with a single core, every range on this thread
+	WorkerPool* workerPool = numThreads > 0 ? new WorkerPool(numThreads) : NULL;
+	unsigned int numJobs = numThreads + 1;
+
+	std::vector<DrawListJob*> jobs;
+	for (unsigned int i = 0; i < numJobs; ++i)
+		jobs.push_back(new DrawListJob(drawBuilder));
+
+	std::vector<CachedRenderBatch> cachedRenderBatches;
+	std::vector<DrawPacket> serialPackets;
+	std::vector<DrawPacket> packets;
+
+	// Once to size every list, so neither timing counts the allocations
+	BuildDrawLists(NULL, jobs, 1, batches, cachedRenderBatches, serialPackets);
+	BuildDrawLists(workerPool, jobs, numJobs, batches, cachedRenderBatches, packets);
+
+	Timer serialTimer;
+	for (int i = 0; i < frames; ++i)
+		BuildDrawLists(NULL, jobs, 1, batches, cachedRenderBatches, serialPackets);
+	float serialTime = serialTimer.GetElapsedTime() * 1000.0f / frames;
+
+	Timer splitTimer;
+	for (int i = 0; i < frames; ++i)
+		BuildDrawLists(workerPool, jobs, numJobs, batches, cachedRenderBatches, packets);
+	float splitTime = splitTimer.GetElapsedTime() * 1000.0f / frames;
+
+	// Waking a worker for an empty range is what each extra job costs
+	float dispatchTime = 0.0f;
+
+	if (workerPool != NULL) {
+		const unsigned int dispatches = 10000;
+
+		Timer dispatchTimer;
+		for (unsigned int i = 0; i < dispatches; ++i) {
+			jobs[0]->Start(&batches[0], 0, 0);
+			workerPool->Submit(jobs[0]);
+			jobs[0]->Wait();
+		}
+		dispatchTime = dispatchTimer.GetElapsedTime() * 1000.0f / dispatches;
+	}
+
+	float batchTime = serialTime / numBatches;
+
+	printf("%d batches, %u visible, %d worker threads on %u cores\n", numBatches, (unsigned int)serialPackets.size(), numThreads, WorkerPool::GetNumCores());
+	printf("  one thread: %8.3f ms a frame, %.3f us a batch\n", serialTime, batchTime * 1000.0f);
+	printf("  %u jobs:    %8.3f ms a frame\n", numJobs, splitTime);
+	printf("  speedup:    %8.2fx\n", splitTime > 0.0f ? serialTime / splitTime : 0.0f);
+
+	if (workerPool != NULL) {
+		printf("  dispatch:   %8.3f us a job, a job pays for itself from %.0f batches\n",
+			dispatchTime * 1000.0f, batchTime > 0.0f ? dispatchTime / batchTime : 0.0f);
+	}
+
+	printf("  same lists: %s\n", IsSameDrawList(serialPackets, packets) ? "yes" : "NO");
+
+	for (unsigned int i = 0; i < jobs.size(); ++i)
+		delete jobs[i];
+
+	delete workerPool;
+
+	return IsSameDrawList(serialPackets, packets) ? 0 : 1;
+}
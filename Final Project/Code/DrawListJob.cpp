@@ -0,0 +1,59 @@
+#include "DrawListJob.h"
+
+DrawListJob::DrawListJob (const DrawBuilder& drawBuilder)
+	: m_numCulled(0), m_allocations(0), m_drawBuilder(drawBuilder), m_batches(NULL), m_numBatches(0), m_parameterBlock(0), m_done(true)
+{
+}
+
+void DrawListJob::Start (const RenderBatch* const* batches, unsigned int numBatches, unsigned int parameterBlock) {
+	m_batches = batches;
+	m_numBatches = numBatches;
+	m_parameterBlock = parameterBlock;
+
+	m_done = false;
+}
+
+void DrawListJob::Run () {
+	m_cachedRenderBatches.clear();
+	m_packets.clear();
+	m_numCulled = 0;
+	m_allocations = 0;
+
+	// Room for every batch up front, so the lists only grow when the range does
+	m_allocations += m_cachedRenderBatches.capacity() < m_numBatches ? 1 : 0;
+	m_allocations += m_packets.capacity() < m_numBatches ? 1 : 0;
+	m_cachedRenderBatches.reserve(m_numBatches);
+	m_packets.reserve(m_numBatches);
+
+	for (unsigned int i = 0; i < m_numBatches; ++i) {
+		const RenderBatch& batch = *m_batches[i];
+
+		unsigned int lod;
+		float screenSize;
+		SortKey sortKey;
+
+		if (!m_drawBuilder.BuildDraw(batch, lod, screenSize, sortKey)) {
+			++m_numCulled;
+			continue;
+		}
+
+		DrawPacket packet;
+		packet.m_sortKey = sortKey;
+		packet.m_batch = m_cachedRenderBatches.size();
+
+		m_cachedRenderBatches.push_back(CachedRenderBatch(batch, m_parameterBlock, lod, screenSize));
+		m_packets.push_back(packet);
+	}
+
+	MutexLock lock(m_mutex);
+
+	m_done = true;
+	m_finished.Broadcast();
+}
+
+void DrawListJob::Wait () {
+	MutexLock lock(m_mutex);
+
+	while (!m_done)
+		m_finished.Wait(m_mutex);
+}
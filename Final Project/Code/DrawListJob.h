@@ -0,0 +1,64 @@
+#ifndef __DRAWLISTJOB_H__
+#define __DRAWLISTJOB_H__
+
+#include <vector>
+
+#include "CachedRenderBatch.h"
+#include "Mutex.h"
+#include "RenderQueue.h"
+#include "WorkerPool.h"
+
+// Decides a batch's draw, GraphicsManager in the game and a stand-in in the
+// drawlistbench target
+class DrawBuilder
+{
+public:
+	virtual ~DrawBuilder () {}
+
+	// Level of detail, screen size and sort key of a batch, false when it is
+	// culled.  Called from several threads at once.
+	virtual bool BuildDraw (const RenderBatch& batch, unsigned int& lod, float& screenSize, SortKey& sortKey) const = 0;
+};
+
+// Builds the draws of a range of a frame's batches into lists of its own, so
+// jobs never write to anything they share.  GraphicsManager merges the lists
+// of every range in order once they are done.
+class DrawListJob : public WorkerJob
+{
+public:
+	DrawListJob (const DrawBuilder& drawBuilder);
+
+	// The batches have to stay alive until Wait returns
+	void Start (const RenderBatch* const* batches, unsigned int numBatches, unsigned int parameterBlock);
+
+	// Run by a worker after Submit, or right away by the thread that called
+	// Start
+	virtual void Run ();
+
+	// Blocks until Run is done
+	void Wait ();
+
+	// Each packet's batch is an index into m_cachedRenderBatches.  Both keep
+	// their capacity between frames.
+	std::vector<CachedRenderBatch> m_cachedRenderBatches;
+	std::vector<DrawPacket> m_packets;
+
+	unsigned int m_numCulled;
+	unsigned int m_allocations;
+
+private:
+	DrawListJob (const DrawListJob&);
+	DrawListJob& operator= (const DrawListJob&);
+
+	const DrawBuilder& m_drawBuilder;
+
+	const RenderBatch* const* m_batches;
+	unsigned int m_numBatches;
+	unsigned int m_parameterBlock;
+
+	Mutex m_mutex;
+	Condition m_finished;
+	bool m_done;
+};
+
+#endif
@@ -1,14 +1,14 @@
 #ifndef __EFFECTPARAMETERS_H__
 #define __EFFECTPARAMETERS_H__
 
-#include <string>
-
 #include "mat.h"
 
+#include "AssetID.h"
+
 struct EffectParameters
 {
 	EffectParameters ()
-		: m_materialOpacity(1.0f), m_twoSided(0), m_HUDRender(0)
+		: m_materialOpacity(1.0f), m_twoSided(0), m_HUDRender(0), m_animationTime(0.0f)
 	{}
 
 	// Render Parameters
@@ -20,8 +20,8 @@ struct EffectParameters
 	float m_animationTime;
 
 	// Texture Channels
-	std::string m_diffuseTexture;
-	std::string m_normalMap;
+	AssetID m_diffuseTexture;
+	AssetID m_normalMap;
 
 	// Material Parameters
 	vec3 m_materialAmbient;
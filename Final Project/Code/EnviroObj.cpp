@@ -1,7 +1,9 @@
 #include "EnviroObj.h"
 
+#include "Random.h"
+
 EnviroObj::EnviroObj(objectType type, vec3 position, vec3 direction, float size)
-	: Object(position, direction, size, 0.f)
+	: Object(position, direction, size, 0.f), m_occluderWidth(0.0f), m_occluderHeight(0.0f)
 {
 	RenderBatch* batch = new RenderBatch();
 	if(type==TREE)
@@ -16,6 +18,12 @@ EnviroObj::EnviroObj(objectType type, vec3 position, vec3 direction, float size)
 		batch->m_effectParameters.m_normalMap = "none";
 
 		m_bbfactor = 0.6;
+
+		// Around the model's origin the trunk narrows from 0.49 at the ground
+		// to 0.27 at 4.0, below where the branches start at 4.5.  The box's
+		// corners are 0.21 out, inside however the model is turned.
+		m_occluderWidth = 0.15f;
+		m_occluderHeight = 4.0f;
 	}
 	if(type==LEAVES) 
 	{
@@ -42,6 +50,10 @@ EnviroObj::EnviroObj(objectType type, vec3 position, vec3 direction, float size)
 		batch->m_effectParameters.m_normalMap = "rockNormal";
 
 		m_bbfactor = 85.0;
+
+		// At least 120 from the center in every direction, half of it sunk
+		m_occluderWidth = 60.0f;
+		m_occluderHeight = 60.0f;
 	}
 	if(type==BUSH)
 	{
@@ -55,7 +67,7 @@ EnviroObj::EnviroObj(objectType type, vec3 position, vec3 direction, float size)
 			"fern4"
 		};
 
-		int type = rand() % c_num_plants;
+		int type = Random::Next() % c_num_plants;
 
 		batch->m_geometryID = plantTypes[type];
 		batch->m_effectParameters.m_materialAmbient = vec3(1.0f, 1.0f, 0.0f) * 0.5f;
@@ -74,4 +86,16 @@ EnviroObj::EnviroObj(objectType type, vec3 position, vec3 direction, float size)
 }
 
 EnviroObj::~EnviroObj() {
+}
+
+bool EnviroObj::getOccluder(vec3& minimum, vec3& maximum)
+{
+	if(m_occluderWidth <= 0.0f)
+		return false;
+
+	// Small enough that the corners stay inside however the model is turned
+	float halfWidth = m_occluderWidth * m_size;
+	minimum = vec3(m_position.x - halfWidth, m_position.y, m_position.z - halfWidth);
+	maximum = vec3(m_position.x + halfWidth, m_position.y + m_occluderHeight * m_size, m_position.z + halfWidth);
+	return true;
 }
\ No newline at end of file
@@ -9,6 +9,15 @@ class EnviroObj : public Object
 public:
 	EnviroObj(objectType type, vec3 position, vec3 direction, float size);
 	~EnviroObj();
+
+	// Box that is solid from every side, inside the trunk of a tree or the
+	// part of a rock above the ground.  False for objects without one.
+	bool getOccluder(vec3& minimum, vec3& maximum);
+
+private:
+	// In model units, the half width of the box and its height
+	float m_occluderWidth;
+	float m_occluderHeight;
 };
 
 
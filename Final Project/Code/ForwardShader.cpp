@@ -1,16 +1,16 @@
 #include "ForwardShader.h"
 
+#include <string.h>
+
 #include "Angel.h"
 
 #include "GraphicsSettings.h"
+#include "GLStateCache.h"
 #include "Vertex.h"
 
 ForwardShader::ForwardShader (const std::string& vertShader, const std::string& fragShader)
 	: UberShader(vertShader, fragShader)
 {
-	b_animatedGeometry = glGetUniformLocation(m_program, "b_animatedGeometry");
-	m_attributeLerp = glGetUniformLocation(m_program, "attributeLerp");
-
 	m_vPosition0 = glGetAttribLocation(m_program, "vPosition0");
 	m_vNormal0 = glGetAttribLocation(m_program, "vNormal0");
 	m_vTexCoord0 = glGetAttribLocation(m_program, "vTexCoord0");
@@ -19,99 +19,136 @@ ForwardShader::ForwardShader (const std::string& vertShader, const std::string&
 	m_vNormal1 = glGetAttribLocation(m_program, "vNormal1");
 	m_vTexCoord1 = glGetAttribLocation(m_program, "vTexCoord1");
 
-	m_projectionMatrix = glGetUniformLocation(m_program, "projectionMatrix");
-	m_modelviewMatrix = glGetUniformLocation(m_program, "modelviewMatrix");
+	m_instanceModelview = glGetAttribLocation(m_program, "instanceModelview");
+	m_instanceParameters = glGetAttribLocation(m_program, "instanceParameters");
 
-	b_useDiffuseTexture = glGetUniformLocation(m_program, "b_useDiffuseTexture");
-	b_useEnvironmentMap = glGetUniformLocation(m_program, "b_useEnvironmentMap");
-	b_useNormalMap = glGetUniformLocation(m_program, "b_useNormalMap");
+	glGenBuffers(1, &m_instanceBuffer);
 
-	m_eyePosition = glGetUniformLocation(m_program, "eyePosition");
+	BindUniformBlock("FrameUniforms", e_UniformBlockFrame);
+	BindUniformBlock("DrawUniforms", e_UniformBlockDraw);
 
-	m_lightDirection = glGetUniformLocation(m_program, "lightDirection");
-	m_lightCombinedAmbient = glGetUniformLocation(m_program, "lightCombinedAmbient");
-	m_lightCombinedDiffuse = glGetUniformLocation(m_program, "lightCombinedDiffuse");
-	m_lightCombinedSpecular = glGetUniformLocation(m_program, "lightCombinedSpecular");
-	m_materialSpecularExponent = glGetUniformLocation(m_program, "materialSpecularExponent");
-	m_materialGloss = glGetUniformLocation(m_program, "materialGloss");
-	m_materialOpacity = glGetUniformLocation(m_program, "materialOpacity");
+	glGenBuffers(1, &m_drawUniformBuffer);
+	GLStateCache::Get().BindBuffer(GL_UNIFORM_BUFFER, m_drawUniformBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(DrawUniforms), NULL, GL_STREAM_DRAW);
 
-	b_usePointLight = glGetUniformLocation(m_program, "b_usePointLight");
-	m_pointLightPosition = glGetUniformLocation(m_program, "pointLightPosition");
-	m_pointLightCombinedAmbient = glGetUniformLocation(m_program, "pointLightCombinedAmbient");
-	m_pointLightCombinedDiffuse = glGetUniformLocation(m_program, "pointLightCombinedDiffuse");
-	m_pointLightCombinedSpecular = glGetUniformLocation(m_program, "pointLightCombinedSpecular");
-	m_pointLightRange = glGetUniformLocation(m_program, "pointLightRange");
-	m_pointLightAttenuationMultiplier = glGetUniformLocation(m_program, "pointLightAttenuationMultiplier");
+	m_drawUniforms = DrawUniforms();
+	m_drawUniformsValid = false;
 
 	// bind samplers to texture units
 	glUniform1i(glGetUniformLocation(m_program, "diffuseTexture"), e_TextureChannelDiffuse - e_TextureChannelFirst);
+	glUniform1i(glGetUniformLocation(m_program, "diffuseArray"), e_TextureChannelDiffuseArray - e_TextureChannelFirst);
 	glUniform1i(glGetUniformLocation(m_program, "environmentMap"), e_TextureChannelEnvMap - e_TextureChannelFirst);
 	glUniform1i(glGetUniformLocation(m_program, "normalMap"), e_TextureChannelNormalMap - e_TextureChannelFirst);
-
-	ForwardShaderState state;
-	SetShaderState(&state);
 }
 
 ForwardShader::~ForwardShader () {
+	GLStateCache::Get().DeleteBuffer(m_instanceBuffer);
+	GLStateCache::Get().DeleteBuffer(m_drawUniformBuffer);
+}
 
+void ForwardShader::SetInstances (const ForwardInstance* instances, unsigned int numInstances) {
+	// Orphaning the old storage lets the driver keep it for draws in flight
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, numInstances * sizeof(ForwardInstance), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, numInstances * sizeof(ForwardInstance), instances);
 }
 
 void ForwardShader::SetShaderState (const ShaderState* shaderState) {
 	const ForwardShaderState* forwardShaderState = (ForwardShaderState*)shaderState;
+	const AttributeLocation& attributeLocation = forwardShaderState->m_attributeLocation;
+	GLStateCache& stateCache = GLStateCache::Get();
+
+	// Filled from scratch so it can be compared with the last upload.  Value
+	// initialization zeroes every scalar, the vectors and the matrix are set
+	// by their constructors and the struct has no padding between members.
+	DrawUniforms drawUniforms = DrawUniforms();
+	drawUniforms.m_padding[0] = drawUniforms.m_padding[1] = drawUniforms.m_padding[2] = 0;
+
+	drawUniforms.m_modelviewMatrix = forwardShaderState->m_modelviewMatrix;
+
+	drawUniforms.m_materialAmbient = vec4(forwardShaderState->m_materialAmbient, forwardShaderState->m_materialSpecularExponent);
+	drawUniforms.m_materialDiffuse = vec4(forwardShaderState->m_materialDiffuse, forwardShaderState->m_materialGloss);
+	drawUniforms.m_materialSpecular = vec4(forwardShaderState->m_materialSpecular, forwardShaderState->m_materialOpacity);
+
+	drawUniforms.b_packedGeometry = attributeLocation.m_vertexFormat == e_VertexFormatPacked ? 1 : 0;
 
-	glUniform1i(b_animatedGeometry, forwardShaderState->m_attributeLocation.m_animatedGeometry ? 1 : 0);
-
-	glUniformMatrix4fv(m_projectionMatrix, 1, GL_TRUE, (GLfloat*)&forwardShaderState->m_projectionMatrix);
-	glUniformMatrix4fv(m_modelviewMatrix, 1, GL_TRUE, (GLfloat*)&forwardShaderState->m_modelviewMatrix);
-
-	glUniform1i(b_useDiffuseTexture, forwardShaderState->b_useDiffuseTexture);
-	glUniform1i(b_useEnvironmentMap, forwardShaderState->b_useEnvironmentMap);
-	glUniform1i(b_useNormalMap, forwardShaderState->b_useNormalMap);
-
-	glUniform3fv(m_eyePosition, 1, forwardShaderState->m_eyePosition);
-
-	glUniform3fv(m_lightDirection, 1, forwardShaderState->m_lightDirection);
-	glUniform3fv(m_lightCombinedAmbient, 1, forwardShaderState->m_lightCombinedAmbient);
-	glUniform3fv(m_lightCombinedDiffuse, 1, forwardShaderState->m_lightCombinedDiffuse);
-	glUniform3fv(m_lightCombinedSpecular, 1, forwardShaderState->m_lightCombinedSpecular);
-	glUniform1f(m_materialSpecularExponent, forwardShaderState->m_materialSpecularExponent);
-	glUniform1f(m_materialGloss, forwardShaderState->m_materialGloss);
-	glUniform1f(m_materialOpacity, forwardShaderState->m_materialOpacity);
-
-	glUniform1iv(b_usePointLight, c_num_point_lights, forwardShaderState->b_usePointLight);
-	glUniform3fv(m_pointLightPosition, c_num_point_lights, (GLfloat*)forwardShaderState->m_pointLightPosition);
-	glUniform3fv(m_pointLightCombinedAmbient, c_num_point_lights, (GLfloat*)forwardShaderState->m_pointLightCombinedAmbient);
-	glUniform3fv(m_pointLightCombinedDiffuse, c_num_point_lights, (GLfloat*)forwardShaderState->m_pointLightCombinedDiffuse);
-	glUniform3fv(m_pointLightCombinedSpecular, c_num_point_lights, (GLfloat*)forwardShaderState->m_pointLightCombinedSpecular);
-	glUniform1fv(m_pointLightRange, c_num_point_lights, forwardShaderState->m_pointLightRange);
-	glUniform1fv(m_pointLightAttenuationMultiplier, c_num_point_lights, forwardShaderState->m_pointLightAttenuationMultiplier);
-
-    glEnableVertexAttribArray(m_vPosition0);
-	glVertexAttribPointer(m_vPosition0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), BUFFER_OFFSET(forwardShaderState->m_attributeLocation.m_position0));
-		
-	glEnableVertexAttribArray(m_vNormal0);
-	glVertexAttribPointer(m_vNormal0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), BUFFER_OFFSET(forwardShaderState->m_attributeLocation.m_normal0));
-		
-	glEnableVertexAttribArray(m_vTexCoord0);
-	glVertexAttribPointer(m_vTexCoord0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), BUFFER_OFFSET(forwardShaderState->m_attributeLocation.m_texCoord0));
-
-	if (forwardShaderState->m_attributeLocation.m_animatedGeometry) {
-		glEnableVertexAttribArray(m_vPosition1);
-		glVertexAttribPointer(m_vPosition1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), BUFFER_OFFSET(forwardShaderState->m_attributeLocation.m_position1));
-
-		glEnableVertexAttribArray(m_vNormal1);
-		glVertexAttribPointer(m_vNormal1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), BUFFER_OFFSET(forwardShaderState->m_attributeLocation.m_normal1));
-				
-		glEnableVertexAttribArray(m_vTexCoord1);
-		glVertexAttribPointer(m_vTexCoord1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), BUFFER_OFFSET(forwardShaderState->m_attributeLocation.m_texCoord1));
-
-		glUniform1f(m_attributeLerp, forwardShaderState->m_attributeLerp);
+	if (attributeLocation.m_vertexFormat == e_VertexFormatPacked) {
+		const VertexDecode& vertexDecode = attributeLocation.m_vertexDecode;
+
+		drawUniforms.m_positionScale = vec4(vertexDecode.m_positionScale, 0.0f);
+		drawUniforms.m_positionBias = vec4(vertexDecode.m_positionBias, 0.0f);
+		drawUniforms.m_texCoordScaleBias = vec4(vertexDecode.m_texCoordScale.x, vertexDecode.m_texCoordScale.y, vertexDecode.m_texCoordBias.x, vertexDecode.m_texCoordBias.y);
+	}
+
+	drawUniforms.m_attributeLerp = forwardShaderState->m_attributeLerp;
+	drawUniforms.m_diffuseLayer = forwardShaderState->m_diffuseLayer;
+	drawUniforms.b_animatedGeometry = attributeLocation.m_animatedGeometry ? 1 : 0;
+
+	drawUniforms.b_useDiffuseTexture = forwardShaderState->b_useDiffuseTexture;
+	drawUniforms.b_useDiffuseArray = forwardShaderState->b_useDiffuseArray;
+	drawUniforms.b_useEnvironmentMap = forwardShaderState->b_useEnvironmentMap;
+	drawUniforms.b_useNormalMap = forwardShaderState->b_useNormalMap;
+
+	drawUniforms.b_instanced = forwardShaderState->b_instanced;
+
+	// Orphaned like the instance buffer, the previous draw may still read it.
+	// Runs of the same batch, like the HUD's, skip the upload.
+	if (m_drawUniformsValid && memcmp(&drawUniforms, &m_drawUniforms, sizeof(DrawUniforms)) == 0) {
+		stateCache.CountElided();
 	}
 	else {
-		glDisableVertexAttribArray(m_vPosition1);
-		glDisableVertexAttribArray(m_vNormal1);
+		stateCache.BindBuffer(GL_UNIFORM_BUFFER, m_drawUniformBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(DrawUniforms), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(DrawUniforms), &drawUniforms);
+		stateCache.CountIssued();
+
+		m_drawUniforms = drawUniforms;
+		m_drawUniformsValid = true;
 	}
 
-	m_currentState = *forwardShaderState;
+	stateCache.BindBufferBase(GL_UNIFORM_BUFFER, e_UniformBlockDraw, m_drawUniformBuffer);
+
+	SetAttributePointers(m_vPosition0, m_vNormal0, m_vTexCoord0, attributeLocation.m_vertexBuffer,
+		attributeLocation.m_position0, attributeLocation.m_normal0, attributeLocation.m_texCoord0, attributeLocation.m_vertexFormat);
+
+	if (attributeLocation.m_animatedGeometry) {
+		SetAttributePointers(m_vPosition1, m_vNormal1, m_vTexCoord1, attributeLocation.m_vertexBuffer,
+			attributeLocation.m_position1, attributeLocation.m_normal1, attributeLocation.m_texCoord1, attributeLocation.m_vertexFormat);
+	}
+	else {
+		stateCache.SetVertexAttribArray(m_vPosition1, false);
+		stateCache.SetVertexAttribArray(m_vNormal1, false);
+	}
+
+	// A mat4 attribute takes four consecutive locations, one per column
+	for (unsigned int i = 0; i < 5; ++i) {
+		GLuint location = i < 4 ? m_instanceModelview + i : m_instanceParameters;
+
+		stateCache.SetVertexAttribArray(location, forwardShaderState->b_instanced != 0);
+
+		if (forwardShaderState->b_instanced) {
+			stateCache.SetVertexAttribPointer(location, m_instanceBuffer, 4, GL_FLOAT, GL_FALSE, sizeof(ForwardInstance), i * sizeof(vec4));
+			stateCache.SetVertexAttribDivisor(location, 1);
+		}
+	}
+}
+
+void ForwardShader::SetAttributePointers (GLuint vPosition, GLuint vNormal, GLuint vTexCoord, GLuint vertexBuffer, GLuint position, GLuint normal, GLuint texCoord, VertexFormat vertexFormat) {
+	GLStateCache& stateCache = GLStateCache::Get();
+
+	stateCache.SetVertexAttribArray(vPosition, true);
+	stateCache.SetVertexAttribArray(vNormal, true);
+	stateCache.SetVertexAttribArray(vTexCoord, true);
+
+	if (vertexFormat == e_VertexFormatPacked) {
+		// Normalized integers, forwardVert applies the geometry's decode
+		stateCache.SetVertexAttribPointer(vPosition, vertexBuffer, 4, GL_SHORT, GL_TRUE, sizeof(PackedVertex), position);
+		stateCache.SetVertexAttribPointer(vNormal, vertexBuffer, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), normal);
+		stateCache.SetVertexAttribPointer(vTexCoord, vertexBuffer, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), texCoord);
+	}
+	else {
+		stateCache.SetVertexAttribPointer(vPosition, vertexBuffer, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), position);
+		stateCache.SetVertexAttribPointer(vNormal, vertexBuffer, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), normal);
+		stateCache.SetVertexAttribPointer(vTexCoord, vertexBuffer, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), texCoord);
+	}
 }
\ No newline at end of file
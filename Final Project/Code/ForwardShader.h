@@ -5,6 +5,7 @@
 
 #include "UberShader.h"
 #include "ForwardShaderState.h"
+#include "UniformBlocks.h"
 
 class ForwardShader : public UberShader
 {
@@ -14,9 +15,11 @@ public:
 
 	void SetShaderState (const ShaderState* shaderState);
 
+	// Fills the instance buffer, the next state with b_instanced draws from it
+	void SetInstances (const ForwardInstance* instances, unsigned int numInstances);
+
 private:	
-	GLuint b_animatedGeometry;
-	GLuint m_attributeLerp;
+	void SetAttributePointers (GLuint vPosition, GLuint vNormal, GLuint vTexCoord, GLuint vertexBuffer, GLuint position, GLuint normal, GLuint texCoord, VertexFormat vertexFormat);
 
 	GLuint m_vPosition0;
 	GLuint m_vNormal0;
@@ -26,32 +29,16 @@ private:
 	GLuint m_vNormal1;
 	GLuint m_vTexCoord1;
 
-	GLuint m_projectionMatrix;
-	GLuint m_modelviewMatrix;
-
-	GLuint b_useDiffuseTexture;
-	GLuint b_useEnvironmentMap;
-	GLuint b_useNormalMap;
-
-	GLuint m_eyePosition;
-
-	GLuint m_lightDirection;
-	GLuint m_lightCombinedAmbient;
-	GLuint m_lightCombinedDiffuse;
-	GLuint m_lightCombinedSpecular;
-	GLuint m_materialSpecularExponent;
-	GLuint m_materialGloss;
-	GLuint m_materialOpacity;
-
-	GLuint b_usePointLight;
-	GLuint m_pointLightPosition;
-	GLuint m_pointLightCombinedAmbient;
-	GLuint m_pointLightCombinedDiffuse;
-	GLuint m_pointLightCombinedSpecular;
-	GLuint m_pointLightRange;
-	GLuint m_pointLightAttenuationMultiplier;
+	GLuint m_instanceModelview;
+	GLuint m_instanceParameters;
+	GLuint m_instanceBuffer;
 
-	ForwardShaderState m_currentState;
+	// Everything else the shaders read comes from the frame block and this
+	// one, uploaded by the draws that change it.  m_drawUniforms is what it
+	// holds.
+	GLuint m_drawUniformBuffer;
+	DrawUniforms m_drawUniforms;
+	bool m_drawUniformsValid;
 };
 
 #endif
\ No newline at end of file
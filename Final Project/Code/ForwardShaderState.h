@@ -7,33 +7,32 @@
 
 #include "GraphicsSettings.h"
 
+// Values of one instance of an instanced draw, laid out the way forwardVert
+// reads them: the modelview matrix a column at a time, then attributeLerp,
+// diffuse layer, opacity and gloss
+struct ForwardInstance
+{
+	mat4 m_modelviewMatrix;
+	vec4 m_parameters;
+};
+
+// The per draw values, the camera and lights are in the frame uniforms and
+// the shaders combine them with the material
 struct ForwardShaderState : public ShaderState
 {
-	void HandleShaderFlags (std::vector<std::string> shaderFlags);
+	void HandleShaderFlags (const std::vector<std::string>& shaderFlags);
 	void CalculateShaderState (const RenderParameters& renderParameters, const EffectParameters& effectParameters);
 
 	float m_attributeLerp;
 
-	mat4 m_projectionMatrix;
 	mat4 m_modelviewMatrix;
 
-	vec3 m_eyePosition;
-
-	vec3 m_lightDirection;
-	vec3 m_lightCombinedAmbient;
-	vec3 m_lightCombinedDiffuse;
-	vec3 m_lightCombinedSpecular;
+	vec3 m_materialAmbient;
+	vec3 m_materialDiffuse;
+	vec3 m_materialSpecular;
 	float m_materialSpecularExponent;
 	float m_materialGloss;
 	float m_materialOpacity;
-
-	static_branch b_usePointLight[c_num_point_lights];
-	vec3 m_pointLightPosition[c_num_point_lights];
-	vec3 m_pointLightCombinedAmbient[c_num_point_lights];
-	vec3 m_pointLightCombinedDiffuse[c_num_point_lights];
-	vec3 m_pointLightCombinedSpecular[c_num_point_lights];
-	float m_pointLightRange[c_num_point_lights];
-	float m_pointLightAttenuationMultiplier[c_num_point_lights];
 };
 
 #endif
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "FrameBufferTexture.h"
 
+#include "GLStateCache.h"
+#include "GraphicsSettings.h"
+
 FrameBufferTexture::FrameBufferTexture (const std::string& format, unsigned int width, unsigned int height) 
 	: m_bufferTextureWidth(width), m_bufferTextureHeight(height)
 {
@@ -21,15 +24,24 @@ FrameBufferTexture::FrameBufferTexture (const std::string& format, unsigned int
 	}
 
 	glGenTextures(1, &m_bufferTextureID); 
-	glBindTexture(GL_TEXTURE_2D, m_bufferTextureID);
+	GLStateCache::Get().BindTexture(e_TextureChannelDiffuse, GL_TEXTURE_2D, m_bufferTextureID);
 	glTexImage2D(GL_TEXTURE_2D, 0, textureFormat, width, height, 0, pixelFormat, GL_UNSIGNED_BYTE, NULL); 
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);  
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);  
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::Get().BindTexture(e_TextureChannelDiffuse, GL_TEXTURE_2D, 0);
 }
 
 FrameBufferTexture::~FrameBufferTexture () {
-	 glDeleteTextures(1, &m_bufferTextureID);
+	 GLStateCache::Get().DeleteTexture(m_bufferTextureID);
+}
+
+unsigned int FrameBufferTexture::GetBytesPerPixel (const std::string& format) {
+	if (format == "DEPTHCOMPONENT")
+		return 4;
+	else if (format == "RGB16F")
+		return 6;
+	else
+		return 0;
 }
\ No newline at end of file
@@ -16,6 +16,11 @@ public:
 	unsigned int GetBufferTextureWidth () const { return m_bufferTextureWidth; }
 	unsigned int GetBufferTextureHeight () const { return m_bufferTextureHeight; }
 
+	// Of the formats a buffer can have, 0 for any other.  Drivers may pad
+	// the pixels, so this is a lower bound on the memory a texture takes.
+	static unsigned int GetBytesPerPixel (const std::string& format);
+	static bool IsDepthFormat (const std::string& format) { return format == "DEPTHCOMPONENT"; }
+
 private:
 	GLuint m_bufferTextureID;
 
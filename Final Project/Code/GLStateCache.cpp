@@ -0,0 +1,221 @@
+#include "GLStateCache.h"
+
+#include <string.h>
+
+// No GL name or value the cache stores comes close to this
+static const unsigned int c_state_unknown = ~0u;
+
+GLStateCache::GLStateCache ()
+	: m_issued(0), m_elided(0)
+{
+	Invalidate();
+}
+
+void GLStateCache::Invalidate () {
+	memset(m_capabilities, 0xff, sizeof(m_capabilities));
+	m_depthMask = c_state_unknown;
+
+	m_program = c_state_unknown;
+	m_framebuffer = c_state_unknown;
+
+	m_activeTexture = c_state_unknown;
+	memset(m_textures, 0xff, sizeof(m_textures));
+
+	memset(m_buffers, 0xff, sizeof(m_buffers));
+	memset(m_uniformBindings, 0xff, sizeof(m_uniformBindings));
+
+	memset(m_vertexAttribs, 0xff, sizeof(m_vertexAttribs));
+}
+
+bool GLStateCache::Update (unsigned int& cached, unsigned int value) {
+	if (cached == value) {
+		++m_elided;
+		return false;
+	}
+
+	cached = value;
+	++m_issued;
+	return true;
+}
+
+int GLStateCache::GetCapabilitySlot (GLenum capability) {
+	switch (capability) {
+		case GL_CULL_FACE: return e_CapabilityCullFace;
+		case GL_DEPTH_TEST: return e_CapabilityDepthTest;
+		case GL_BLEND: return e_CapabilityBlend;
+		case GL_ALPHA_TEST: return e_CapabilityAlphaTest;
+	}
+
+	return -1;
+}
+
+int GLStateCache::GetTextureTargetSlot (GLenum target) {
+	switch (target) {
+		case GL_TEXTURE_2D: return e_TextureTarget2d;
+		case GL_TEXTURE_CUBE_MAP: return e_TextureTargetCube;
+		case GL_TEXTURE_2D_ARRAY: return e_TextureTarget2dArray;
+	}
+
+	return -1;
+}
+
+int GLStateCache::GetBufferTargetSlot (GLenum target) {
+	switch (target) {
+		case GL_ARRAY_BUFFER: return e_BufferTargetArray;
+		case GL_ELEMENT_ARRAY_BUFFER: return e_BufferTargetElementArray;
+		case GL_UNIFORM_BUFFER: return e_BufferTargetUniform;
+	}
+
+	return -1;
+}
+
+void GLStateCache::SetCapability (GLenum capability, bool enabled) {
+	int slot = GetCapabilitySlot(capability);
+
+	if (slot < 0)
+		++m_issued;
+	else if (!Update(m_capabilities[slot], enabled ? 1 : 0))
+		return;
+
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+}
+
+void GLStateCache::SetDepthMask (bool depthMask) {
+	if (Update(m_depthMask, depthMask ? 1 : 0))
+		glDepthMask(depthMask);
+}
+
+void GLStateCache::UseProgram (GLuint program) {
+	if (Update(m_program, program))
+		glUseProgram(program);
+}
+
+void GLStateCache::BindFramebuffer (GLuint framebuffer) {
+	if (Update(m_framebuffer, framebuffer))
+		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, framebuffer);
+}
+
+void GLStateCache::BindTexture (GLenum unit, GLenum target, GLuint texture) {
+	unsigned int unitIndex = unit - GL_TEXTURE0;
+	int slot = GetTextureTargetSlot(target);
+
+	if (unitIndex >= c_max_texture_units || slot < 0)
+		++m_issued;
+	else if (!Update(m_textures[unitIndex][slot], texture))
+		return;
+
+	if (Update(m_activeTexture, unit))
+		glActiveTexture(unit);
+
+	glBindTexture(target, texture);
+}
+
+void GLStateCache::BindBuffer (GLenum target, GLuint buffer) {
+	int slot = GetBufferTargetSlot(target);
+
+	if (slot < 0)
+		++m_issued;
+	else if (!Update(m_buffers[slot], buffer))
+		return;
+
+	glBindBuffer(target, buffer);
+}
+
+void GLStateCache::BindBufferBase (GLenum target, GLuint index, GLuint buffer) {
+	if (target != GL_UNIFORM_BUFFER || index >= c_max_uniform_bindings)
+		++m_issued;
+	else if (!Update(m_uniformBindings[index], buffer))
+		return;
+
+	glBindBufferBase(target, index, buffer);
+
+	int slot = GetBufferTargetSlot(target);
+	if (slot >= 0)
+		m_buffers[slot] = buffer;
+}
+
+void GLStateCache::DeleteTexture (GLuint texture) {
+	for (unsigned int i = 0; i < c_max_texture_units; ++i) {
+		for (unsigned int j = 0; j < e_TextureTargetCount; ++j) {
+			if (m_textures[i][j] == texture)
+				m_textures[i][j] = c_state_unknown;
+		}
+	}
+
+	glDeleteTextures(1, &texture);
+}
+
+void GLStateCache::DeleteBuffer (GLuint buffer) {
+	for (unsigned int i = 0; i < e_BufferTargetCount; ++i) {
+		if (m_buffers[i] == buffer)
+			m_buffers[i] = c_state_unknown;
+	}
+
+	for (unsigned int i = 0; i < c_max_uniform_bindings; ++i) {
+		if (m_uniformBindings[i] == buffer)
+			m_uniformBindings[i] = c_state_unknown;
+	}
+
+	for (unsigned int i = 0; i < c_max_vertex_attribs; ++i) {
+		if (m_vertexAttribs[i].m_buffer == buffer)
+			m_vertexAttribs[i].m_buffer = c_state_unknown;
+	}
+
+	glDeleteBuffers(1, &buffer);
+}
+
+void GLStateCache::DeleteFramebuffer (GLuint framebuffer) {
+	if (m_framebuffer == framebuffer)
+		m_framebuffer = c_state_unknown;
+
+	glDeleteFramebuffers(1, &framebuffer);
+}
+
+void GLStateCache::SetVertexAttribArray (GLuint index, bool enabled) {
+	// Locations of attributes the program doesn't use are -1
+	if (index >= c_max_vertex_attribs)
+		return;
+
+	if (!Update(m_vertexAttribs[index].m_enabled, enabled ? 1 : 0))
+		return;
+
+	if (enabled)
+		glEnableVertexAttribArray(index);
+	else
+		glDisableVertexAttribArray(index);
+}
+
+void GLStateCache::SetVertexAttribPointer (GLuint index, GLuint buffer, GLint size, GLenum type, GLboolean normalized, GLsizei stride, unsigned int offset) {
+	if (index >= c_max_vertex_attribs)
+		return;
+
+	VertexAttrib& attrib = m_vertexAttribs[index];
+
+	if (attrib.m_buffer == buffer && attrib.m_size == (unsigned int)size && attrib.m_type == type &&
+		attrib.m_normalized == normalized && attrib.m_stride == (unsigned int)stride && attrib.m_offset == offset) {
+		++m_elided;
+		return;
+	}
+
+	BindBuffer(GL_ARRAY_BUFFER, buffer);
+	glVertexAttribPointer(index, size, type, normalized, stride, BUFFER_OFFSET(offset));
+	++m_issued;
+
+	attrib.m_buffer = buffer;
+	attrib.m_size = size;
+	attrib.m_type = type;
+	attrib.m_normalized = normalized;
+	attrib.m_stride = stride;
+	attrib.m_offset = offset;
+}
+
+void GLStateCache::SetVertexAttribDivisor (GLuint index, GLuint divisor) {
+	if (index >= c_max_vertex_attribs)
+		return;
+
+	if (Update(m_vertexAttribs[index].m_divisor, divisor))
+		glVertexAttribDivisor(index, divisor);
+}
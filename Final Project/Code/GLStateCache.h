@@ -0,0 +1,108 @@
+#ifndef __GLSTATECACHE_H__
+#define __GLSTATECACHE_H__
+
+#include "Angel.h"
+
+// Shadow of the GL state the renderer changes between draws.  Every setter
+// compares against the value it last applied and only calls GL when that
+// differs, counting the calls it issued and the ones it elided.  The shadow
+// only holds while each change goes through here, asset loading and texture
+// streaming included, and after code that sets the same state directly it has
+// to be invalidated.
+class GLStateCache
+{
+public:
+	static GLStateCache& Get () {
+		static GLStateCache s;
+		return s;
+	}
+
+	// Forgets every value, the next call of each setter is issued
+	void Invalidate ();
+
+	// GL_CULL_FACE, GL_DEPTH_TEST, GL_BLEND and GL_ALPHA_TEST are shadowed,
+	// anything else is passed straight through
+	void SetCapability (GLenum capability, bool enabled);
+	void SetDepthMask (bool depthMask);
+
+	void UseProgram (GLuint program);
+	void BindFramebuffer (GLuint framebuffer);
+
+	// unit is a TextureChannel, the active unit only changes for a bind that
+	// is issued
+	void BindTexture (GLenum unit, GLenum target, GLuint texture);
+
+	void BindBuffer (GLenum target, GLuint buffer);
+
+	// Also binds the buffer to target's generic binding, like GL does
+	void BindBufferBase (GLenum target, GLuint index, GLuint buffer);
+
+	// GL unbinds a name it deletes and can hand the name out again, so names
+	// are deleted through here to forget every binding of them
+	void DeleteTexture (GLuint texture);
+	void DeleteBuffer (GLuint buffer);
+	void DeleteFramebuffer (GLuint framebuffer);
+
+	// The pointer reads from buffer, which is bound to GL_ARRAY_BUFFER first
+	// when the pointer is issued
+	void SetVertexAttribArray (GLuint index, bool enabled);
+	void SetVertexAttribPointer (GLuint index, GLuint buffer, GLint size, GLenum type, GLboolean normalized, GLsizei stride, unsigned int offset);
+	void SetVertexAttribDivisor (GLuint index, GLuint divisor);
+
+	// For state callers shadow themselves, like the uniforms of a program
+	void CountIssued () { ++m_issued; }
+	void CountElided () { ++m_elided; }
+
+	unsigned int GetIssued () const { return m_issued; }
+	unsigned int GetElided () const { return m_elided; }
+	void ResetCounters () { m_issued = 0; m_elided = 0; }
+
+private:
+	GLStateCache ();
+
+	// Index into the shadow arrays, -1 for values that aren't shadowed
+	static int GetCapabilitySlot (GLenum capability);
+	static int GetTextureTargetSlot (GLenum target);
+	static int GetBufferTargetSlot (GLenum target);
+
+	// Counts the call and stores value, true when it has to be issued
+	bool Update (unsigned int& cached, unsigned int value);
+
+	enum { c_max_texture_units = 8, c_max_vertex_attribs = 16, c_max_uniform_bindings = 4 };
+	enum { e_CapabilityCullFace, e_CapabilityDepthTest, e_CapabilityBlend, e_CapabilityAlphaTest, e_CapabilityCount };
+	enum { e_TextureTarget2d, e_TextureTargetCube, e_TextureTarget2dArray, e_TextureTargetCount };
+	enum { e_BufferTargetArray, e_BufferTargetElementArray, e_BufferTargetUniform, e_BufferTargetCount };
+
+	struct VertexAttrib
+	{
+		unsigned int m_enabled;
+		unsigned int m_divisor;
+
+		unsigned int m_buffer;
+		unsigned int m_size;
+		unsigned int m_type;
+		unsigned int m_normalized;
+		unsigned int m_stride;
+		unsigned int m_offset;
+	};
+
+	// Every value is an unsigned int so Invalidate can mark them all unknown
+	unsigned int m_capabilities[e_CapabilityCount];
+	unsigned int m_depthMask;
+
+	unsigned int m_program;
+	unsigned int m_framebuffer;
+
+	unsigned int m_activeTexture;
+	unsigned int m_textures[c_max_texture_units][e_TextureTargetCount];
+
+	unsigned int m_buffers[e_BufferTargetCount];
+	unsigned int m_uniformBindings[c_max_uniform_bindings];
+
+	VertexAttrib m_vertexAttribs[c_max_vertex_attribs];
+
+	unsigned int m_issued;
+	unsigned int m_elided;
+};
+
+#endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "GameManager.h"
+#include "Random.h"
 #include <ctime>
 #include <vector>
 
@@ -10,9 +11,19 @@ GameManager::GameManager()
 	m_w=m_a=m_s=m_d=m_j=m_l=m_auto=m_godmode=m_pause=m_mute = false;
 	angle = 0.0f;
 	m_score = m_god = 0;
+#ifndef HEADLESS
 	m_bulletchannel = m_monschannel = m_bgchannel = 0;
+#endif
 	m_timer = NULL;
 	m_timeOfDay = 0.0f;
+	m_flashTimer = 0.0f;
+	m_monsterCap = MONSTERCAP;
+	m_playerLives = 5;
+	m_player = NULL;
+	m_ground = NULL;
+	m_graphicsManager = NULL;
+	m_seed = (unsigned)time(0);
+	m_inputLog = NULL;
 }
 
 GameManager::~GameManager()
@@ -25,8 +36,10 @@ GameManager::~GameManager()
 	if(m_player)
 		delete m_player;
 
+#ifndef HEADLESS
 	if(m_graphicsManager)
 		delete m_graphicsManager;
+#endif
 
 	// vector::clear should delete all objects within
 	m_monsters.clear();
@@ -34,18 +47,26 @@ GameManager::~GameManager()
 	m_enviro.clear();
 	m_bgenviro.clear();
 
-	
+	if(m_inputLog)
+		delete m_inputLog;
 }
 
 void GameManager::callbackKeyboard(unsigned char key, int x, int y)
 {
+	// The log drives the simulation during a replay, only keys that don't
+	// touch it get through
+	if(m_inputLog && m_inputLog->IsReplaying() && key != 27 && key != '`' && key != 'm' && key != 'M')
+		return;
+
 	switch (key) {
 	case 27:	// esc
 		exit(0);
 		break;
+#ifndef HEADLESS
 	case '`':
 		m_graphicsManager->ReloadAssets();
 		break;
+#endif
 	case ' ':
 		m_auto = !m_auto; break;
 	case 'w':
@@ -69,7 +90,10 @@ void GameManager::callbackKeyboard(unsigned char key, int x, int y)
 	case 'm':
 	case 'M':
 		m_mute = !m_mute;
-		m_bgchannel->setMute(m_mute); break;
+#ifndef HEADLESS
+		m_bgchannel->setMute(m_mute);
+#endif
+		break;
 	case 'p':
 	case 'P':
 		if(m_player->getLives() > 0)	m_pause = !m_pause;	break;
@@ -82,6 +106,9 @@ void GameManager::callbackKeyboard(unsigned char key, int x, int y)
 
 void GameManager::callbackKeyUp(unsigned char key, int x, int y)
 {
+	if(m_inputLog && m_inputLog->IsReplaying())
+		return;
+
 	switch(key) {
 	case 'w':
 		m_w = false; break;
@@ -141,12 +168,82 @@ void GameManager::keyboardUpdate()
 	m_player->getBoundingBox()->rotate((m_l-m_j)*(0.05/DegreesToRadians));
 }
 
+bool GameManager::RecordInput(const std::string& fileName, float delta)
+{
+	if(m_inputLog)
+		delete m_inputLog;
+	m_inputLog = new InputLog();
+
+	return m_inputLog->OpenRecord(fileName, delta);
+}
+
+bool GameManager::ReplayInput(const std::string& fileName)
+{
+	if(m_inputLog)
+		delete m_inputLog;
+	m_inputLog = new InputLog();
+
+	if(!m_inputLog->OpenReplay(fileName))
+		return false;
+
+	m_seed = m_inputLog->GetSeed();
+	return true;
+}
+
+bool GameManager::IsReplayFinished()
+{
+	return m_inputLog == NULL || !m_inputLog->IsReplaying();
+}
+
+// Feeds the key state of this tick from the replay log, or appends the live
+// key state to the record log.  Runs once per tick before keyboardUpdate().
+void GameManager::inputLogUpdate()
+{
+	if(m_inputLog == NULL)
+		return;
+
+	if(m_inputLog->IsRecording())
+	{
+		unsigned char keys = 0;
+		if(m_w) keys |= e_InputKeyW;
+		if(m_a) keys |= e_InputKeyA;
+		if(m_s) keys |= e_InputKeyS;
+		if(m_d) keys |= e_InputKeyD;
+		if(m_j) keys |= e_InputKeyJ;
+		if(m_l) keys |= e_InputKeyL;
+		if(m_auto) keys |= e_InputKeyAuto;
+		if(m_pause) keys |= e_InputKeyPause;
+		m_inputLog->Record(keys);
+
+		// The window's frame time would make the recording unrepeatable
+		m_delta = m_inputLog->GetDelta();
+	}
+	else
+	{
+		unsigned char keys;
+		if(!m_inputLog->Replay(keys))
+			return;
+		// Replays run at the fixed tick length they were recorded for
+		m_delta = m_inputLog->GetDelta();
+		m_w = (keys & e_InputKeyW) != 0;
+		m_a = (keys & e_InputKeyA) != 0;
+		m_s = (keys & e_InputKeyS) != 0;
+		m_d = (keys & e_InputKeyD) != 0;
+		m_j = (keys & e_InputKeyJ) != 0;
+		m_l = (keys & e_InputKeyL) != 0;
+		m_auto = (keys & e_InputKeyAuto) != 0;
+		m_pause = (keys & e_InputKeyPause) != 0;
+	}
+}
+
 void GameManager::ResetGame()
 {
 	m_w=m_a=m_s=m_d=m_j=m_l=m_auto=m_godmode=m_pause = false;
 	angle = 0.0f;
 	m_score = m_god = 0;
+#ifndef HEADLESS
 	m_bulletchannel = m_monschannel = m_bgchannel = m_fxchannel = 0;
+#endif
 	m_timeOfDay = 0.0f;
 
 	// need to delete all monsters, bullets, enviro, bgenviro, m_ground, m_graphicsmanagers, m_system;
@@ -157,13 +254,21 @@ void GameManager::ResetGame()
 	if(m_player)
 		delete m_player;
 
+#ifndef HEADLESS
 	if(m_graphicsManager)
 		delete m_graphicsManager;
+#endif
 
 	if(m_timer)
 		delete m_timer;
 	m_timer = NULL;
 
+	// A recorded or replayed session ends with the game it was started for
+	if(m_inputLog)
+		delete m_inputLog;
+	m_inputLog = NULL;
+	m_seed = (unsigned)time(0);
+
 	// vector::clear should delete all objects within
 	// No it doesnt.  Memory leak all the things!
 	m_monsters.clear();
@@ -172,12 +277,15 @@ void GameManager::ResetGame()
 	m_bgenviro.clear();
 	m_walls.clear();
 
+#ifndef HEADLESS
 	m_system->close();
+#endif
 
 
 	initGame();
 }
 
+#ifndef HEADLESS
 void GameManager::initParameters()
 {
 	RenderParameters& renderParameters = m_graphicsManager->GetRenderParameters();
@@ -257,6 +365,7 @@ void GameManager::updateLighting() {
 	}
 
 }
+#endif
 
 void GameManager::initEnviro() // gotta wait for implementation of EnviroObj & Ground
 {
@@ -283,15 +392,17 @@ void GameManager::initEnviro() // gotta wait for implementation of EnviroObj & G
 		m_walls.at(i)->Update(0.f);
 
 	float x, z;
-	srand((unsigned)time(0));
+	Random::Seed(m_seed);
+	if(m_inputLog)
+		m_inputLog->SetSeed(m_seed);
 	for(int i=1;i<=16;i++)
 	{
 		do
 		{
 			do
 			{
-				x = -400+ 50*i - rand()%50;
-				z = 300 - rand()%600;
+				x = -400+ 50*i - Random::Next()%50;
+				z = 300 - Random::Next()%600;
 			} while((x < 4 && x > -4) && (z < 4 && z > -4));
 			Spawn(BUSH,Angel::vec3(x,0.0f,z),2);
 		} while(m_bgenviro.size() < 500*i);
@@ -301,8 +412,8 @@ void GameManager::initEnviro() // gotta wait for implementation of EnviroObj & G
 	{
 		do
 		{
-			x = 400 - rand()%800;
-			z = 300 - rand()%600;
+			x = 400 - Random::Next()%800;
+			z = 300 - Random::Next()%600;
 		} while((x < 4 && x > -4) && (z < 4 && z > -4));
 		Spawn(LEAVES,Angel::vec3(x,0.0f,z),1.7);
 		Spawn(TREE,Angel::vec3(x,0.0f,z),1.7);
@@ -312,8 +423,8 @@ void GameManager::initEnviro() // gotta wait for implementation of EnviroObj & G
 	{
 		do
 		{
-			x = 400 - rand()%800;
-			z = 300 - rand()%600;
+			x = 400 - Random::Next()%800;
+			z = 300 - Random::Next()%600;
 		} while((x < 4 && x > -4) && (z < 4 && z > -4));
 		Spawn(ROCK,Angel::vec3(x,0.0f,z),0.015);
 	} while(m_enviro.size() < 600);
@@ -322,8 +433,8 @@ void GameManager::initEnviro() // gotta wait for implementation of EnviroObj & G
 	{
 		do
 		{
-			x = 400 - rand()%800;
-			z = 300 - rand()%600;
+			x = 400 - Random::Next()%800;
+			z = 300 - Random::Next()%600;
 		} while((x < 4 && x > -4) && (z < 4 && z > -4));
 		Spawn(CRATE,Angel::vec3(x,0.0f,z),0.3);
 	} while(m_powerups.size() < 100);
@@ -332,11 +443,28 @@ void GameManager::initEnviro() // gotta wait for implementation of EnviroObj & G
 		m_bgenviro.at(i)->Update(1.0f);
 	for(int i=0;i<m_enviro.size();i++)
 		m_enviro.at(i)->Update(1.0f);
+
+#ifndef HEADLESS
+	// None of these move again, so they are baked into world space chunks
+	for(int i=0;i<m_walls.size();i++)
+		m_graphicsManager->AddStaticBatch(*m_walls.at(i)->getRenderBatch());
+	for(int i=0;i<m_enviro.size();i++)
+		m_graphicsManager->AddStaticBatch(*m_enviro.at(i)->getRenderBatch());
+	for(int i=0;i<m_bgenviro.size();i++)
+		m_graphicsManager->AddStaticBatch(*m_bgenviro.at(i)->getRenderBatch());
+	m_graphicsManager->BuildStaticGeometry();
+
+	// Tree trunks and rocks hide what is behind them
+	vec3 occluderMinimum, occluderMaximum;
+	for(int i=0;i<m_enviro.size();i++)
+		if(m_enviro.at(i)->getOccluder(occluderMinimum, occluderMaximum))
+			m_graphicsManager->AddOccluder(occluderMinimum, occluderMaximum);
+#endif
 }
 
 void GameManager::initPlayer()
 {
-	m_player = new Player(Angel::vec3(0.0f,0.0f,1.0f), Angel::vec3(0.0f), 0.7f, 0.2f, 5, 5.00);
+	m_player = new Player(Angel::vec3(0.0f,0.0f,1.0f), Angel::vec3(0.0f), 0.7f, 0.2f, m_playerLives, 5.00);
 
 	m_pp = *m_player->getPosition();
 	if(BBDEBUG) m_player->getRenderBatch()->m_effectParameters.m_materialOpacity = 0.5f;
@@ -347,7 +475,7 @@ void GameManager::initMonsters()
 	spawnMonsters();
 }
 
-void GameManager::Spawn(objectType type, vec3& position, float size){
+void GameManager::Spawn(objectType type, const vec3& position, float size){
 	switch(type){
 	case PLAYER:
 		break;
@@ -561,7 +689,7 @@ void GameManager::Update()
 	if(m_pause)
 		return;
 
-	if(m_monsters.size() < MONSTERCAP)
+	if(m_monsters.size() < m_monsterCap)
 		spawnMonsters();
 
 	if(m_auto && m_player->shoot(m_delta)){
@@ -579,7 +707,9 @@ void GameManager::Update()
 		m_flashTimer = 0.0f;
 
 	m_timeOfDay += m_delta;
+#ifndef HEADLESS
 	updateLighting();
+#endif
 
 	CollisionDetection();
 
@@ -634,8 +764,24 @@ void GameManager::Update()
 	m_player->Update(m_delta);
 	m_pp = *m_player->getPosition();
 }
-	
 
+// Advances the game by one tick of the given length without touching the
+// renderer.  Render() does the same work interleaved with camera setup.
+void GameManager::Simulate(float delta)
+{
+	m_delta = delta;
+
+	inputLogUpdate();
+	keyboardUpdate();
+	Update();
+}
+
+bool GameManager::IsGameOver()
+{
+	return m_pause && m_player->getLives() <= 0;
+}
+
+#ifndef HEADLESS
 void GameManager::Render()
 {
 	if(m_timer == NULL)
@@ -672,30 +818,32 @@ void GameManager::Render()
 	m_delta = m_timer->GetElapsedTime() * 60.0f;
 	m_timer->Reset();
 
+	inputLogUpdate();
 	keyboardUpdate();
 	updateCamera();
 	Update();
 
-	for(int i=0;i<m_walls.size();i++)
-		if(length(*m_walls.at(i)->getPosition()-m_pp) <= 50)
-			m_graphicsManager->Render(*m_walls.at(i)->getRenderBatch());		
+	// Walls and scenery are baked into chunks, the graphics manager picks the
+	// ones in view from a grid over their bounds
+	m_graphicsManager->RenderStaticGeometry();
+
+	// Everything else goes in one list, the graphics manager splits it across
+	// its worker threads to cull it against the view frustum
+	m_frameBatches.clear();
 	for(int i=0;i<m_powerups.size();i++)
-		if(length(*m_powerups.at(i)->getPosition()-m_pp) <= 50)
-			m_graphicsManager->Render(*m_powerups.at(i)->getRenderBatch());
+		m_frameBatches.push_back(m_powerups.at(i)->getRenderBatch());
 	for(int i=0;i<m_monsters.size();i++){
-		m_graphicsManager->Render(*m_monsters.at(i)->getRenderBatch());
-		if(BBDEBUG) m_graphicsManager->Render(*m_monsters.at(i)->getBoundingBox()->getRenderBatch());}
+		m_frameBatches.push_back(m_monsters.at(i)->getRenderBatch());
+		if(BBDEBUG) m_frameBatches.push_back(m_monsters.at(i)->getBoundingBox()->getRenderBatch());}
 	for(int i=0;i<m_bullets.size();i++)
-		m_graphicsManager->Render(*m_bullets.at(i)->getRenderBatch());
-	for(int i=0;i<m_enviro.size();i++)
-		if(length(*m_enviro.at(i)->getPosition()-m_pp) <= 50){
-			m_graphicsManager->Render(*m_enviro.at(i)->getRenderBatch());
-			if(BBDEBUG) m_graphicsManager->Render(*m_enviro.at(i)->getBoundingBox()->getRenderBatch());}
-	if(!(BBDEBUG))
-		renderBG();
-	m_graphicsManager->Render(*m_player->getRenderBatch());
-	if(BBDEBUG) m_graphicsManager->Render(*m_player->getBoundingBox()->getRenderBatch());
-	m_graphicsManager->Render(*m_ground->getRenderBatch());
+		m_frameBatches.push_back(m_bullets.at(i)->getRenderBatch());
+	if(BBDEBUG)
+		for(int i=0;i<m_enviro.size();i++)
+			m_frameBatches.push_back(m_enviro.at(i)->getBoundingBox()->getRenderBatch());
+	m_frameBatches.push_back(m_player->getRenderBatch());
+	if(BBDEBUG) m_frameBatches.push_back(m_player->getBoundingBox()->getRenderBatch());
+	m_frameBatches.push_back(m_ground->getRenderBatch());
+	m_graphicsManager->Render(m_frameBatches);
 
 	// render the hud too
 	RenderHUD();
@@ -730,14 +878,21 @@ void GameManager::playSound(soundType sound)
 	case GLOAD:
 	case GRUNT:		m_fxchannel = temp; break;}
 }
+#else
+void GameManager::playSound(soundType sound)
+{
+}
+#endif
 
 void GameManager::initGame()
 {
 	std::cout << "INITIALIZING GAME";
+#ifndef HEADLESS
 	m_graphicsManager = new GraphicsManager("../Data/AssetLibrary.txt");
 	std::cout << ".";
 	initSounds();
 	initParameters();
+#endif
 	std::cout << ".";
 	initEnviro();
 	std::cout << ".";
@@ -746,6 +901,7 @@ void GameManager::initGame()
 	std::cout << std::endl << "...GAME INITIALIZED!" << std::endl << std::endl;
 }
 
+#ifndef HEADLESS
 void GameManager::SetCameraOrthogonal()
 {
 	RenderParameters& renderParameters = m_graphicsManager->GetRenderParameters();
@@ -798,6 +954,7 @@ void GameManager::updateCamera()
 
 	// This is just for testing until you get this incorportated into GameManager
 }
+#endif
 
 vec3 GameManager::monsColDirection(Monster* m, Object* o)
 {
@@ -820,8 +977,14 @@ vec3 GameManager::monsColDirection(Monster* m, Object* o)
 		return -nT;
 }
 
+#ifndef HEADLESS
 void GameManager::RenderHUD()
 {
+	// Interned once rather than looked up by name every frame
+	static const AssetID numbers = "numbers";
+	static const AssetID none = "none";
+	static const AssetID gameover = "gameover";
+
 	SetCameraOrthogonal();
 
 	float score_position = 9.4;
@@ -829,92 +992,80 @@ void GameManager::RenderHUD()
 
 	// Render each score number in upper right corner
 	do {
-		RenderBatch* batch = new RenderBatch();
-
-		batch->m_geometryID = intID(temp%10);
-		batch->m_effectParameters.m_materialAmbient = vec3(5.0f, 5.0f, 5.0f);
-		batch->m_effectParameters.m_materialDiffuse = vec3(0.0f, 0.0f, 0.0f);
-		batch->m_effectParameters.m_materialSpecular = vec3(0.0f, 0.0f, 0.0f);
-		batch->m_effectParameters.m_materialSpecularExponent = 1.0f;
-		batch->m_effectParameters.m_materialGloss = 0.0f;
-		batch->m_effectParameters.m_materialOpacity = 0.9999f;
-		batch->m_effectParameters.m_diffuseTexture = "numbers";	
-		batch->m_effectParameters.m_normalMap = "none";
-		batch->m_effectParameters.m_HUDRender = true;
-		batch->m_effectParameters.m_materialOpacity = 1.0f;
-		batch->m_effectParameters.m_modelviewMatrix = Translate(score_position, 9.0, 0.0);
-
-		m_graphicsManager->Render(*batch);
+		RenderBatch batch;
+
+		batch.m_geometryID = intID(temp%10);
+		batch.m_effectParameters.m_materialAmbient = vec3(5.0f, 5.0f, 5.0f);
+		batch.m_effectParameters.m_materialDiffuse = vec3(0.0f, 0.0f, 0.0f);
+		batch.m_effectParameters.m_materialSpecular = vec3(0.0f, 0.0f, 0.0f);
+		batch.m_effectParameters.m_materialSpecularExponent = 1.0f;
+		batch.m_effectParameters.m_materialGloss = 0.0f;
+		batch.m_effectParameters.m_materialOpacity = 0.9999f;
+		batch.m_effectParameters.m_diffuseTexture = numbers;	
+		batch.m_effectParameters.m_normalMap = none;
+		batch.m_effectParameters.m_HUDRender = true;
+		batch.m_effectParameters.m_materialOpacity = 1.0f;
+		batch.m_effectParameters.m_modelviewMatrix = Translate(score_position, 9.0, 0.0);
+
+		m_graphicsManager->Render(batch);
 
 		temp /= 10;
 		score_position -= 0.6;
-
-		delete batch;
-
 	} while(temp != 0);
 
 	// Render lives in upper right corner (now only supports single digits)
 	temp = m_player->getLives();
 
-	RenderBatch* rb = new RenderBatch();
-	rb->m_geometryID = intID(temp);
-	rb->m_effectParameters.m_materialAmbient = vec3(5.0f, 5.0f, 5.0f);
-	rb->m_effectParameters.m_materialDiffuse = vec3(0.0f, 0.0f, 0.0f);
-	rb->m_effectParameters.m_materialSpecular = vec3(0.0f, 0.0f, 0.0f);
-	rb->m_effectParameters.m_materialSpecularExponent = 1.0f;
-	rb->m_effectParameters.m_materialGloss = 0.0f;
-	rb->m_effectParameters.m_materialOpacity = 0.9999f;
-	rb->m_effectParameters.m_diffuseTexture = "numbers";	
-	rb->m_effectParameters.m_normalMap = "none";
-	rb->m_effectParameters.m_HUDRender = true;
-	rb->m_effectParameters.m_materialOpacity = 1.0f;
-	rb->m_effectParameters.m_modelviewMatrix = Translate(-10.0, 9.0, 0.0);
-
-	m_graphicsManager->Render(*rb);
-
-	delete rb;
+	RenderBatch rb;
+	rb.m_geometryID = intID(temp);
+	rb.m_effectParameters.m_materialAmbient = vec3(5.0f, 5.0f, 5.0f);
+	rb.m_effectParameters.m_materialDiffuse = vec3(0.0f, 0.0f, 0.0f);
+	rb.m_effectParameters.m_materialSpecular = vec3(0.0f, 0.0f, 0.0f);
+	rb.m_effectParameters.m_materialSpecularExponent = 1.0f;
+	rb.m_effectParameters.m_materialGloss = 0.0f;
+	rb.m_effectParameters.m_materialOpacity = 0.9999f;
+	rb.m_effectParameters.m_diffuseTexture = numbers;	
+	rb.m_effectParameters.m_normalMap = none;
+	rb.m_effectParameters.m_HUDRender = true;
+	rb.m_effectParameters.m_materialOpacity = 1.0f;
+	rb.m_effectParameters.m_modelviewMatrix = Translate(-10.0, 9.0, 0.0);
+
+	m_graphicsManager->Render(rb);
 
 	// Render game over 
 	if (m_pause && m_player->getLives() <= 0) {
-		RenderBatch* rb = new RenderBatch();
-		rb->m_geometryID = "gameover";
-		rb->m_effectParameters.m_materialAmbient = vec3(5.0f, 5.0f, 5.0f);
-		rb->m_effectParameters.m_materialDiffuse = vec3(0.0f, 0.0f, 0.0f);
-		rb->m_effectParameters.m_materialSpecular = vec3(0.0f, 0.0f, 0.0f);
-		rb->m_effectParameters.m_materialSpecularExponent = 1.0f;
-		rb->m_effectParameters.m_materialGloss = 0.0f;
-		rb->m_effectParameters.m_materialOpacity = 0.9999f;
-		rb->m_effectParameters.m_diffuseTexture = "gameover";	
-		rb->m_effectParameters.m_normalMap = "none";
-		rb->m_effectParameters.m_HUDRender = true;
-		rb->m_effectParameters.m_materialOpacity = 1.0f;
-		rb->m_effectParameters.m_modelviewMatrix = mat4();
-
-		m_graphicsManager->Render(*rb);
-
-		delete rb;
+		RenderBatch rb;
+		rb.m_geometryID = gameover;
+		rb.m_effectParameters.m_materialAmbient = vec3(5.0f, 5.0f, 5.0f);
+		rb.m_effectParameters.m_materialDiffuse = vec3(0.0f, 0.0f, 0.0f);
+		rb.m_effectParameters.m_materialSpecular = vec3(0.0f, 0.0f, 0.0f);
+		rb.m_effectParameters.m_materialSpecularExponent = 1.0f;
+		rb.m_effectParameters.m_materialGloss = 0.0f;
+		rb.m_effectParameters.m_materialOpacity = 0.9999f;
+		rb.m_effectParameters.m_diffuseTexture = gameover;	
+		rb.m_effectParameters.m_normalMap = none;
+		rb.m_effectParameters.m_HUDRender = true;
+		rb.m_effectParameters.m_materialOpacity = 1.0f;
+		rb.m_effectParameters.m_modelviewMatrix = mat4();
+
+		m_graphicsManager->Render(rb);
 	}
 
 
 	SetupCamera(m_pp);
 }
 
-std::string GameManager::intID(int x)
-{
-	switch(x) {
-	case 1: return "one"; break;
-	case 2: return "two"; break;
-	case 3: return "three"; break;
-	case 4: return "four"; break;
-	case 5: return "five"; break;
-	case 6: return "six"; break;
-	case 7: return "seven"; break;
-	case 8: return "eight"; break;
-	case 9: return "nine"; break;
-	case 0: return "zero"; break;
-	default: return "none";
-	}
+AssetID GameManager::intID(int x)
+{
+	static const AssetID digits[10] = { "zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine" };
+	static const AssetID none = "none";
+
+	if (x < 0 || x > 9)
+		return none;
+
+	return digits[x];
 }
+#endif
 
 directionType relativePosition(Object& a, Object& b)
 {
@@ -932,48 +1083,15 @@ directionType relativePosition(Object& a, Object& b)
 	if(op->z > pp->z)
 		if((op->x <= (pp->x + (op->z - pp->z))) && (op->x >= (pp->x - (op->z - pp->z))))
 			return DOWN;
-}
-
-
-void GameManager::renderBG()
-{
-	int s = 0;
-	int e = 15;
-	GLfloat p = m_pp.x;
-
-	if(p >= -375)	s = 0;		if(p < 375)		e = 15;
-	if(p >= -325)	s = 1;		if(p < 325)		e = 14;
-	if(p >= -275)	s = 2;		if(p < 275)		e = 13;
-	if(p >= -225)	s = 3;		if(p < 225)		e = 12;
-	if(p >= -175)	s = 4;		if(p < 175)		e = 11;
-	if(p >= -125)	s = 5;		if(p < 125)		e = 10;
-	if(p >= -75)	s = 6;		if(p < 75)		e = 9;
-	if(p >= -25)	s = 7;		if(p < 25)		e = 8;
-	if(p >= 25)		s = 8;		if(p < -25)		e = 7;
-	if(p >= 75)		s = 9;		if(p < -75)		e = 6;
-	if(p >= 125)	s = 10;		if(p < -125)	e = 5;
-	if(p >= 175)	s = 11;		if(p < -175)	e = 4;
-	if(p >= 225)	s = 12;		if(p < -225)	e = 3;
-	if(p >= 275)	s = 13;		if(p < -275)	e = 2;
-	if(p >= 325)	s = 14;		if(p < -325)	e = 1;
-	if(p >= 375)	s = 15;		if(p < -375)	e = 0;
-
-	s *= 500;	e = (1 + e) * 500;
-
-	for(int i = s; i < e; i++)
-		if(length(*m_bgenviro.at(i)->getPosition()-m_pp) <= 50)
-			m_graphicsManager->Render(*m_bgenviro.at(i)->getRenderBatch());
 
-	for(int i = 8000; i < m_bgenviro.size(); i++)
-		if(length(*m_bgenviro.at(i)->getPosition()-m_pp) <= 50)
-			m_graphicsManager->Render(*m_bgenviro.at(i)->getRenderBatch());
+	// The four quadrants above cover the whole plane
+	return DOWN;
 }
 
 
 void GameManager::spawnMonsters()
 {
-	srand((unsigned)time(0));
-	directionType dir = directions[rand()%8];
+	directionType dir = directions[Random::Next()%8];
 	vec3 anchor;
 	switch(dir)
 	{
@@ -991,7 +1109,7 @@ void GameManager::spawnMonsters()
 	vec3 position;
 	for(int i=0;i<5;i++)
 	{
-		position = m_pp + 25*anchor + anchor*(rand()%5) + (20-rand()%40)*an;
+		position = m_pp + 25*anchor + anchor*(Random::Next()%5) + (20-Random::Next()%40)*an;
 		Spawn(MONSTER,position,0.8);
 	}
 }
\ No newline at end of file
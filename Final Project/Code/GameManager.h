@@ -11,13 +11,16 @@
 #include "Ground.h"
 #include "Crate.h"
 #include "Timer.h"
+#include "InputLog.h"
 #include <vector>
+#ifndef HEADLESS
 #include "FMOD\fmod.hpp"
 #include "FMOD\fmod_errors.h"
+#endif
 
-const enum directionType {UP,DOWN,LEFT,RIGHT, UPLEFT, UPRIGHT, DOWNLEFT, DOWNRIGHT};
+enum directionType {UP,DOWN,LEFT,RIGHT, UPLEFT, UPRIGHT, DOWNLEFT, DOWNRIGHT};
 const directionType directions[8] = {UP, DOWN, LEFT, RIGHT, UPLEFT, UPRIGHT, DOWNLEFT, DOWNRIGHT};
-const enum soundType {MACHINEGUN, SHOTGUN, MONSDEATH, BGMUSIC, GRUNT, GLOAD};
+enum soundType {MACHINEGUN, SHOTGUN, MONSDEATH, BGMUSIC, GRUNT, GLOAD};
 
 class GameManager
 {
@@ -26,6 +29,18 @@ public:
 	~GameManager();
 	void initGame();
 	void Render();
+	void Simulate(float delta);
+	bool IsGameOver();
+	void SetMonsterCap(unsigned int cap) { m_monsterCap = cap; }
+	void SetPlayerLives(int lives) { m_playerLives = lives; }
+	void SetSeed(unsigned int seed) { m_seed = seed; }
+	bool RecordInput(const std::string& fileName, float delta = 1.0f);
+	bool ReplayInput(const std::string& fileName);
+	bool IsReplayFinished();
+	int GetScore() { return m_score; }
+	vec3 GetPlayerPosition() { return m_pp; }
+	unsigned int GetMonsterCount() { return m_monsters.size(); }
+	unsigned int GetBulletCount() { return m_bullets.size(); }
 	void callbackKeyboard (unsigned char key, int x, int y);
 	void callbackKeyUp (unsigned char key, int x, int y);
 private:
@@ -42,46 +57,54 @@ private:
 	std::vector<Crate*> m_walls;
 	Ground* m_ground;
 	GraphicsManager* m_graphicsManager;
+	std::vector<const RenderBatch*> m_frameBatches;
 	int m_score;
 	int m_god;
 	bool m_godmode;
 	static const int MONSTERCAP = 10;
-	void Spawn(objectType type, vec3& position, float size=10.0);
+	unsigned int m_monsterCap;
+	int m_playerLives;
+	void Spawn(objectType type, const vec3& position, float size=10.0);
 	void spawnMonsters();
 	float angle;
 	bool m_w,m_a,m_s,m_d,m_j,m_l,m_auto;
 	void Delete(objectType type, int index=0);
 	void Update();
 	void keyboardUpdate();
+	void inputLogUpdate();
 	void CollisionDetection();
 	void initSounds();
 	void initPlayer();
 	void initMonsters();
 	void initEnviro();
 	void initParameters();
-	void renderBG();
 	void SetCameraOrthogonal();
 	void SetupCamera(vec4 playerPos);
 	void updateCamera();
 	void updateLighting();
 	vec3 monsColDirection(Monster* m, Object* o);
 	void playSound(soundType sound);
+#ifndef HEADLESS
 	FMOD::System *m_system;
     FMOD::Sound *m_sounds[6];
     FMOD::Channel *m_bulletchannel;
 	FMOD::Channel *m_monschannel;
 	FMOD::Channel *m_bgchannel;
 	FMOD::Channel *m_fxchannel;
+#endif
 	bool m_mute;
 
 	void RenderHUD();
-	std::string intID(int x);
+	AssetID intID(int x);
 
 	void ResetGame();
 	bool m_pause;
 
 	Timer* m_timer;
 	float m_delta;
+
+	unsigned int m_seed;
+	InputLog* m_inputLog;
 };
 
 directionType relativePosition(Object& a, Object& b);
@@ -3,17 +3,44 @@
 
 #include "Angel.h"
 
+#include "BufferArena.h"
+#include "Vertex.h"
+
 enum GeometryMode { 
 	e_GeometryModeTriangles = GL_TRIANGLES,
 	e_GeometryModeTriangleStrip = GL_TRIANGLE_STRIP
 };
 
+// A range of the geometry's index list, level 0 is the full mesh and each
+// following level a coarser simplification over the same vertexes
+struct GeometryLOD
+{
+	GLuint m_firstIndex;
+	GLuint m_numIndex;
+};
+
 struct Geometry
 {
 	GeometryMode m_geometryMode;
 
+	// Byte offsets into m_vertexRange's buffer, one per keyframe
 	std::vector<GLuint> m_vertexDataStarts;
 	GLuint m_numVertex;
+
+	VertexFormat m_vertexFormat;
+	VertexDecode m_vertexDecode;
+
+	// Byte offset into m_indexRange's buffer, shared by every keyframe
+	GLuint m_indexDataStart;
+	GLuint m_numIndex;
+	std::vector<GeometryLOD> m_lods;
+
+	// Encloses every keyframe, in model space
+	vec3 m_boundingCenter;
+	float m_boundingRadius;
+
+	BufferRange m_vertexRange;
+	BufferRange m_indexRange;
 };
 
 #endif
\ No newline at end of file
@@ -3,14 +3,123 @@
 #include <fstream>
 #include <vector>
 #include <string>
-#include <sstream>
+#include <cstring>
 
 #include "Vertex.h"
 #include "Geometry.h"
 #include "AttributeLocation.h"
+#include "MappedFile.h"
+#include "OBJParser.h"
+#include "MeshOptimizer.h"
+#include "BufferArena.h"
+#include "VertexPacking.h"
+#include "AssetLoader.h"
+#include "GLStateCache.h"
+
+// Cooked geometry is cached next to the first source file as a header, one
+// stamp per source file, the level of detail table, the indexed vertex array
+// of every keyframe in the geometry's vertex format and the shared index list
+// of every level, ready to be handed straight to glBufferSubData.
+static const char c_geometry_cache_extension[] = ".cache";
+static const char c_geometry_cache_magic[4] = { 'G', 'H', 'G', 'C' };
+static const unsigned int c_geometry_cache_version = 5;
+
+struct GeometryCacheHeader
+{
+	char m_magic[4];
+	unsigned int m_version;
+	unsigned int m_vertexSize;
+	unsigned int m_vertexFormat;
+	unsigned int m_geometryMode;
+	unsigned int m_numSources;
+	unsigned int m_numFrames;
+	unsigned int m_numVertex;
+	unsigned int m_numIndex;
+	unsigned int m_numLODs;
+	VertexDecode m_vertexDecode;
+	vec3 m_boundingCenter;
+	float m_boundingRadius;
+};
+
+// Vertex buffers are handed out in PackedVertex sized units, a full Vertex
+// takes two
+static const unsigned int c_vertex_arena_unit = sizeof(PackedVertex);
+
+static unsigned int GetVertexSize (VertexFormat vertexFormat) {
+	return vertexFormat == e_VertexFormatPacked ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+// Source file stamp, the cache is rebuilt when either changes
+struct GeometryCacheStamp
+{
+	long long m_sourceSize;
+	long long m_sourceTime;
+};
+
+// FIFO size used for the cache miss numbers in the cook report
+static const unsigned int c_report_cache_size = 32;
+
+// Each level of detail aims for half the triangles of the one before.  Levels
+// are only built below meshes with at least c_lod_min_triangles triangles and
+// are dropped when the simplifier can't get under c_lod_min_reduction of the
+// previous level, usually because too much of the mesh is open border.
+static const unsigned int c_max_lods = 4;
+static const unsigned int c_lod_min_triangles = 256;
+static const float c_lod_min_reduction = 0.9f;
+
+// Projected bounding radius, as a fraction of half the screen height, below
+// which the next level of detail is drawn
+static const float c_lod_screen_sizes[c_max_lods - 1] = { 0.2f, 0.1f, 0.05f };
+
+// Everything UploadGeometry needs, built off the GL thread.  The frame and
+// index pointers point either into the mapped cache file or into the arrays
+// cooked from the source files.
+struct CookedGeometry
+{
+	VertexFormat m_vertexFormat;
+	VertexDecode m_vertexDecode;
+	vec3 m_boundingCenter;
+	float m_boundingRadius;
+
+	std::vector<const void*> m_frameData;
+	unsigned int m_numVertex;
+
+	std::vector<GeometryLOD> m_lods;
+	const GLuint* m_indexData;
+	unsigned int m_numIndex;
+
+	MappedFile m_cacheFile;
+	std::vector<std::vector<Vertex> > m_frames;
+	std::vector<std::vector<PackedVertex> > m_packedFrames;
+	std::vector<GLuint> m_indexes;
+};
+
+class GeometryLoadJob : public AssetLoadJob
+{
+public:
+	GeometryLoadJob (GeometryManager* geometryManager, AssetID geometryID, const std::vector<std::string>& geometryFiles, VertexFormat vertexFormat)
+		: AssetLoadJob(geometryID.GetName()), m_geometryManager(geometryManager), m_geometryID(geometryID), m_geometryFiles(geometryFiles), m_vertexFormat(vertexFormat)
+	{}
+
+	virtual bool Load () {
+		return GeometryManager::CookGeometry(GetName(), m_geometryFiles, m_vertexFormat, m_cookedGeometry);
+	}
 
-GeometryManager::GeometryManager (const std::string& assetFile) 
-	: m_vertexDataUsed(0)
+	virtual void Upload () {
+		m_geometryManager->AddGeometry(m_geometryID, m_cookedGeometry);
+	}
+
+private:
+	GeometryManager* m_geometryManager;
+	AssetID m_geometryID;
+	std::vector<std::string> m_geometryFiles;
+	VertexFormat m_vertexFormat;
+
+	CookedGeometry m_cookedGeometry;
+};
+
+GeometryManager::GeometryManager (const std::string& assetFile, AssetLoader& assetLoader) 
+	: m_numGeometry(0), m_vao(0), m_vertexArena(NULL), m_indexArena(NULL)
 {
 	std::ifstream is;
 	is.open (assetFile.c_str(), std::ios::binary);
@@ -19,63 +128,53 @@ GeometryManager::GeometryManager (const std::string& assetFile)
 		printf("GeometryManager::GeometryManager: Error opening asset library.\n");
 	}
 	else {
-		unsigned int bufferSize;
-		is >> bufferSize;
+		// Only the size of the first buffer page, more are added as needed
+		unsigned int pageSize;
+		is >> pageSize;
 
-		InitBuffer(bufferSize);
+		InitBuffer(pageSize);
 
 		while (is.good()) {
 			std::string geometryMode;
+			std::string geometryName;
+			std::vector<std::string> geometryFiles;
+			VertexFormat vertexFormat = e_VertexFormatFull;
 
 			is >> geometryMode;   
 
+			// Optional vertex format ahead of the mode, "packed static rock ..."
+			if (geometryMode == "packed") {
+				vertexFormat = e_VertexFormatPacked;
+				is >> geometryMode;
+			}
+
 			if (geometryMode == "static") {
 				std::string geometryFile;
-				std::string geometryName;
 
 				is >> geometryName;
 				is >> geometryFile;
 
-				Geometry* geometry = LoadOBJFile(geometryFile);  
-
-				if (geometry != NULL)
-					m_geometry[geometryName] = geometry;
+				geometryFiles.push_back(geometryFile);
 			}
 			else if (geometryMode == "keyframe") {					
 				unsigned int fileCount;
-				std::string geometryName;
 
 				is >> fileCount;
 				is >> geometryName;
 
-				Geometry* keyframeGeometry = NULL;
-
 				while (fileCount--) {
 					std::string geometryFile;
 
 					is >> geometryFile;
 
-					Geometry* geometry = LoadOBJFile(geometryFile);  
-
-					if (geometry == NULL) {
-						continue;
-					}
-					else if (keyframeGeometry == NULL) {
-						keyframeGeometry = geometry;
-					}
-					else {
-						if (geometry->m_geometryMode != keyframeGeometry->m_geometryMode || geometry->m_numVertex != keyframeGeometry->m_numVertex) 
-							printf("GeometryManager::GeometryManager: Incompatible keyframe file %s.\n", geometryFile);
-						else 
-							keyframeGeometry->m_vertexDataStarts.push_back(geometry->m_vertexDataStarts.back());
-						
-						delete geometry;
-					}
+					geometryFiles.push_back(geometryFile);
 				}
-
-				if (keyframeGeometry != NULL)
-					m_geometry[geometryName] = keyframeGeometry;
 			}
+
+			if (geometryFiles.empty())
+				continue;
+
+			assetLoader.Load(new GeometryLoadJob(this, geometryName, geometryFiles, vertexFormat));
 		}
 
 		is.close();
@@ -83,37 +182,164 @@ GeometryManager::GeometryManager (const std::string& assetFile)
 }
 
 GeometryManager::~GeometryManager () {
-	glDeleteBuffers(1, &m_buffer);
-	glDeleteVertexArrays(1, &m_vao);
+	for (unsigned int i = 0; i < m_geometry.size(); ++i) 
+		delete m_geometry[i];
+
+	delete m_vertexArena;
+	delete m_indexArena;
 
-	for (std::map<std::string, Geometry*>::iterator iter = m_geometry.begin(); iter != m_geometry.end(); ++iter) 
-		delete iter->second;
+	glDeleteVertexArrays(1, &m_vao);
 }
 
-void GeometryManager::InitBuffer (unsigned int size) {
+void GeometryManager::InitBuffer (unsigned int pageSize) {
 	// Create a vertex array object
     glGenVertexArrays( 1, &m_vao );
     glBindVertexArray( m_vao );
 
-    // Create and initialize a buffer object
-    glGenBuffers( 1, &m_buffer );
-    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-	glBufferData(GL_ARRAY_BUFFER, size * sizeof(Vertex), NULL, GL_STATIC_DRAW);
-    
-	m_vertexDataUsed = 0;
+	// The page size is counted in full vertexes
+	m_vertexArena = new BufferArena(GL_ARRAY_BUFFER, c_vertex_arena_unit, pageSize * sizeof(Vertex) / c_vertex_arena_unit);
+	m_indexArena = new BufferArena(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint), pageSize);
 }
 
-AttributeLocation GeometryManager::GetAttributeLocation (const std::string& geometryID, float animationTime) {
-	AttributeLocation attributeLocation;
+void GeometryManager::PrintBufferUsage () const {
+	if (m_vertexArena == NULL)
+		return;
+
+	printf("GeometryManager::PrintBufferUsage: %u geometries, %u KB vertex data, %u indexes in %u + %u buffers.\n", 
+		m_numGeometry, m_vertexArena->GetUsed() * c_vertex_arena_unit / 1024, m_indexArena->GetUsed(), 
+		m_vertexArena->GetNumPages(), m_indexArena->GetNumPages());
+}
+
+bool GeometryManager::LoadGeometry (AssetID geometryID, const std::vector<std::string>& geometryFiles, VertexFormat vertexFormat) {
+	if (m_vertexArena == NULL || geometryFiles.empty())
+		return false;
+
+	CookedGeometry cookedGeometry;
+
+	if (!CookGeometry(geometryID.GetName(), geometryFiles, vertexFormat, cookedGeometry))
+		return false;
+
+	return AddGeometry(geometryID, cookedGeometry);
+}
+
+bool GeometryManager::LoadGeometry (AssetID geometryID, const std::vector<Vertex>& vertexes, const std::vector<GLuint>& indexes, VertexFormat vertexFormat) {
+	std::vector<GeometryLOD> lods(1);
+	lods[0].m_firstIndex = 0;
+	lods[0].m_numIndex = indexes.size();
+
+	return LoadGeometry(geometryID, vertexes, indexes, lods, vertexFormat);
+}
+
+bool GeometryManager::LoadGeometry (AssetID geometryID, const std::vector<Vertex>& vertexes, const std::vector<GLuint>& indexes, const std::vector<GeometryLOD>& lods, VertexFormat vertexFormat) {
+	if (m_vertexArena == NULL || vertexes.empty() || indexes.empty() || lods.empty())
+		return false;
+
+	CookedGeometry cookedGeometry;
+	cookedGeometry.m_frames.push_back(vertexes);
+
+	ComputeBoundingSphere(cookedGeometry.m_frames, cookedGeometry.m_boundingCenter, cookedGeometry.m_boundingRadius);
+
+	cookedGeometry.m_vertexFormat = vertexFormat;
+	cookedGeometry.m_numVertex = vertexes.size();
+	cookedGeometry.m_lods = lods;
+	cookedGeometry.m_indexData = &indexes[0];
+	cookedGeometry.m_numIndex = indexes.size();
+
+	if (vertexFormat == e_VertexFormatPacked) {
+		PackVertexes(cookedGeometry.m_frames, cookedGeometry.m_packedFrames, cookedGeometry.m_vertexDecode);
+		cookedGeometry.m_frameData.push_back(&cookedGeometry.m_packedFrames[0][0]);
+	}
+	else {
+		cookedGeometry.m_frameData.push_back(&cookedGeometry.m_frames[0][0]);
+	}
 
-	std::map<std::string, Geometry*>::iterator iter = m_geometry.find(geometryID);
+	return AddGeometry(geometryID, cookedGeometry);
+}
+
+bool GeometryManager::ReadGeometry (AssetID geometryID, std::vector<Vertex>& vertexes, std::vector<GLuint>& indexes, std::vector<GeometryLOD>& lods) const {
+	Geometry* geometry = GetGeometry(geometryID);
+
+	if (geometry == NULL) {
+		printf("GeometryManager::ReadGeometry: Unknown geometryID %s.\n", geometryID.GetName().c_str());
+		return false;
+	}
+
+	// Errors left by earlier calls would otherwise be blamed on the reads
+	while (glGetError() != GL_NO_ERROR)
+		;
+
+	lods = geometry->m_lods;
 
-	if (iter == m_geometry.end()) {
-		printf("GeometryManager::GetAttributeLocation: Unknown geometryID %s.\n", geometryID.c_str());
+	indexes.resize(geometry->m_numIndex);
+	GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->m_indexRange.m_buffer);
+	glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, geometry->m_indexDataStart, geometry->m_numIndex * sizeof(GLuint), &indexes[0]);
+
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, geometry->m_vertexRange.m_buffer);
+
+	if (geometry->m_vertexFormat == e_VertexFormatPacked) {
+		std::vector<PackedVertex> packed(geometry->m_numVertex);
+		glGetBufferSubData(GL_ARRAY_BUFFER, geometry->m_vertexDataStarts[0], geometry->m_numVertex * sizeof(PackedVertex), &packed[0]);
+
+		UnpackVertexes(&packed[0], geometry->m_numVertex, geometry->m_vertexDecode, vertexes);
 	}
 	else {
-		Geometry* geometry = iter->second;
+		vertexes.assign(geometry->m_numVertex, Vertex(vec3(), vec3(), vec2()));
+		glGetBufferSubData(GL_ARRAY_BUFFER, geometry->m_vertexDataStarts[0], geometry->m_numVertex * sizeof(Vertex), &vertexes[0]);
+	}
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+bool GeometryManager::AddGeometry (AssetID geometryID, const CookedGeometry& cookedGeometry) {
+	if (m_vertexArena == NULL)
+		return false;
+
+	Geometry* geometry = UploadGeometry(cookedGeometry);
+
+	if (geometry == NULL)
+		return false;
+
+	ReleaseGeometry(geometryID);
+
+	if (geometryID.GetIndex() >= m_geometry.size())
+		m_geometry.resize(geometryID.GetIndex() + 1, NULL);
+
+	m_geometry[geometryID.GetIndex()] = geometry;
+	++m_numGeometry;
+
+	return true;
+}
+
+void GeometryManager::ReleaseGeometry (AssetID geometryID) {
+	Geometry* geometry = GetGeometry(geometryID);
+
+	if (geometry == NULL)
+		return;
+
+	m_vertexArena->Release(geometry->m_vertexRange);
+	m_indexArena->Release(geometry->m_indexRange);
 
+	delete geometry;
+	m_geometry[geometryID.GetIndex()] = NULL;
+	--m_numGeometry;
+}
+
+Geometry* GeometryManager::GetGeometry (AssetID geometryID) const {
+	if (geometryID.GetIndex() >= m_geometry.size())
+		return NULL;
+
+	return m_geometry[geometryID.GetIndex()];
+}
+
+AttributeLocation GeometryManager::GetAttributeLocation (AssetID geometryID, float animationTime) {
+	AttributeLocation attributeLocation;
+
+	Geometry* geometry = GetGeometry(geometryID);
+
+	if (geometry == NULL) {
+		printf("GeometryManager::GetAttributeLocation: Unknown geometryID %s.\n", geometryID.GetName().c_str());
+	}
+	else {
 		unsigned int numAnimationModels = geometry->m_vertexDataStarts.size();
 
 		unsigned int firstModel = (unsigned int)fmod(animationTime, numAnimationModels);
@@ -127,150 +353,403 @@ AttributeLocation GeometryManager::GetAttributeLocation (const std::string& geom
 		unsigned int firstModelVertexStart = geometry->m_vertexDataStarts[firstModel];
 		unsigned int secondModelVertexStart = geometry->m_vertexDataStarts[secondModel];
 
-		attributeLocation.m_position0 = firstModelVertexStart + c_positionDataOffset;
-		attributeLocation.m_normal0 = firstModelVertexStart + c_normalDataOffset;
-		attributeLocation.m_texCoord0 = firstModelVertexStart + c_texCoord0DataOffset;
+		bool packed = geometry->m_vertexFormat == e_VertexFormatPacked;
+
+		unsigned int positionDataOffset = packed ? c_packedPositionDataOffset : c_positionDataOffset;
+		unsigned int normalDataOffset = packed ? c_packedNormalDataOffset : c_normalDataOffset;
+		unsigned int texCoord0DataOffset = packed ? c_packedTexCoord0DataOffset : c_texCoord0DataOffset;
 
-		attributeLocation.m_position1 = secondModelVertexStart + c_positionDataOffset;
-		attributeLocation.m_normal1 = secondModelVertexStart + c_normalDataOffset;
-		attributeLocation.m_texCoord1 = secondModelVertexStart + c_texCoord0DataOffset;
+		attributeLocation.m_position0 = firstModelVertexStart + positionDataOffset;
+		attributeLocation.m_normal0 = firstModelVertexStart + normalDataOffset;
+		attributeLocation.m_texCoord0 = firstModelVertexStart + texCoord0DataOffset;
+
+		attributeLocation.m_position1 = secondModelVertexStart + positionDataOffset;
+		attributeLocation.m_normal1 = secondModelVertexStart + normalDataOffset;
+		attributeLocation.m_texCoord1 = secondModelVertexStart + texCoord0DataOffset;
 
 		attributeLocation.m_animatedGeometry = firstModel != secondModel;
+		attributeLocation.m_vertexBuffer = geometry->m_vertexRange.m_buffer;
+		attributeLocation.m_vertexFormat = geometry->m_vertexFormat;
+		attributeLocation.m_vertexDecode = geometry->m_vertexDecode;
 	}
 
 	return attributeLocation;
 }
 
-void GeometryManager::RenderGeometry (const std::string& geometryID) {
-	std::map<std::string, Geometry*>::iterator iter = m_geometry.find(geometryID);
-
-	if (iter == m_geometry.end()) {
-		printf("GeometryManager::RenderGeometry: Unknown geometryID %s.\n", geometryID.c_str());
-		return;
+// Largest length a unit vector can have after modelMatrix
+static float GetMaximumScale (const mat4& modelMatrix) {
+	float scale = 0.0f;
+	for (int i = 0; i < 3; ++i) {
+		float axisScale = length(vec3(modelMatrix[0][i], modelMatrix[1][i], modelMatrix[2][i]));
+		scale = axisScale > scale ? axisScale : scale;
 	}
 
-	Geometry* geometry = iter->second;
-	glDrawArrays(geometry->m_geometryMode, 0, geometry->m_numVertex);
+	return scale;
 }
 
-static void TokenizeString (const std::string& input, const std::string& delims, std::vector<std::string>& tokens) {
-    tokens.clear();
+float GeometryManager::GetScreenSize (AssetID geometryID, const mat4& modelMatrix, const mat4& viewProjectionMatrix, float& depth) const {
+	Geometry* geometry = GetGeometry(geometryID);
+
+	depth = 0.0f;
+
+	if (geometry == NULL)
+		return 1.0f;
+
+	vec4 center = viewProjectionMatrix * (modelMatrix * vec4(geometry->m_boundingCenter, 1.0f));
+	depth = center.w;
 
-    std::string::size_type beg_index, end_index;
+	// Spheres reaching behind the eye are close enough for full detail
+	if (center.w <= geometry->m_boundingRadius)
+		return 1.0f;
 
-    beg_index = input.find_first_not_of(delims);
+	float scale = GetMaximumScale(modelMatrix);
 
-    while (beg_index != std::string::npos) {
-        end_index = input.find_first_of(delims, beg_index);
-        
-		if (end_index == std::string::npos) 
-			end_index = input.length();
+	// The y row of the view projection is the view's up axis times the
+	// projection's y scale, whatever the camera orientation
+	float projectionScale = length(vec3(viewProjectionMatrix[1][0], viewProjectionMatrix[1][1], viewProjectionMatrix[1][2]));
+	float screenSize = geometry->m_boundingRadius * scale * projectionScale / center.w;
 
-        tokens.push_back(input.substr(beg_index, end_index - beg_index));
-        beg_index = input.find_first_not_of(delims,end_index);
-    }
+	return screenSize < 1.0f ? screenSize : 1.0f;
 }
 
-template <typename T>
-static T ConvertString (const std::string& string) {
-	std::stringstream ss(string);
-	T result;
-	return ss >> result ? result : 0;
+bool GeometryManager::GetBoundingSphere (AssetID geometryID, const mat4& modelMatrix, vec3& center, float& radius) const {
+	Geometry* geometry = GetGeometry(geometryID);
+
+	if (geometry == NULL)
+		return false;
+
+	vec4 worldCenter = modelMatrix * vec4(geometry->m_boundingCenter, 1.0f);
+
+	center = vec3(worldCenter.x, worldCenter.y, worldCenter.z);
+	radius = geometry->m_boundingRadius * GetMaximumScale(modelMatrix);
+	return true;
 }
 
-Geometry* GeometryManager::LoadOBJFile (const std::string& geometryFile) {
-	std::ifstream is;
-	is.open (geometryFile.c_str(), std::ios::binary);
+unsigned int GeometryManager::SelectLOD (AssetID geometryID, float screenSize) const {
+	Geometry* geometry = GetGeometry(geometryID);
 
-	if (!is.is_open()) {
-		printf("GeometryManager::LoadOBJFile: Error loading file %s.\n", geometryFile.c_str());
-		return NULL;
+	if (geometry == NULL || geometry->m_lods.size() < 2)
+		return 0;
+
+	unsigned int lod = 0;
+	while (lod + 1 < geometry->m_lods.size() && screenSize < c_lod_screen_sizes[lod])
+		++lod;
+
+	return lod;
+}
+
+void GeometryManager::RenderGeometry (AssetID geometryID, unsigned int lod, unsigned int numInstances) {
+	Geometry* geometry = GetGeometry(geometryID);
+
+	if (geometry == NULL) {
+		printf("GeometryManager::RenderGeometry: Unknown geometryID %s.\n", geometryID.GetName().c_str());
+		return;
 	}
-	
-	std::vector<std::string> tokens;
-	std::string fileLine;
 
-	std::vector<Vertex> geometryData;
+	if (lod >= geometry->m_lods.size())
+		lod = geometry->m_lods.size() - 1;
+
+	const GeometryLOD& level = geometry->m_lods[lod];
+
+	// The element array binding is vertex array object state, geometry is
+	// spread over several buffers so it can differ between draws
+	GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->m_indexRange.m_buffer);
+
+	if (numInstances > 1)
+		glDrawElementsInstanced(geometry->m_geometryMode, level.m_numIndex, GL_UNSIGNED_INT, BUFFER_OFFSET(geometry->m_indexDataStart + level.m_firstIndex * sizeof(GLuint)), numInstances);
+	else
+		glDrawElements(geometry->m_geometryMode, level.m_numIndex, GL_UNSIGNED_INT, BUFFER_OFFSET(geometry->m_indexDataStart + level.m_firstIndex * sizeof(GLuint)));
+}
+
+bool GeometryManager::CookGeometry (const std::string& geometryName, const std::vector<std::string>& geometryFiles, VertexFormat vertexFormat, CookedGeometry& cookedGeometry) {
+	if (geometryFiles.empty())
+		return false;
 
-	std::vector<vec3> vertexes;
-	std::vector<vec3> normals;
-	std::vector<vec2> texCoords;
+	std::string cacheFile = geometryFiles[0] + c_geometry_cache_extension;
 
-	 while (!is.eof()) {
-	    getline(is, fileLine);
-	    TokenizeString(fileLine, " /", tokens);
+	if (LoadCacheFile(geometryFiles, cacheFile, vertexFormat, cookedGeometry))
+		return true;
 
-		if (tokens.size() == 0)
+	std::vector<std::vector<Vertex> > frames;
+
+	for (unsigned int i = 0; i < geometryFiles.size(); ++i) {
+		std::vector<Vertex> geometryData;
+
+		if (!ParseOBJFile(geometryFiles[i], geometryData) || geometryData.empty())
 			continue;
 
-		if (tokens[0] == "v" && tokens.size() == 4) {
-			vertexes.push_back(vec3(ConvertString<float>(tokens[1]), ConvertString<float>(tokens[2]), ConvertString<float>(tokens[3])));
-		}
-		else if (tokens[0] == "vn" && tokens.size() == 4) {
-			normals.push_back(vec3(ConvertString<float>(tokens[1]), ConvertString<float>(tokens[2]), ConvertString<float>(tokens[3])));
+		if (!frames.empty() && geometryData.size() != frames[0].size()) {
+			printf("GeometryManager::CookGeometry: Incompatible keyframe file %s.\n", geometryFiles[i].c_str());
+			continue;
 		}
-		else if (tokens[0] == "vt" && tokens.size() > 2) {
-			texCoords.push_back(vec2(ConvertString<float>(tokens[1]), ConvertString<float>(tokens[2])));
+
+		frames.push_back(std::vector<Vertex>());
+		frames.back().swap(geometryData);
+	}
+
+	if (frames.empty())
+		return false;
+
+	unsigned int numCorners = frames[0].size();
+
+	std::vector<std::vector<Vertex> >& indexedFrames = cookedGeometry.m_frames;
+	std::vector<GLuint>& indexes = cookedGeometry.m_indexes;
+
+	IndexTriangles(frames, indexedFrames, indexes);
+
+	unsigned int numVertex = indexedFrames[0].size();
+
+	std::vector<GLuint> optimizedIndexes(indexes);
+
+	OptimizeVertexCache(optimizedIndexes, numVertex);
+
+	float unoptimizedMissRatio = AverageCacheMissRatio(indexes, numVertex, c_report_cache_size);
+	float optimizedMissRatio = AverageCacheMissRatio(optimizedIndexes, numVertex, c_report_cache_size);
+
+	// Meshes that were already well ordered can come out slightly worse
+	if (optimizedMissRatio <= unoptimizedMissRatio)
+		indexes.swap(optimizedIndexes);
+
+	OptimizeVertexFetch(indexedFrames, indexes);
+
+	// Every level indexes the full detail vertexes, so they are all appended
+	// to one index list
+	std::vector<GeometryLOD> lods(1);
+	lods[0].m_firstIndex = 0;
+	lods[0].m_numIndex = indexes.size();
+
+	std::vector<GLuint> baseIndexes(indexes);
+	std::string lodReport;
+
+	while (lods.size() < c_max_lods && lods.back().m_numIndex / 3 >= c_lod_min_triangles) {
+		unsigned int previousTriangles = lods.back().m_numIndex / 3;
+
+		std::vector<GLuint> lodIndexes;
+		SimplifyTriangles(indexedFrames, baseIndexes, previousTriangles / 2, lodIndexes);
+
+		if (lodIndexes.empty() || lodIndexes.size() / 3 > previousTriangles * c_lod_min_reduction)
+			break;
+
+		OptimizeVertexCache(lodIndexes, numVertex);
+
+		GeometryLOD lod;
+		lod.m_firstIndex = indexes.size();
+		lod.m_numIndex = lodIndexes.size();
+		lods.push_back(lod);
+
+		indexes.insert(indexes.end(), lodIndexes.begin(), lodIndexes.end());
+
+		char triangles[32];
+		sprintf(triangles, " %u", lod.m_numIndex / 3);
+		lodReport += triangles;
+	}
+
+	ComputeBoundingSphere(indexedFrames, cookedGeometry.m_boundingCenter, cookedGeometry.m_boundingRadius);
+
+	cookedGeometry.m_vertexFormat = vertexFormat;
+	cookedGeometry.m_numVertex = numVertex;
+	cookedGeometry.m_lods = lods;
+	cookedGeometry.m_indexData = &indexes[0];
+	cookedGeometry.m_numIndex = indexes.size();
+
+	if (vertexFormat == e_VertexFormatPacked) {
+		std::vector<std::vector<PackedVertex> >& packedFrames = cookedGeometry.m_packedFrames;
+		PackVertexes(indexedFrames, packedFrames, cookedGeometry.m_vertexDecode);
+
+		for (unsigned int i = 0; i < packedFrames.size(); ++i)
+			cookedGeometry.m_frameData.push_back(&packedFrames[i][0]);
+	}
+	else {
+		for (unsigned int i = 0; i < indexedFrames.size(); ++i)
+			cookedGeometry.m_frameData.push_back(&indexedFrames[i][0]);
+	}
+
+	unsigned int unindexedSize = frames.size() * numCorners * sizeof(Vertex);
+	unsigned int indexedSize = frames.size() * numVertex * GetVertexSize(vertexFormat) + indexes.size() * sizeof(GLuint);
+
+	printf("GeometryManager::CookGeometry: %s %u -> %u vertexes, %u KB -> %u KB (%d KB saved), ACMR %.2f -> %.2f, LOD triangles %u%s.\n", 
+		geometryName.c_str(), numCorners, numVertex, unindexedSize / 1024, indexedSize / 1024, 
+		((int)unindexedSize - (int)indexedSize) / 1024, unoptimizedMissRatio, 
+		optimizedMissRatio <= unoptimizedMissRatio ? optimizedMissRatio : unoptimizedMissRatio,
+		lods[0].m_numIndex / 3, lodReport.c_str());
+
+	WriteCacheFile(geometryFiles, cacheFile, cookedGeometry);
+
+	return true;
+}
+
+bool GeometryManager::LoadCacheFile (const std::vector<std::string>& geometryFiles, const std::string& cacheFile, VertexFormat vertexFormat, CookedGeometry& cookedGeometry) {
+	MappedFile& file = cookedGeometry.m_cacheFile;
+
+	if (!file.Open(cacheFile) || file.GetSize() < sizeof(GeometryCacheHeader)) {
+		file.Close();
+		return false;
+	}
+
+	const GeometryCacheHeader* header = (const GeometryCacheHeader*)file.GetData();
+
+	// Stale or foreign caches, or ones cooked for another vertex format, are
+	// silently rebuilt from the source files
+	if (memcmp(header->m_magic, c_geometry_cache_magic, sizeof(header->m_magic)) != 0 ||
+		header->m_version != c_geometry_cache_version ||
+		header->m_vertexFormat != (unsigned int)vertexFormat ||
+		header->m_vertexSize != GetVertexSize(vertexFormat) ||
+		header->m_numSources != geometryFiles.size() ||
+		header->m_numFrames == 0 ||
+		header->m_numVertex == 0 ||
+		header->m_numIndex == 0 ||
+		header->m_numLODs == 0) {
+		file.Close();
+		return false;
+	}
+
+	unsigned int stampSize = header->m_numSources * sizeof(GeometryCacheStamp);
+	unsigned int lodSize = header->m_numLODs * sizeof(GeometryLOD);
+	unsigned int frameSize = header->m_numVertex * header->m_vertexSize;
+	unsigned int indexSize = header->m_numIndex * sizeof(GLuint);
+
+	if (file.GetSize() != sizeof(GeometryCacheHeader) + stampSize + lodSize + header->m_numFrames * frameSize + indexSize) {
+		file.Close();
+		return false;
+	}
+
+	const GeometryCacheStamp* stamps = (const GeometryCacheStamp*)(file.GetData() + sizeof(GeometryCacheHeader));
+
+	for (unsigned int i = 0; i < geometryFiles.size(); ++i) {
+		long long sourceSize;
+		long long sourceTime;
+
+		if (!GetFileStamp(geometryFiles[i], sourceSize, sourceTime) ||
+			stamps[i].m_sourceSize != sourceSize ||
+			stamps[i].m_sourceTime != sourceTime) {
+			file.Close();
+			return false;
 		}
-		else if (tokens[0] == "f" && tokens.size() == 10) {
-			bool invalid = false;
-
-			unsigned int v1, vt1, vn1;
-			v1 = ConvertString<int>(tokens[1]) - 1;
-			invalid |= v1 >= vertexes.size();
-			vt1 = ConvertString<int>(tokens[2]) - 1;
-			invalid |= vt1 >= texCoords.size();
-			vn1 = ConvertString<int>(tokens[3]) - 1;
-			invalid |= vn1 >= normals.size();
-
-			unsigned int v2, vt2, vn2;
-			v2 = ConvertString<int>(tokens[4]) - 1;
-			invalid |= v2 >= vertexes.size();
-			vt2 = ConvertString<int>(tokens[5]) - 1;
-			invalid |= vt2 >= texCoords.size();
-			vn2 = ConvertString<int>(tokens[6]) - 1;
-			invalid |= vn2 >= normals.size();
-
-			unsigned int v3, vt3, vn3;
-			v3 = ConvertString<int>(tokens[7]) - 1;
-			invalid |= v3 >= vertexes.size();
-			vt3 = ConvertString<int>(tokens[8]) - 1;
-			invalid |= vt3 >= texCoords.size();
-			vn3 = ConvertString<int>(tokens[9]) - 1;
-			invalid |= vn3 >= normals.size();
-
-			if (invalid) {
-				printf("GeometryManager::LoadOBJFile: Invalid triangle\n");
-				continue;
-			}
+	}
+
+	const GeometryLOD* lodData = (const GeometryLOD*)(file.GetData() + sizeof(GeometryCacheHeader) + stampSize);
 
-			geometryData.push_back(Vertex(vertexes[v1], normals[vn1], texCoords[vt1]));
-			geometryData.push_back(Vertex(vertexes[v2], normals[vn2], texCoords[vt2]));
-			geometryData.push_back(Vertex(vertexes[v3], normals[vn3], texCoords[vt3]));
+	for (unsigned int i = 0; i < header->m_numLODs; ++i) {
+		if (lodData[i].m_firstIndex + lodData[i].m_numIndex > header->m_numIndex) {
+			file.Close();
+			return false;
 		}
 	}
-	
-	int dataSize = geometryData.size() * sizeof(Vertex);
 
-	if (dataSize == 0) {
-		printf("GeometryManager::LoadOBJFile: Empty model file %s\n", geometryFile.c_str());
+	const char* vertexData = file.GetData() + sizeof(GeometryCacheHeader) + stampSize + lodSize;
+
+	cookedGeometry.m_vertexFormat = vertexFormat;
+	cookedGeometry.m_vertexDecode = header->m_vertexDecode;
+	cookedGeometry.m_boundingCenter = header->m_boundingCenter;
+	cookedGeometry.m_boundingRadius = header->m_boundingRadius;
+
+	for (unsigned int i = 0; i < header->m_numFrames; ++i)
+		cookedGeometry.m_frameData.push_back(vertexData + i * frameSize);
+
+	cookedGeometry.m_numVertex = header->m_numVertex;
+	cookedGeometry.m_lods.assign(lodData, lodData + header->m_numLODs);
+	cookedGeometry.m_indexData = (const GLuint*)(vertexData + header->m_numFrames * frameSize);
+	cookedGeometry.m_numIndex = header->m_numIndex;
+
+	return true;
+}
+
+void GeometryManager::WriteCacheFile (const std::vector<std::string>& geometryFiles, const std::string& cacheFile, const CookedGeometry& cookedGeometry) {
+	std::vector<GeometryCacheStamp> stamps(geometryFiles.size());
+
+	// A missing source can't be checked for changes later, so don't cache it
+	for (unsigned int i = 0; i < geometryFiles.size(); ++i) {
+		if (!GetFileStamp(geometryFiles[i], stamps[i].m_sourceSize, stamps[i].m_sourceTime))
+			return;
+	}
+
+	// Every member is four bytes wide, so there are no padding bytes for the
+	// file to pick up
+	GeometryCacheHeader header = GeometryCacheHeader();
+
+	memcpy(header.m_magic, c_geometry_cache_magic, sizeof(header.m_magic));
+	header.m_version = c_geometry_cache_version;
+	header.m_vertexSize = GetVertexSize(cookedGeometry.m_vertexFormat);
+	header.m_vertexFormat = cookedGeometry.m_vertexFormat;
+	header.m_geometryMode = e_GeometryModeTriangles;
+	header.m_numSources = stamps.size();
+	header.m_numFrames = cookedGeometry.m_frameData.size();
+	header.m_numVertex = cookedGeometry.m_numVertex;
+	header.m_numIndex = cookedGeometry.m_numIndex;
+	header.m_numLODs = cookedGeometry.m_lods.size();
+	header.m_vertexDecode = cookedGeometry.m_vertexDecode;
+	header.m_boundingCenter = cookedGeometry.m_boundingCenter;
+	header.m_boundingRadius = cookedGeometry.m_boundingRadius;
+
+	FILE* file = fopen(cacheFile.c_str(), "wb");
+
+	if (file == NULL) {
+		printf("GeometryManager::WriteCacheFile: Error writing %s.\n", cacheFile.c_str());
+		return;
+	}
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+				   fwrite(&stamps[0], sizeof(GeometryCacheStamp), stamps.size(), file) == stamps.size() &&
+				   fwrite(&cookedGeometry.m_lods[0], sizeof(GeometryLOD), header.m_numLODs, file) == header.m_numLODs;
+
+	for (unsigned int i = 0; i < header.m_numFrames && written; ++i)
+		written = fwrite(cookedGeometry.m_frameData[i], header.m_vertexSize, header.m_numVertex, file) == header.m_numVertex;
+
+	written = written && fwrite(cookedGeometry.m_indexData, sizeof(GLuint), header.m_numIndex, file) == header.m_numIndex;
+
+	fclose(file);
+
+	// Never leave a partial cache behind
+	if (!written) {
+		printf("GeometryManager::WriteCacheFile: Error writing %s.\n", cacheFile.c_str());
+		remove(cacheFile.c_str());
+	}
+}
+
+Geometry* GeometryManager::UploadGeometry (const CookedGeometry& cookedGeometry) {
+	Geometry* geometry = new Geometry();
+	geometry->m_geometryMode = e_GeometryModeTriangles;
+	geometry->m_numVertex = cookedGeometry.m_numVertex;
+	geometry->m_numIndex = cookedGeometry.m_numIndex;
+	geometry->m_lods = cookedGeometry.m_lods;
+	geometry->m_vertexFormat = cookedGeometry.m_vertexFormat;
+	geometry->m_vertexDecode = cookedGeometry.m_vertexDecode;
+	geometry->m_boundingCenter = cookedGeometry.m_boundingCenter;
+	geometry->m_boundingRadius = cookedGeometry.m_boundingRadius;
+
+	const std::vector<const void*>& frameData = cookedGeometry.m_frameData;
+	unsigned int numVertex = cookedGeometry.m_numVertex;
+	unsigned int numIndex = cookedGeometry.m_numIndex;
+
+	unsigned int frameUnits = numVertex * GetVertexSize(cookedGeometry.m_vertexFormat) / c_vertex_arena_unit;
+
+	// Keyframes go in one range so the geometry is released in one piece
+	if (!m_vertexArena->Allocate(frameUnits * frameData.size(), geometry->m_vertexRange) ||
+		!m_indexArena->Allocate(numIndex, geometry->m_indexRange)) {
+		printf("GeometryManager::UploadGeometry: Out of buffer memory.\n");
+		m_vertexArena->Release(geometry->m_vertexRange);
+		delete geometry;
 		return NULL;
 	}
 
-	glBufferSubData(GL_ARRAY_BUFFER, m_vertexDataUsed, dataSize, &geometryData[0]);
+	for (unsigned int i = 0; i < frameData.size(); ++i) {
+		m_vertexArena->Upload(geometry->m_vertexRange, i * frameUnits, frameUnits, frameData[i]);
+		geometry->m_vertexDataStarts.push_back((geometry->m_vertexRange.m_start + i * frameUnits) * c_vertex_arena_unit);
+	}
+
+	// Indexes are relative to each keyframe's vertex data start, which the
+	// attribute pointers already point at
+	m_indexArena->Upload(geometry->m_indexRange, 0, numIndex, cookedGeometry.m_indexData);
+	geometry->m_indexDataStart = geometry->m_indexRange.m_start * sizeof(GLuint);
 
 	GLenum error = glGetError();
 	if (error) {
 		std::cout << error;
+		m_vertexArena->Release(geometry->m_vertexRange);
+		m_indexArena->Release(geometry->m_indexRange);
+		delete geometry;
 		return NULL;
 	}
 
-	Geometry* geometry = new Geometry();
-	geometry->m_geometryMode = e_GeometryModeTriangles;
-	geometry->m_numVertex = dataSize / sizeof(Vertex);
-	geometry->m_vertexDataStarts.push_back(m_vertexDataUsed);
-
-	m_vertexDataUsed += dataSize;
-
 	return geometry;
-}
\ No newline at end of file
+}
@@ -1,33 +1,86 @@
 #ifndef __GEOMETRYMANAGER_H__
 #define __GEOMETRYMANAGER_H__
 
-#include <map>
+#include <string>
+#include <vector>
 
 #include "Angel.h"
 
-struct Vertex;
+#include "AssetID.h"
+#include "Vertex.h"
+
 struct Geometry;
+struct GeometryLOD;
 struct AttributeLocation;
+struct CookedGeometry;
+class BufferArena;
+class AssetLoader;
 
 class GeometryManager
 {
 public:
-	GeometryManager (const std::string& assetFile);
+	// Library entries are queued on assetLoader and only become available once
+	// it has finished
+	GeometryManager (const std::string& assetFile, AssetLoader& assetLoader);
 	~GeometryManager ();
 
-	AttributeLocation GetAttributeLocation (const std::string& geometryID, float animationTime);
-	void RenderGeometry (const std::string& geometryID);
+	AttributeLocation GetAttributeLocation (AssetID geometryID, float animationTime);
+	// More than one instance draws instanced, the per instance values come
+	// from the shader's instance buffer
+	void RenderGeometry (AssetID geometryID, unsigned int lod = 0, unsigned int numInstances = 1);
+
+	// Projected diameter of the geometry's bounding sphere as a fraction of
+	// the screen height, 1 when the sphere reaches behind the eye.  depth is
+	// the distance of the sphere's center along the view axis.
+	float GetScreenSize (AssetID geometryID, const mat4& modelMatrix, const mat4& viewProjectionMatrix, float& depth) const;
+
+	// The geometry's bounding sphere moved by modelMatrix, false for unknown
+	// geometry.  Scaled by the largest axis scale so it still holds everything.
+	bool GetBoundingSphere (AssetID geometryID, const mat4& modelMatrix, vec3& center, float& radius) const;
+
+	// Level of detail for the geometry's screen size, 0 is full detail
+	unsigned int SelectLOD (AssetID geometryID, float screenSize) const;
+
+	// Loads or replaces a single geometry at runtime, the same way entries in
+	// the geometry library are loaded
+	bool LoadGeometry (AssetID geometryID, const std::vector<std::string>& geometryFiles, VertexFormat vertexFormat = e_VertexFormatFull);
+
+	// Loads or replaces a single frame geometry built at runtime from an
+	// indexed triangle list, with no further levels of detail
+	bool LoadGeometry (AssetID geometryID, const std::vector<Vertex>& vertexes, const std::vector<GLuint>& indexes, VertexFormat vertexFormat = e_VertexFormatFull);
+
+	// As above, with lods as ranges of indexes from full detail to coarsest
+	bool LoadGeometry (AssetID geometryID, const std::vector<Vertex>& vertexes, const std::vector<GLuint>& indexes, const std::vector<GeometryLOD>& lods, VertexFormat vertexFormat);
+	void ReleaseGeometry (AssetID geometryID);
+
+	// Reads the first frame and the indexes of every level back from the GL
+	// buffers, packed vertexes are decoded and lods are ranges of indexes
+	bool ReadGeometry (AssetID geometryID, std::vector<Vertex>& vertexes, std::vector<GLuint>& indexes, std::vector<GeometryLOD>& lods) const;
+
+	void PrintBufferUsage () const;
 
 private:
-	void InitBuffer (unsigned int size);
+	friend class GeometryLoadJob;
+
+	void InitBuffer (unsigned int pageSize);
+
+	Geometry* GetGeometry (AssetID geometryID) const;
+	bool AddGeometry (AssetID geometryID, const CookedGeometry& cookedGeometry);
+
+	// Cooking touches no GL or manager state so it can run on any thread
+	static bool CookGeometry (const std::string& geometryName, const std::vector<std::string>& geometryFiles, VertexFormat vertexFormat, CookedGeometry& cookedGeometry);
+	static bool LoadCacheFile (const std::vector<std::string>& geometryFiles, const std::string& cacheFile, VertexFormat vertexFormat, CookedGeometry& cookedGeometry);
+	static void WriteCacheFile (const std::vector<std::string>& geometryFiles, const std::string& cacheFile, const CookedGeometry& cookedGeometry);
 
-	Geometry* LoadOBJFile (const std::string& geometryFile);
+	Geometry* UploadGeometry (const CookedGeometry& cookedGeometry);
 
-	std::map<std::string, Geometry*> m_geometry;
+	// Indexed by AssetID, NULL where no geometry has that name
+	std::vector<Geometry*> m_geometry;
+	unsigned int m_numGeometry;
 
 	GLuint m_vao;
-	GLuint m_buffer;
-	unsigned int m_vertexDataUsed;
+	BufferArena* m_vertexArena;
+	BufferArena* m_indexArena;
 };
 
 #endif
\ No newline at end of file
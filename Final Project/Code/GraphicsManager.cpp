@@ -1,6 +1,7 @@
 #include "GraphicsManager.h"
 
 #include <fstream>
+#include <string.h>
 
 #include "ForwardShader.h"
 #include "PostProcessShader.h"
@@ -12,15 +13,50 @@
 
 #include "FrameBufferTexture.h"
 #include "RenderPass.h"
+#include "RenderGraph.h"
 
 #include "RenderBatch.h"
 #include "CachedRenderBatch.h"
 #include "ForwardShaderState.h"
 #include "Geometry.h"
+#include "AttributeLocation.h"
+
+#include "StaticGeometry.h"
+#include "GLStateCache.h"
+#include "UniformBlocks.h"
+#include "WorkerPool.h"
+#include "OcclusionCuller.h"
+#include "DrawListJob.h"
+#include "AssetLoader.h"
+#include "Timer.h"
+
+// Frames between render stat reports
+static const unsigned int c_render_stats_frames = 600;
+
+// Side of the square chunks static geometry is baked into, in world units
+static const float c_static_chunk_size = 50.0f;
+
+// Resolution of the occlusion buffer, 4:3 like the default window
+static const unsigned int c_occlusion_width = 256;
+static const unsigned int c_occlusion_height = 192;
+
+// Batches a draw list job gets at least.  drawlistbench puts waking a worker
+// at the cost of 100 to 130 batches, so a job of this many spends at most a
+// quarter of its time being dispatched.
+static const unsigned int c_min_draw_list_batches = 512;
 
 GraphicsManager::GraphicsManager (const std::string& assetLibrary) 
-	: m_forwardShader(NULL), m_postProcessShader(NULL), m_geometryManager(NULL), m_textureManager(NULL), m_assetLibrary(assetLibrary)
+	: m_forwardShader(NULL), m_postProcessShader(NULL), m_geometryManager(NULL), m_textureManager(NULL), m_assetLibrary(assetLibrary),
+	  m_frameParameterBlock(0), m_submitAllocations(0), m_frustumValid(false), m_visibleBatches(0), m_culledBatches(0), m_occlusionStarted(false), m_occludedBatches(0), m_statsFrames(0), m_statsDraws(0), m_statsDrawCalls(0), m_statsInstancedDrawCalls(0), m_statsFrameUploads(0), m_statsIssuedCalls(0), m_statsElidedCalls(0), m_statsParameterBlocks(0), m_statsSubmitAllocations(0), m_statsVisibleBatches(0), m_statsCulledBatches(0), m_statsOccludedBatches(0), m_statsOccluders(0), m_statsOcclusionTime(0.0f), m_statsDrawListBatches(0), m_statsDrawListTime(0.0f), m_statsSortTime(0.0f)
 {
+	m_workerPool = new WorkerPool();
+	m_staticGeometry = new StaticGeometry(c_static_chunk_size);
+	m_occlusionCuller = new OcclusionCuller(*m_workerPool, c_occlusion_width, c_occlusion_height);
+
+	glGenBuffers(1, &m_frameUniformBuffer);
+	GLStateCache::Get().BindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_STREAM_DRAW);
+
 	ReloadAssets();
 
 	glAlphaFunc(GL_GREATER,0.1f);
@@ -29,6 +65,15 @@ GraphicsManager::GraphicsManager (const std::string& assetLibrary)
 
 GraphicsManager::~GraphicsManager () {
 	ClearAssets();
+
+	GLStateCache::Get().DeleteBuffer(m_frameUniformBuffer);
+
+	for (unsigned int i = 0; i < m_drawListJobs.size(); ++i)
+		delete m_drawListJobs[i];
+
+	delete m_staticGeometry;
+	delete m_occlusionCuller;
+	delete m_workerPool;
 }
 
 void GraphicsManager::ClearAssets () {
@@ -54,12 +99,18 @@ void GraphicsManager::ClearAssets () {
 
 	m_renderPasses.clear();
 
-	for (std::map<std::string, FrameBufferTexture*>::iterator iter = m_frameBufferTextures.begin(); iter != m_frameBufferTextures.end(); ++iter)
-		delete iter->second;
+	for (unsigned int i = 0; i < m_passShaderStates.size(); ++i)
+		delete m_passShaderStates[i];
+
+	m_passShaderStates.clear();
+
+	for (unsigned int i = 0; i < m_renderTargets.size(); ++i)
+		delete m_renderTargets[i];
 
+	m_renderTargets.clear();
 	m_frameBufferTextures.clear();
 
-	glDeleteFramebuffers(1, &m_fbo);
+	GLStateCache::Get().DeleteFramebuffer(m_fbo);
 }
 
 void GraphicsManager::ReloadAssets () {
@@ -82,11 +133,26 @@ void GraphicsManager::ReloadAssets () {
 
 		is.close();
 
+		Timer loadTimer;
+
 		glGenFramebuffers(1, &m_fbo);  
 
-		m_geometryManager = new GeometryManager(geometryLibrary);
+		// Geometry and textures are read and decoded on the worker pool while
+		// the shaders compile here, then uploaded as they come in
+		AssetLoader assetLoader(*m_workerPool);
+
+		m_geometryManager = new GeometryManager(geometryLibrary, assetLoader);
+		m_textureManager = new TextureManager(textureLibrary, assetLoader, Settings::Get().s_textureBudget);
 		LoadEffectFile (effectFile);	// Dependent upon vertex buffers being setup
-		m_textureManager = new TextureManager(textureLibrary);
+
+		assetLoader.Finish();
+
+		if (!m_staticGeometry->IsEmpty())
+			m_staticGeometry->Build(*m_geometryManager);
+
+		m_geometryManager->PrintBufferUsage();
+
+		printf("GraphicsManager::ReloadAssets: Loaded assets in %.1f ms.\n", loadTimer.GetElapsedTime() * 1000.0f);
    }           
 }
 
@@ -99,6 +165,8 @@ void GraphicsManager::LoadEffectFile (const std::string& effectFile) {
 		return;
 	}
 
+	RenderGraph renderGraph;
+
 	while (is.good()) {
 		std::string header;
 		is >> header;      
@@ -138,13 +206,8 @@ void GraphicsManager::LoadEffectFile (const std::string& effectFile) {
 				float heightRatio;
 
 				is >> bufferName >> bufferFormat >> widthRatio >> heightRatio;
-				
-				std::map<std::string, FrameBufferTexture*>::iterator iter = m_frameBufferTextures.find(bufferName);
-				if (iter != m_frameBufferTextures.end())
-					continue;
 
-				FrameBufferTexture* texture = new FrameBufferTexture(bufferFormat, Settings::Get().s_windowWidth * widthRatio, Settings::Get().s_windowHeight * heightRatio);
-				m_frameBufferTextures[bufferName] = texture;
+				renderGraph.AddBuffer(bufferName, bufferFormat, widthRatio, heightRatio);
 			}
 		}
 		else if (header == "passes") {
@@ -158,6 +221,7 @@ void GraphicsManager::LoadEffectFile (const std::string& effectFile) {
 				is >> passName >> numOptions;
 
 				RenderPass renderPass;
+				renderPass.m_name = passName;
 
 				while (numOptions--) {
 					std::string settingType;
@@ -221,26 +285,530 @@ void GraphicsManager::LoadEffectFile (const std::string& effectFile) {
 					}
 				}
 
-				m_renderPasses.push_back(renderPass);
+				renderGraph.AddPass(renderPass);
+			}
+		}
+	}
+
+	// Only buffers the remaining passes use get a texture, and buffers whose
+	// lifetimes don't overlap share one
+	if (!renderGraph.Compile(Settings::Get().s_windowWidth, Settings::Get().s_windowHeight))
+		return;
+
+	m_renderPasses = renderGraph.GetPasses();
+
+	const std::vector<RenderTarget>& targets = renderGraph.GetTargets();
+
+	for (unsigned int i = 0; i < targets.size(); ++i)
+		m_renderTargets.push_back(new FrameBufferTexture(targets[i].m_format, targets[i].m_width, targets[i].m_height));
+
+	const std::map<std::string, int>& bufferTargets = renderGraph.GetBufferTargets();
+
+	for (std::map<std::string, int>::const_iterator iter = bufferTargets.begin(); iter != bufferTargets.end(); ++iter)
+		m_frameBufferTextures[iter->first] = m_renderTargets[iter->second];
+
+	// Flags and shader states are worked out here once, rather than by every
+	// pass of every frame
+	for (std::vector<RenderPass>::iterator passIter = m_renderPasses.begin(); passIter != m_renderPasses.end(); ++passIter) {
+		std::vector<std::string> shaderStateFlags;
+
+		for (std::vector<std::string>::iterator flagIter = passIter->m_flags.begin(); flagIter != passIter->m_flags.end(); ++flagIter) {
+			if (*flagIter == "clearColor") {
+				passIter->m_clearFlags |= GL_COLOR_BUFFER_BIT;
+			}
+			else if (*flagIter == "clearDepth") {
+				passIter->m_clearFlags |= GL_DEPTH_BUFFER_BIT;
+			}
+			else if (*flagIter == "blend") {
+				passIter->m_blend = true;
+			}
+			else if (*flagIter == "alphaTest") {
+				passIter->m_alphaTest = true;
+			}
+			// Let shader state try to handle the flag
+			else {
+				shaderStateFlags.push_back(*flagIter);
 			}
 		}
+
+		ShaderState* state;
+
+		if (passIter->m_shaderType == e_ShaderTypeForward)
+			state = new ForwardShaderState();
+		else
+			state = new PostProcessShaderState();
+
+		state->HandleShaderFlags(shaderStateFlags);
+		m_passShaderStates.push_back(state);
 	}
 }
 
 void GraphicsManager::ClearScreen () {
-	m_cachedRenderBatches[e_GeometryTypeOpaque].clear();
-	m_cachedRenderBatches[e_GeometryTypeTransparent].clear();
-	m_cachedRenderBatches[e_GeometryTypeHUD].clear();
-	m_cachedRenderBatches[e_GeometryTypeScreenQuad].clear();
+	m_cachedRenderBatches.clear();
+	m_parameterBlocks.clear();
+	m_submitAllocations = 0;
+	m_visibleBatches = 0;
+	m_culledBatches = 0;
+	m_occlusionStarted = false;
+	m_occludedBatches = 0;
+	m_renderQueue.Clear();
+}
+
+unsigned int GraphicsManager::GetParameterBlock () {
+	// RenderParameters is all floats and ints without padding, so comparing
+	// the bytes is exact
+	if (m_parameterBlocks.empty() || memcmp(&m_parameterBlocks.back(), &m_renderParameters, sizeof(RenderParameters)) != 0) {
+		m_submitAllocations += m_parameterBlocks.size() == m_parameterBlocks.capacity() ? 1 : 0;
+		m_parameterBlocks.push_back(m_renderParameters);
+	}
+
+	return m_parameterBlocks.size() - 1;
+}
+
+unsigned int GraphicsManager::AddCachedBatch (const RenderBatch& batch, unsigned int lod, float screenSize) {
+	unsigned int batchIndex = m_cachedRenderBatches.size();
+
+	m_submitAllocations += batchIndex == m_cachedRenderBatches.capacity() ? 1 : 0;
+	m_cachedRenderBatches.push_back(CachedRenderBatch(batch, GetParameterBlock(), lod, screenSize));
+
+	return batchIndex;
 }
 
 void GraphicsManager::Render (const RenderBatch& batch) {
-	if (batch.m_effectParameters.m_HUDRender)
-		m_cachedRenderBatches[e_GeometryTypeHUD].push_back(CachedRenderBatch(batch, m_renderParameters));
-	else if (batch.m_effectParameters.m_materialOpacity < 1.0f || m_textureManager->IsTransparent(batch.m_effectParameters.m_diffuseTexture))
-		m_cachedRenderBatches[e_GeometryTypeTransparent].push_back(CachedRenderBatch(batch, m_renderParameters));
+	if (batch.m_effectParameters.m_HUDRender) {
+		unsigned int batchIndex = AddCachedBatch(batch);
+		m_renderQueue.Add(RenderQueue::MakeOrderedKey(e_GeometryTypeHUD, batchIndex), batchIndex);
+		return;
+	}
+
+	GetViewFrustum();
+
+	unsigned int lod;
+	float screenSize;
+	SortKey sortKey;
+
+	// Batches the camera can't see never reach the queue
+	if (!BuildDraw(batch, lod, screenSize, sortKey)) {
+		++m_culledBatches;
+		return;
+	}
+
+	++m_visibleBatches;
+
+	StartOcclusion();
+
+	m_renderQueue.Add(sortKey, AddCachedBatch(batch, lod, screenSize));
+}
+
+void GraphicsManager::Render (const std::vector<const RenderBatch*>& batches) {
+	if (batches.empty())
+		return;
+
+	Timer buildTimer;
+
+	// Everything the jobs read is brought up to date here first
+	GetViewFrustum();
+	unsigned int parameterBlock = GetParameterBlock();
+
+	StartOcclusion();
+
+	if (m_drawListJobs.empty()) {
+		for (unsigned int i = 0; i <= m_workerPool->GetNumThreads(); ++i)
+			m_drawListJobs.push_back(new DrawListJob(*this));
+	}
+
+	unsigned int numJobs = batches.size() / c_min_draw_list_batches;
+	numJobs = numJobs < 1 ? 1 : (numJobs > m_drawListJobs.size() ? m_drawListJobs.size() : numJobs);
+
+	// This thread builds the last range while the workers build the others
+	for (unsigned int i = 0; i < numJobs; ++i) {
+		unsigned int first = batches.size() * i / numJobs;
+		unsigned int last = batches.size() * (i + 1) / numJobs;
+
+		m_drawListJobs[i]->Start(&batches[first], last - first, parameterBlock);
+
+		if (i + 1 < numJobs)
+			m_workerPool->Submit(m_drawListJobs[i]);
+		else
+			m_drawListJobs[i]->Run();
+	}
+
+	// Merged in range order, so the frame comes out the same whatever the
+	// number of threads
+	for (unsigned int i = 0; i < numJobs; ++i) {
+		DrawListJob& job = *m_drawListJobs[i];
+		job.Wait();
+
+		unsigned int firstBatch = m_cachedRenderBatches.size();
+
+		m_culledBatches += job.m_numCulled;
+		m_submitAllocations += job.m_allocations;
+		m_submitAllocations += m_cachedRenderBatches.capacity() < firstBatch + job.m_cachedRenderBatches.size() ? 1 : 0;
+
+		m_cachedRenderBatches.insert(m_cachedRenderBatches.end(), job.m_cachedRenderBatches.begin(), job.m_cachedRenderBatches.end());
+
+		for (unsigned int j = 0; j < job.m_packets.size(); ++j) {
+			DrawPacket packet = job.m_packets[j];
+			packet.m_batch += firstBatch;
+
+			// The HUD is drawn in submission order, which is only known now
+			if (RenderQueue::GetGeometryType(packet.m_sortKey) == e_GeometryTypeHUD)
+				packet.m_sortKey = RenderQueue::MakeOrderedKey(e_GeometryTypeHUD, packet.m_batch);
+			else
+				++m_visibleBatches;
+
+			m_renderQueue.Add(packet.m_sortKey, packet.m_batch);
+		}
+	}
+
+	m_statsDrawListBatches += batches.size();
+	m_statsDrawListTime += buildTimer.GetElapsedTime();
+}
+
+bool GraphicsManager::BuildDraw (const RenderBatch& batch, unsigned int& lod, float& screenSize, SortKey& sortKey) const {
+	lod = 0;
+	screenSize = 1.0f;
+
+	if (batch.m_effectParameters.m_HUDRender) {
+		sortKey = RenderQueue::MakeOrderedKey(e_GeometryTypeHUD, 0);
+		return true;
+	}
+
+	if (!IsInFrustum(batch))
+		return false;
+
+	float depth;
+	screenSize = m_geometryManager->GetScreenSize(batch.m_geometryID, batch.m_effectParameters.m_modelviewMatrix, m_renderParameters.m_projectionMatrix, depth);
+	lod = m_geometryManager->SelectLOD(batch.m_geometryID, screenSize);
+
+	if (batch.m_effectParameters.m_materialOpacity < 1.0f || m_textureManager->IsTransparent(batch.m_effectParameters.m_diffuseTexture))
+		sortKey = RenderQueue::MakeTransparentKey(GetDrawState(batch), depth);
 	else
-		m_cachedRenderBatches[e_GeometryTypeOpaque].push_back(CachedRenderBatch(batch, m_renderParameters));
+		sortKey = RenderQueue::MakeOpaqueKey(GetDrawState(batch), depth);
+
+	return true;
+}
+
+void GraphicsManager::StartOcclusion () {
+	// Every batch outside the HUD shares the projection, so the occluders can
+	// be rasterized while the rest of the frame comes in
+	if (m_occlusionStarted || !Settings::Get().s_occlusionCulling)
+		return;
+
+	m_occlusionCuller->Begin(m_renderParameters.m_projectionMatrix);
+	m_occlusionStarted = true;
+}
+
+void GraphicsManager::AddStaticBatch (const RenderBatch& batch) {
+	m_staticGeometry->Add(batch);
+}
+
+void GraphicsManager::BuildStaticGeometry () {
+	if (m_geometryManager == NULL)
+		return;
+
+	m_staticGeometry->Build(*m_geometryManager);
+	m_geometryManager->PrintBufferUsage();
+}
+
+void GraphicsManager::AddOccluder (const vec3& minimum, const vec3& maximum) {
+	m_occlusionCuller->AddOccluder(minimum, maximum);
+}
+
+void GraphicsManager::RenderStaticGeometry () {
+	m_staticBatches.clear();
+	m_staticGeometry->GetVisibleBatches(GetViewFrustum(), m_staticBatches);
+
+	Render(m_staticBatches);
+}
+
+const ViewFrustum& GraphicsManager::GetViewFrustum () {
+	// The projection normally only changes once a frame
+	if (!m_frustumValid || memcmp(&m_frustumProjection, &m_renderParameters.m_projectionMatrix, sizeof(mat4)) != 0) {
+		m_frustum = ViewFrustum(m_renderParameters.m_projectionMatrix);
+		m_frustumProjection = m_renderParameters.m_projectionMatrix;
+		m_frustumValid = true;
+	}
+
+	return m_frustum;
+}
+
+bool GraphicsManager::IsInFrustum (const RenderBatch& batch) const {
+	vec3 center;
+	float radius;
+
+	if (!m_geometryManager->GetBoundingSphere(batch.m_geometryID, batch.m_effectParameters.m_modelviewMatrix, center, radius))
+		return true;
+
+	return m_frustum.IntersectsSphere(center, radius);
+}
+
+void GraphicsManager::CullOccludedBatches () {
+	if (!m_occlusionCuller->Finish())
+		return;
+
+	m_batchOccluded.assign(m_cachedRenderBatches.size(), false);
+
+	for (unsigned int i = 0; i < m_renderQueue.GetNumPackets(); ++i) {
+		const DrawPacket& packet = m_renderQueue.GetPacket(i);
+		GeometryType geometryType = RenderQueue::GetGeometryType(packet.m_sortKey);
+
+		if (geometryType != e_GeometryTypeOpaque && geometryType != e_GeometryTypeTransparent)
+			continue;
+
+		const RenderBatch& batch = m_cachedRenderBatches[packet.m_batch].m_renderBatch;
+
+		vec3 center;
+		float radius;
+
+		if (!m_geometryManager->GetBoundingSphere(batch.m_geometryID, batch.m_effectParameters.m_modelviewMatrix, center, radius))
+			continue;
+
+		if (m_occlusionCuller->IsOccluded(center, radius)) {
+			m_batchOccluded[packet.m_batch] = true;
+			++m_occludedBatches;
+		}
+	}
+
+	if (m_occludedBatches > 0)
+		m_renderQueue.RemoveBatches(m_batchOccluded);
+
+	m_statsOccluders += m_occlusionCuller->GetNumRasterized();
+	m_statsOcclusionTime += m_occlusionCuller->GetRasterizeTime();
+}
+
+DrawState GraphicsManager::GetDrawState (const RenderBatch& batch) const {
+	DrawState drawState;
+
+	drawState.m_diffuseTexture = m_textureManager->GetTextureKey(batch.m_effectParameters.m_diffuseTexture);
+	drawState.m_normalMap = m_textureManager->GetTextureKey(batch.m_effectParameters.m_normalMap);
+	drawState.m_geometry = batch.m_geometryID.GetIndex();
+	drawState.m_twoSided = batch.m_effectParameters.m_twoSided;
+
+	return drawState;
+}
+
+bool GraphicsManager::CanInstance (const CachedRenderBatch& first, const CachedRenderBatch& other) {
+	const EffectParameters& firstParameters = first.m_renderBatch.m_effectParameters;
+	const EffectParameters& otherParameters = other.m_renderBatch.m_effectParameters;
+
+	if (first.m_renderBatch.m_geometryID != other.m_renderBatch.m_geometryID || first.m_lod != other.m_lod)
+		return false;
+
+	// Layers of one texture array share a key, the layer goes per instance
+	if (m_textureManager->GetTextureKey(firstParameters.m_diffuseTexture) != m_textureManager->GetTextureKey(otherParameters.m_diffuseTexture) ||
+		firstParameters.m_normalMap != otherParameters.m_normalMap || firstParameters.m_twoSided != otherParameters.m_twoSided) {
+		return false;
+	}
+
+	// The material colors are combined with the lights into uniforms
+	if (firstParameters.m_materialAmbient != otherParameters.m_materialAmbient || firstParameters.m_materialDiffuse != otherParameters.m_materialDiffuse ||
+		firstParameters.m_materialSpecular != otherParameters.m_materialSpecular || firstParameters.m_materialSpecularExponent != otherParameters.m_materialSpecularExponent) {
+		return false;
+	}
+
+	if (firstParameters.m_animationTime == otherParameters.m_animationTime)
+		return true;
+
+	// Instances share the vertex attributes, so animated ones have to be
+	// between the same two frames
+	AttributeLocation firstLocation = m_geometryManager->GetAttributeLocation(first.m_renderBatch.m_geometryID, firstParameters.m_animationTime);
+	AttributeLocation otherLocation = m_geometryManager->GetAttributeLocation(other.m_renderBatch.m_geometryID, otherParameters.m_animationTime);
+
+	return firstLocation.m_position0 == otherLocation.m_position0 && firstLocation.m_position1 == otherLocation.m_position1;
+}
+
+void GraphicsManager::GroupInstances (unsigned int firstPacket, unsigned int lastPacket, bool reorder) {
+	m_drawBatches.clear();
+	m_drawSizes.clear();
+
+	// Without reordering only neighbours can share a draw
+	if (!reorder) {
+		for (unsigned int packet = firstPacket; packet < lastPacket; ++packet) {
+			unsigned int batch = m_renderQueue.GetPacket(packet).m_batch;
+
+			if (!m_drawBatches.empty() && CanInstance(m_cachedRenderBatches[m_drawBatches[m_drawBatches.size() - m_drawSizes.back()]], m_cachedRenderBatches[batch]))
+				++m_drawSizes.back();
+			else
+				m_drawSizes.push_back(1);
+
+			m_drawBatches.push_back(batch);
+		}
+
+		return;
+	}
+
+	// A run shares geometry and textures, so there are only a few draws in
+	// it, one for each level of detail, material or animation frame
+	m_grouped.assign(lastPacket - firstPacket, false);
+
+	for (unsigned int packet = firstPacket; packet < lastPacket; ++packet) {
+		if (m_grouped[packet - firstPacket])
+			continue;
+
+		const CachedRenderBatch& first = m_cachedRenderBatches[m_renderQueue.GetPacket(packet).m_batch];
+
+		m_drawBatches.push_back(m_renderQueue.GetPacket(packet).m_batch);
+		m_drawSizes.push_back(1);
+
+		for (unsigned int other = packet + 1; other < lastPacket; ++other) {
+			unsigned int batch = m_renderQueue.GetPacket(other).m_batch;
+
+			if (!m_grouped[other - firstPacket] && CanInstance(first, m_cachedRenderBatches[batch])) {
+				m_grouped[other - firstPacket] = true;
+				m_drawBatches.push_back(batch);
+				++m_drawSizes.back();
+			}
+		}
+	}
+}
+
+void GraphicsManager::UpdateFrameUniforms (unsigned int parameterBlock) {
+	if (parameterBlock == m_frameParameterBlock)
+		return;
+
+	FrameUniforms frameUniforms;
+	CalculateFrameUniforms(m_parameterBlocks[parameterBlock], frameUniforms);
+
+	// Orphaned since draws in flight may still read the previous values
+	GLStateCache::Get().BindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frameUniforms);
+	GLStateCache::Get().BindBufferBase(GL_UNIFORM_BUFFER, e_UniformBlockFrame, m_frameUniformBuffer);
+
+	m_frameParameterBlock = parameterBlock;
+
+	++m_statsFrameUploads;
+}
+
+void GraphicsManager::DrawBatches (UberShader* shader, ShaderState* state, const unsigned int* batches, unsigned int numBatches) {
+	const CachedRenderBatch& cachedBatch = m_cachedRenderBatches[batches[0]];
+	const RenderParameters& renderParameters = m_parameterBlocks[cachedBatch.m_renderParameters];
+
+	UpdateFrameUniforms(cachedBatch.m_renderParameters);
+
+	state->CalculateShaderState(renderParameters, cachedBatch.m_renderBatch.m_effectParameters);
+
+	GLStateCache::Get().SetCapability(GL_CULL_FACE, !cachedBatch.m_renderBatch.m_effectParameters.m_twoSided);
+
+	// Batches whose diffuse texture is a layer of an array all bind
+	// the same array and only differ in the layer
+	int diffuseLayer = m_textureManager->GetTextureLayer(cachedBatch.m_renderBatch.m_effectParameters.m_diffuseTexture);
+
+	// The largest instance picks the texture mips
+	float screenSize = 0.0f;
+	for (unsigned int i = 0; i < numBatches; ++i)
+		screenSize = m_cachedRenderBatches[batches[i]].m_screenSize > screenSize ? m_cachedRenderBatches[batches[i]].m_screenSize : screenSize;
+
+	// The sphere's diameter in pixels, how many texels it can show
+	unsigned int screenPixels = (unsigned int)(screenSize * Settings::Get().s_windowHeight) + 1;
+
+	state->b_useDiffuseArray = diffuseLayer >= 0;
+	state->m_diffuseLayer = diffuseLayer >= 0 ? (float)diffuseLayer : 0.0f;
+	state->b_useDiffuseTexture = m_textureManager->SetTexture(diffuseLayer >= 0 ? e_TextureChannelDiffuseArray : e_TextureChannelDiffuse, cachedBatch.m_renderBatch.m_effectParameters.m_diffuseTexture, screenPixels);
+	state->b_useEnvironmentMap = m_textureManager->SetTexture(e_TextureChannelEnvMap, renderParameters.m_environmentMap);
+	state->b_useNormalMap = m_textureManager->SetTexture(e_TextureChannelNormalMap, cachedBatch.m_renderBatch.m_effectParameters.m_normalMap, screenPixels);
+
+	state->SetAttributeLocation(m_geometryManager->GetAttributeLocation(cachedBatch.m_renderBatch.m_geometryID, cachedBatch.m_renderBatch.m_effectParameters.m_animationTime));
+	state->b_instanced = numBatches > 1;
+
+	if (state->b_instanced) {
+		m_instances.resize(numBatches);
+
+		for (unsigned int i = 0; i < numBatches; ++i) {
+			const EffectParameters& effectParameters = m_cachedRenderBatches[batches[i]].m_renderBatch.m_effectParameters;
+			int layer = m_textureManager->GetTextureLayer(effectParameters.m_diffuseTexture);
+
+			m_instances[i].m_modelviewMatrix = transpose(effectParameters.m_modelviewMatrix);
+			m_instances[i].m_parameters = vec4(fmod(effectParameters.m_animationTime, 1.0f), layer >= 0 ? (float)layer : 0.0f,
+				effectParameters.m_materialOpacity, effectParameters.m_materialGloss);
+		}
+
+		m_forwardShader->SetInstances(&m_instances[0], numBatches);
+	}
+
+	shader->SetShaderState(state);
+
+	m_geometryManager->RenderGeometry(cachedBatch.m_renderBatch.m_geometryID, cachedBatch.m_lod, numBatches);
+}
+
+StateChanges GraphicsManager::CountStateChanges () const {
+	StateChanges changes;
+
+	DrawState previous[e_GeometryTypeCount];
+	bool drawn[e_GeometryTypeCount] = { false, false, false, false };
+
+	for (unsigned int i = 0; i < m_renderQueue.GetNumPackets(); ++i) {
+		const DrawPacket& packet = m_renderQueue.GetPacket(i);
+		GeometryType geometryType = RenderQueue::GetGeometryType(packet.m_sortKey);
+
+		DrawState drawState = GetDrawState(m_cachedRenderBatches[packet.m_batch].m_renderBatch);
+
+		if (drawn[geometryType])
+			changes.Count(previous[geometryType], drawState);
+
+		previous[geometryType] = drawState;
+		drawn[geometryType] = true;
+	}
+
+	return changes;
+}
+
+void GraphicsManager::ReportRenderStats (const StateChanges& submittedChanges, const StateChanges& sortedChanges, float sortTime, unsigned int drawCalls, unsigned int instancedDrawCalls, unsigned int issuedCalls, unsigned int elidedCalls) {
+	++m_statsFrames;
+	m_statsDraws += m_renderQueue.GetNumPackets();
+	m_statsDrawCalls += drawCalls;
+	m_statsInstancedDrawCalls += instancedDrawCalls;
+	m_statsIssuedCalls += issuedCalls;
+	m_statsElidedCalls += elidedCalls;
+	m_statsParameterBlocks += m_parameterBlocks.size();
+	m_statsSubmitAllocations += m_submitAllocations + m_renderQueue.GetAllocations();
+	m_statsVisibleBatches += m_visibleBatches;
+	m_statsCulledBatches += m_culledBatches;
+	m_statsOccludedBatches += m_occludedBatches;
+	m_statsSubmittedChanges.Add(submittedChanges);
+	m_statsSortedChanges.Add(sortedChanges);
+	m_statsSortTime += sortTime;
+
+	if (m_statsFrames < c_render_stats_frames)
+		return;
+
+	float frames = (float)m_statsFrames;
+
+	printf("GraphicsManager::SwapBuffers: %.0f batches in %.0f draw calls (%.0f instanced) with %.1f frame uniform uploads and %.0f state changes a frame (%.0f texture, %.0f geometry, %.0f cull mode), %.0f in submission order, sorting took %.3f ms.\n",
+		m_statsDraws / frames, m_statsDrawCalls / frames, m_statsInstancedDrawCalls / frames, m_statsFrameUploads / frames, m_statsSortedChanges.GetTotal() / frames, m_statsSortedChanges.m_textures / frames, m_statsSortedChanges.m_geometry / frames,
+		m_statsSortedChanges.m_cullMode / frames, m_statsSubmittedChanges.GetTotal() / frames, m_statsSortTime * 1000.0f / frames);
+
+	printf("GraphicsManager::SwapBuffers: %.0f batches visible and %.0f culled by the view frustum a frame.\n", m_statsVisibleBatches / frames, m_statsCulledBatches / frames);
+	if (Settings::Get().s_occlusionCulling) {
+		printf("GraphicsManager::SwapBuffers: %.0f of the visible batches occluded a frame by %.0f of %u occluder boxes, rasterized in %.3f ms on a worker.\n",
+			m_statsOccludedBatches / frames, m_statsOccluders / frames, m_occlusionCuller->GetNumOccluders(), m_statsOcclusionTime * 1000.0f / frames);
+	}
+	printf("GraphicsManager::SwapBuffers: %.0f batches a frame built as draw lists on %u threads in %.3f ms.\n",
+		m_statsDrawListBatches / frames, (unsigned int)m_drawListJobs.size(), m_statsDrawListTime * 1000.0f / frames);
+	printf("GraphicsManager::SwapBuffers: %.0f GL state calls issued and %.0f elided as redundant a frame.\n", m_statsIssuedCalls / frames, m_statsElidedCalls / frames);
+	printf("GraphicsManager::SwapBuffers: %.1f parameter blocks and %.2f submission allocations a frame, %u bytes a batch.\n",
+		m_statsParameterBlocks / frames, m_statsSubmitAllocations / frames, (unsigned int)sizeof(CachedRenderBatch));
+
+	m_statsFrames = 0;
+	m_statsDraws = 0;
+	m_statsDrawCalls = 0;
+	m_statsInstancedDrawCalls = 0;
+	m_statsFrameUploads = 0;
+	m_statsIssuedCalls = 0;
+	m_statsElidedCalls = 0;
+	m_statsParameterBlocks = 0;
+	m_statsSubmitAllocations = 0;
+	m_statsVisibleBatches = 0;
+	m_statsCulledBatches = 0;
+	m_statsOccludedBatches = 0;
+	m_statsOccluders = 0;
+	m_statsOcclusionTime = 0.0f;
+	m_statsDrawListBatches = 0;
+	m_statsDrawListTime = 0.0f;
+	m_statsSubmittedChanges = StateChanges();
+	m_statsSortedChanges = StateChanges();
+	m_statsSortTime = 0.0f;
 }
 
 void GraphicsManager::SwapBuffers () {
@@ -248,9 +816,33 @@ void GraphicsManager::SwapBuffers () {
 		return;
 	
 	// Add the screenQuad batch for the postProcess step
+	static const AssetID c_screen_quad_geometry = "screenQuad";
+
 	RenderBatch screenQuad;
-	screenQuad.m_geometryID = "screenQuad";
-	m_cachedRenderBatches[e_GeometryTypeScreenQuad].push_back(CachedRenderBatch(screenQuad, m_renderParameters));
+	screenQuad.m_geometryID = c_screen_quad_geometry;
+
+	m_renderQueue.Add(RenderQueue::MakeOrderedKey(e_GeometryTypeScreenQuad, 0), AddCachedBatch(screenQuad));
+
+	CullOccludedBatches();
+
+	// Batches arrive in whatever order the game walks its objects, sorting
+	// groups the ones that share state
+	StateChanges submittedChanges = CountStateChanges();
+
+	Timer sortTimer;
+	m_renderQueue.Sort();
+	float sortTime = sortTimer.GetElapsedTime();
+
+	unsigned int drawCalls = 0;
+	unsigned int instancedDrawCalls = 0;
+
+	// Loading and texture streaming between frames set GL state directly
+	GLStateCache& stateCache = GLStateCache::Get();
+	stateCache.Invalidate();
+	stateCache.ResetCounters();
+
+	// Block indexes start over every frame
+	m_frameParameterBlock = ~0u;
 
 	for (std::vector<RenderPass>::iterator passIter = m_renderPasses.begin(); passIter != m_renderPasses.end(); ++passIter) {
 		unsigned int destinationWidth;
@@ -258,15 +850,15 @@ void GraphicsManager::SwapBuffers () {
 
 		// Setup FBO targets
 		if (passIter->m_colorAttach0 == "screen") {	
-			glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+			stateCache.BindFramebuffer(0);
 
 			destinationWidth = Settings::Get().s_windowWidth;
 			destinationHeight = Settings::Get().s_windowHeight;
 
-			glDisable(GL_DEPTH_TEST);
+			stateCache.SetCapability(GL_DEPTH_TEST, false);
 		}
 		else {
-			glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_fbo);
+			stateCache.BindFramebuffer(m_fbo);
 			
 			const FrameBufferTexture* colorAttach0 = GetFrameBufferTexture(passIter->m_colorAttach0);
 			const FrameBufferTexture* depthAttach = GetFrameBufferTexture(passIter->m_depthAttach);
@@ -283,11 +875,11 @@ void GraphicsManager::SwapBuffers () {
 			}
 
 			if (depthAttach == NULL) {
-				glDisable(GL_DEPTH_TEST);
+				stateCache.SetCapability(GL_DEPTH_TEST, false);
 				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
 			}
 			else {
-				glEnable(GL_DEPTH_TEST);
+				stateCache.SetCapability(GL_DEPTH_TEST, true);
 				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthAttach->GetBufferTextureID(), 0);	
 			}
 		}
@@ -295,63 +887,27 @@ void GraphicsManager::SwapBuffers () {
 		// Setup Render Viewport to the full destination size
 		glViewport(0, 0, destinationWidth, destinationHeight);
 
-		// Process RenderPass flags
-		unsigned int clearFlags = 0;
-		bool blend = false;
-		bool alphaTest = false;
-
-		std::vector<std::string> shaderStateFlags;
-		for (std::vector<std::string>::iterator flagIter = passIter->m_flags.begin(); flagIter != passIter->m_flags.end(); ++flagIter) {
-			if (*flagIter == "clearColor") {
-				clearFlags |= GL_COLOR_BUFFER_BIT;
-			}
-			else if (*flagIter == "clearDepth") {
-				clearFlags |= GL_DEPTH_BUFFER_BIT;
-			}
-			else if (*flagIter == "blend") {
-				blend = true;
-			}
-			else if (*flagIter == "alphaTest") {
-				alphaTest = true;
-			}
-			// Let shader state try to handle the flag
-			else {
-				shaderStateFlags.push_back(*flagIter);
-			}
-		}
-
 		// Setup blending mode
-		if (blend)  {
-			glEnable(GL_BLEND);
-			glDepthMask(false);
-		}
-		else { 
-			glDisable(GL_BLEND);
-			glDepthMask(true);
-		}
+		stateCache.SetCapability(GL_BLEND, passIter->m_blend);
+		stateCache.SetDepthMask(!passIter->m_blend);
 
-		if (alphaTest)
-			glEnable(GL_ALPHA_TEST);
-		else
-			glDisable(GL_ALPHA_TEST);
+		stateCache.SetCapability(GL_ALPHA_TEST, passIter->m_alphaTest);
 		
 		// Clear buffers specified in flags
-		if (clearFlags != 0) 
-			glClear(clearFlags);
+		if (passIter->m_clearFlags != 0) 
+			glClear(passIter->m_clearFlags);
 
 		UberShader* shader;
-		ShaderState* state;
+		ShaderState* state = m_passShaderStates[passIter - m_renderPasses.begin()];
 
 		// Select the shader
 		switch (passIter->m_shaderType) {
 			case e_ShaderTypeForward:
 				shader = m_forwardShader;
-				state = new ForwardShaderState();
 			break;
 	
 			case e_ShaderTypePostProcess:
 				shader = m_postProcessShader;
-				state = new PostProcessShaderState();
 			break;		
 		};
 
@@ -359,7 +915,6 @@ void GraphicsManager::SwapBuffers () {
 			continue;
 
 		shader->Apply();
-		state->HandleShaderFlags(shaderStateFlags);
 
 		// Setup source textures
 		const FrameBufferTexture* source0 = GetFrameBufferTexture(passIter->m_source0);
@@ -369,35 +924,44 @@ void GraphicsManager::SwapBuffers () {
 		state->b_source1 = source1 != NULL;
 
 		if (state->b_source0) {
-			glActiveTexture(e_TextureChannelRenderPassSource0);
-			glBindTexture(GL_TEXTURE_2D, source0->GetBufferTextureID());
+			stateCache.BindTexture(e_TextureChannelRenderPassSource0, GL_TEXTURE_2D, source0->GetBufferTextureID());
 		}	
 
 		if (state->b_source1) {
-			glActiveTexture(e_TextureChannelRenderPassSource1);
-			glBindTexture(GL_TEXTURE_2D, source1->GetBufferTextureID());
+			stateCache.BindTexture(e_TextureChannelRenderPassSource1, GL_TEXTURE_2D, source1->GetBufferTextureID());
 		}
 
-		for (std::vector<CachedRenderBatch>::iterator batchesIter = m_cachedRenderBatches[passIter->m_geometryType].begin(); batchesIter != m_cachedRenderBatches[passIter->m_geometryType].end(); ++batchesIter) {
-			state->CalculateShaderState(batchesIter->m_renderParameters, batchesIter->m_renderBatch.m_effectParameters);
+		unsigned int firstPacket;
+		unsigned int lastPacket;
+		m_renderQueue.GetRange(passIter->m_geometryType, firstPacket, lastPacket);
 
-			if (batchesIter->m_renderBatch.m_effectParameters.m_twoSided)
-				glDisable(GL_CULL_FACE);
-			else
-				glEnable(GL_CULL_FACE);
+		// Batches of a run that only differ in per instance values share an
+		// instanced draw.  Opaque ones can be regrouped since the depth test
+		// sorts them out, transparent ones have to keep back to front order.
+		// The render parameters are the same for every batch of a frame
+		// outside the HUD, whose batches never share a run.
+		bool instancing = passIter->m_shaderType == e_ShaderTypeForward;
+		bool reorder = passIter->m_geometryType == e_GeometryTypeOpaque;
 
-			state->b_useDiffuseTexture = m_textureManager->SetTexture(e_TextureChannelDiffuse, batchesIter->m_renderBatch.m_effectParameters.m_diffuseTexture);
-			state->b_useEnvironmentMap = m_textureManager->SetTexture(e_TextureChannelEnvMap, batchesIter->m_renderParameters.m_environmentMap);
-			state->b_useNormalMap = m_textureManager->SetTexture(e_TextureChannelNormalMap, batchesIter->m_renderBatch.m_effectParameters.m_normalMap);
+		for (unsigned int packet = firstPacket; packet < lastPacket; ) {
+			unsigned int runEnd = instancing ? m_renderQueue.GetStateRunEnd(packet, lastPacket) : packet + 1;
 
-			state->SetAttributeLocation(m_geometryManager->GetAttributeLocation(batchesIter->m_renderBatch.m_geometryID, batchesIter->m_renderBatch.m_effectParameters.m_animationTime));
-			shader->SetShaderState(state);
+			GroupInstances(packet, runEnd, reorder);
 
-			m_geometryManager->RenderGeometry(batchesIter->m_renderBatch.m_geometryID);
-		}
+			for (unsigned int draw = 0, batch = 0; draw < m_drawSizes.size(); batch += m_drawSizes[draw++]) {
+				DrawBatches(shader, state, &m_drawBatches[batch], m_drawSizes[draw]);
+
+				++drawCalls;
+				instancedDrawCalls += m_drawSizes[draw] > 1 ? 1 : 0;
+			}
 
-		delete state;
+			packet = runEnd;
+		}
 	}
+
+	ReportRenderStats(submittedChanges, CountStateChanges(), sortTime, drawCalls, instancedDrawCalls, stateCache.GetIssued(), stateCache.GetElided());
+
+	m_textureManager->UpdateResidency();
 	
 	glutSwapBuffers();
 }
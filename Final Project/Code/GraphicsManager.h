@@ -5,7 +5,11 @@
 #include <vector>
 #include <string>
 
+#include "DrawListJob.h"
 #include "RenderParameters.h"
+#include "RenderQueue.h"
+#include "ForwardShaderState.h"
+#include "ViewFrustum.h"
 
 struct RenderBatch;
 struct CachedRenderBatch;
@@ -15,12 +19,17 @@ class ForwardShader;
 class PostProcessShader;
 class GeometryManager;
 class TextureManager;
+class WorkerPool;
+class OcclusionCuller;
+class StaticGeometry;
 
 class FrameBufferTexture;
 struct RenderPass;
 
 struct ForwardShaderState;
 struct PostProcessShaderState;
+struct ShaderState;
+class UberShader;
 
 /*
 Kevin TODO
@@ -40,7 +49,7 @@ FUTURE FEATURES
 - Optimization: Combine final pipeline into MRT passes to reduce total passes
 */
 
-class GraphicsManager
+class GraphicsManager : public DrawBuilder
 {
 public:
 	GraphicsManager (const std::string& assetLibrary);
@@ -48,8 +57,26 @@ public:
 
 	void ClearScreen ();
 	void Render (const RenderBatch& batch);
+
+	// Same as rendering each batch in turn, but the frustum tests, levels of
+	// detail and sort keys are worked out on the worker pool.  The batches
+	// only have to stay alive until this returns.
+	void Render (const std::vector<const RenderBatch*>& batches);
 	void SwapBuffers ();
 
+	// Batches of scenery that never moves, baked into chunk geometry by
+	// BuildStaticGeometry and then drawn a chunk at a time
+	void AddStaticBatch (const RenderBatch& batch);
+	void BuildStaticGeometry ();
+	void RenderStaticGeometry ();
+
+	// Frustum of the current render parameters' projection
+	const ViewFrustum& GetViewFrustum ();
+
+	// Boxes that hide whatever is behind them, like tree trunks and rocks.
+	// Batches they cover completely are dropped before they are drawn.
+	void AddOccluder (const vec3& minimum, const vec3& maximum);
+
 	void ReloadAssets ();
 
 	RenderParameters& GetRenderParameters () { return m_renderParameters; }
@@ -60,20 +87,134 @@ private:
 
 	const FrameBufferTexture* GetFrameBufferTexture (const std::string& frameBufferTextureName);
 
+	DrawState GetDrawState (const RenderBatch& batch) const;
+
+	// Whether the batch's bounding sphere reaches into the view frustum of
+	// m_renderParameters, batches of unknown geometry count as visible.
+	// GetViewFrustum has to be up to date.
+	bool IsInFrustum (const RenderBatch& batch) const;
+
+	// HUD keys are made with order 0 for the caller to fill in.  Only reads,
+	// so draw list jobs call it on any thread once GetViewFrustum is up to
+	// date.
+	virtual bool BuildDraw (const RenderBatch& batch, unsigned int& lod, float& screenSize, SortKey& sortKey) const;
+
+	// Starts the occlusion buffer with the first batch outside the HUD
+	void StartOcclusion ();
+
+	// Drops the queued batches the occluders hide, once the occlusion buffer
+	// the first batch of the frame started is rasterized
+	void CullOccludedBatches ();
+
+	// Whether other can be an instance of the same draw as first
+	bool CanInstance (const CachedRenderBatch& first, const CachedRenderBatch& other);
+
+	// Splits the packets of a state run into draws, m_drawBatches gets the
+	// batches of each draw in turn and m_drawSizes their counts
+	void GroupInstances (unsigned int firstPacket, unsigned int lastPacket, bool reorder);
+
+	// Index of the parameter block holding m_renderParameters, a new block is
+	// only stored when they changed since the last batch
+	unsigned int GetParameterBlock ();
+	unsigned int AddCachedBatch (const RenderBatch& batch, unsigned int lod = 0, float screenSize = 1.0f);
+
+	// Uploads the frame uniform block when a batch uses another parameter
+	// block than the last, once a frame and once more for the HUD
+	void UpdateFrameUniforms (unsigned int parameterBlock);
+
+	// One draw of numBatches batches, instanced when there is more than one
+	void DrawBatches (UberShader* shader, ShaderState* state, const unsigned int* batches, unsigned int numBatches);
+
+	// Changes between consecutive draws of each pass, in the queue's current
+	// order
+	StateChanges CountStateChanges () const;
+	void ReportRenderStats (const StateChanges& submittedChanges, const StateChanges& sortedChanges, float sortTime, unsigned int drawCalls, unsigned int instancedDrawCalls,
+		unsigned int issuedCalls, unsigned int elidedCalls);
+
 	const std::string m_assetLibrary;
 
 	RenderParameters m_renderParameters;
 
+	// Bound to e_UniformBlockFrame for every program, m_frameParameterBlock
+	// is what it was last filled from this frame
+	GLuint m_frameUniformBuffer;
+	unsigned int m_frameParameterBlock;
+
 	ForwardShader* m_forwardShader;
 	PostProcessShader* m_postProcessShader;
 	GeometryManager* m_geometryManager;
 	TextureManager* m_textureManager;
 
-	std::vector<CachedRenderBatch> m_cachedRenderBatches[e_GeometryTypeCount];
-
+	// Kept between reloads so hot reloading doesn't restart the threads
+	WorkerPool* m_workerPool;
+
+	// Also kept between reloads, the chunks are baked again after one
+	StaticGeometry* m_staticGeometry;
+	std::vector<const RenderBatch*> m_staticBatches;
+
+	// Batches stay where they were submitted, the queue orders them.  Both
+	// arrays only hold plain data and keep their capacity, so a frame's
+	// submission is freed in constant time by ClearScreen and allocates
+	// nothing once the frames stop growing.
+	std::vector<CachedRenderBatch> m_cachedRenderBatches;
+	std::vector<RenderParameters> m_parameterBlocks;
+	unsigned int m_submitAllocations;
+
+	// Rebuilt when the projection it was taken from changes
+	ViewFrustum m_frustum;
+	mat4 m_frustumProjection;
+	bool m_frustumValid;
+
+	// Batches kept and dropped by the frustum test this frame
+	unsigned int m_visibleBatches;
+	unsigned int m_culledBatches;
+
+	// Rasterizes the occluders on the worker pool while the frame is submitted
+	OcclusionCuller* m_occlusionCuller;
+	bool m_occlusionStarted;
+	unsigned int m_occludedBatches;
+	std::vector<bool> m_batchOccluded;
+
+	// One for each worker and one for the thread submitting
+	std::vector<DrawListJob*> m_drawListJobs;
+	RenderQueue m_renderQueue;
+
+	// Reused between state runs and frames
+	std::vector<unsigned int> m_drawBatches;
+	std::vector<unsigned int> m_drawSizes;
+	std::vector<bool> m_grouped;
+	std::vector<ForwardInstance> m_instances;
+
+	// Summed until the next report
+	unsigned int m_statsFrames;
+	unsigned int m_statsDraws;
+	unsigned int m_statsDrawCalls;
+	unsigned int m_statsInstancedDrawCalls;
+	unsigned int m_statsFrameUploads;
+	unsigned int m_statsIssuedCalls;
+	unsigned int m_statsElidedCalls;
+	unsigned int m_statsParameterBlocks;
+	unsigned int m_statsSubmitAllocations;
+	unsigned int m_statsVisibleBatches;
+	unsigned int m_statsCulledBatches;
+	unsigned int m_statsOccludedBatches;
+	unsigned int m_statsOccluders;
+	float m_statsOcclusionTime;
+	unsigned int m_statsDrawListBatches;
+	float m_statsDrawListTime;
+	StateChanges m_statsSubmittedChanges;
+	StateChanges m_statsSortedChanges;
+	float m_statsSortTime;
+
+	// Owned by m_renderTargets, buffers whose lifetimes don't overlap share
+	// one, so a target can be here under several names
 	std::map<std::string, FrameBufferTexture*> m_frameBufferTextures;
+	std::vector<FrameBufferTexture*> m_renderTargets;
 	std::vector<RenderPass> m_renderPasses;
 
+	// One per pass, with the pass's flags already handled
+	std::vector<ShaderState*> m_passShaderStates;
+
 	GLuint m_fbo;
 };
 
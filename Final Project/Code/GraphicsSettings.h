@@ -12,6 +12,13 @@ struct Settings
 	unsigned int s_windowWidth;
 	unsigned int s_windowHeight;
 
+	// Bytes of streamed texture memory, 0 is no limit
+	unsigned int s_textureBudget;
+
+	// Off by default, testing whole chunks against the occluder boxes hides
+	// too little of the scene to pay for the rasterization
+	bool s_occlusionCulling;
+
 private:
 	Settings () {};
 };
@@ -20,7 +27,7 @@ const unsigned int c_num_point_lights = 3;		// must be same value in shaders
 
 const float c_num_falloff_range = 0.0001f;		// must be greater than 0
 
-enum TextureType { e_TextureType2d = GL_TEXTURE_2D, e_TextureTypeCube = GL_TEXTURE_CUBE_MAP };
+enum TextureType { e_TextureType2d = GL_TEXTURE_2D, e_TextureTypeCube = GL_TEXTURE_CUBE_MAP, e_TextureType2dArray = GL_TEXTURE_2D_ARRAY };
 
 enum TextureChannel { 
 	// Object Defined Shaders
@@ -32,6 +39,10 @@ enum TextureChannel {
 	e_TextureChannelRenderPassSource0 = GL_TEXTURE3,
 	e_TextureChannelRenderPassSource1 = GL_TEXTURE4,
 
+	// Diffuse textures that are a layer of a texture array, the sampler type
+	// differs so it can't share the diffuse unit
+	e_TextureChannelDiffuseArray = GL_TEXTURE5,
+
 	e_TextureChannelFirst = GL_TEXTURE0
 };
 
@@ -0,0 +1,32 @@
+#ifndef __HEADLESSGL_H__
+#define __HEADLESSGL_H__
+
+// Stand-in for glew.h/glut.h in the HEADLESS build.  Only the types and enum
+// values that the simulation side of the code touches are defined here, so
+// GameManager and the Object hierarchy compile without a GL context or any
+// GL libraries.  Anything that actually calls into GL must stay out of the
+// headless build.
+
+typedef unsigned int	GLenum;
+typedef unsigned char	GLboolean;
+typedef int				GLint;
+typedef int				GLsizei;
+typedef unsigned int	GLuint;
+typedef float			GLfloat;
+typedef void			GLvoid;
+
+#define GL_TRIANGLES						0x0004
+#define GL_TRIANGLE_STRIP					0x0005
+#define GL_TEXTURE_2D						0x0DE1
+#define GL_BGR								0x80E0
+#define GL_BGRA								0x80E1
+#define GL_TEXTURE_CUBE_MAP					0x8513
+#define GL_TEXTURE0							0x84C0
+#define GL_TEXTURE1							0x84C1
+#define GL_TEXTURE2							0x84C2
+#define GL_TEXTURE3							0x84C3
+#define GL_TEXTURE4							0x84C4
+#define GL_TEXTURE5							0x84C5
+#define GL_TEXTURE_2D_ARRAY					0x8C1A
+
+#endif
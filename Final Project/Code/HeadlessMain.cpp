@@ -0,0 +1,136 @@
+// ------------------------
+// Headless simulation runner
+// ------------------------
+//
+// Runs GameManager::Simulate() in a tight loop with a fixed tick length and
+// no window, GL context or sound.  Built by the HEADLESS target in the
+// Makefile so simulation throughput can be measured on machines without a GPU.
+//
+//   glutharness_headless [-ticks N] [-monsters N] [-lives N] [-delta D] [-nofire]
+//                        [-seed N] [-record FILE | -replay FILE]
+//
+// -record writes the seed and per tick key state to FILE; -replay runs the
+// ticks from FILE at the delta it was recorded with, ignoring -ticks, -delta
+// and -nofire, so regression runs see the exact same workload.  -monsters and
+// -lives are not stored in the log and have to match the recording.
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "Timer.h"
+#include "GameManager.h"
+
+struct HeadlessSettings
+{
+	HeadlessSettings ()
+		: m_ticks(10000), m_monsterCap(10), m_lives(5), m_delta(1.0f), m_autoFire(true), m_seed(0), m_useSeed(false)
+	{}
+
+	unsigned int m_ticks;
+	unsigned int m_monsterCap;
+	int m_lives;
+	float m_delta;
+	bool m_autoFire;
+	unsigned int m_seed;
+	bool m_useSeed;
+
+	std::string m_recordFile;
+	std::string m_replayFile;
+};
+
+static bool parseArguments (int argc, char** argv, HeadlessSettings& settings) {
+	for (int i = 1; i < argc; ++i) {
+		bool hasValue = i + 1 < argc;
+
+		if (strcmp(argv[i], "-ticks") == 0 && hasValue)
+			settings.m_ticks = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-monsters") == 0 && hasValue)
+			settings.m_monsterCap = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-lives") == 0 && hasValue)
+			settings.m_lives = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-delta") == 0 && hasValue)
+			settings.m_delta = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "-nofire") == 0)
+			settings.m_autoFire = false;
+		else if (strcmp(argv[i], "-seed") == 0 && hasValue) {
+			settings.m_seed = strtoul(argv[++i], NULL, 10);
+			settings.m_useSeed = true;
+		}
+		else if (strcmp(argv[i], "-record") == 0 && hasValue)
+			settings.m_recordFile = argv[++i];
+		else if (strcmp(argv[i], "-replay") == 0 && hasValue)
+			settings.m_replayFile = argv[++i];
+		else {
+			printf("usage: %s [-ticks N] [-monsters N] [-lives N] [-delta D] [-nofire] [-seed N] [-record FILE | -replay FILE]\n", argv[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main (int argc, char** argv) {
+	HeadlessSettings settings;
+	if (!parseArguments(argc, argv, settings))
+		return 1;
+
+	GameManager* gameManager = new GameManager();
+	gameManager->SetMonsterCap(settings.m_monsterCap);
+	gameManager->SetPlayerLives(settings.m_lives);
+	if (settings.m_useSeed)
+		gameManager->SetSeed(settings.m_seed);
+
+	bool replay = !settings.m_replayFile.empty();
+
+	if (replay) {
+		if (!gameManager->ReplayInput(settings.m_replayFile))
+			return 1;
+	}
+	else if (!settings.m_recordFile.empty()) {
+		if (!gameManager->RecordInput(settings.m_recordFile, settings.m_delta))
+			return 1;
+	}
+
+	gameManager->initGame();
+
+	// Hold the trigger down the same way the space bar does
+	if (settings.m_autoFire && !replay)
+		gameManager->callbackKeyboard(' ', 0, 0);
+
+	unsigned int ticks = 0;
+	double monsterTotal = 0.0;
+	double bulletTotal = 0.0;
+
+	Timer timer;
+
+	while (!gameManager->IsGameOver()) {
+		if (replay) {
+			if (gameManager->IsReplayFinished())
+				break;
+		}
+		else if (ticks >= settings.m_ticks)
+			break;
+
+		gameManager->Simulate(settings.m_delta);
+
+		monsterTotal += gameManager->GetMonsterCount();
+		bulletTotal += gameManager->GetBulletCount();
+		++ticks;
+	}
+
+	float elapsed = timer.GetElapsedTime();
+
+	printf("\nHEADLESS SIMULATION\n");
+	printf("  ticks:          %u%s\n", ticks, gameManager->IsGameOver() ? " (game over)" : "");
+	printf("  monster cap:    %u\n", settings.m_monsterCap);
+	printf("  avg monsters:   %.1f\n", ticks ? monsterTotal / ticks : 0.0);
+	printf("  avg bullets:    %.1f\n", ticks ? bulletTotal / ticks : 0.0);
+	printf("  elapsed:        %.3f s\n", elapsed);
+	printf("  ticks/sec:      %.1f\n", elapsed > 0.0f ? ticks / elapsed : 0.0f);
+	printf("  score:          %d\n", gameManager->GetScore());
+	printf("  player:         %.4f %.4f\n", gameManager->GetPlayerPosition().x, gameManager->GetPlayerPosition().z);
+
+	delete gameManager;
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include "InputLog.h"
+
+#include <cstring>
+
+static const char c_input_log_magic[4] = { 'G', 'H', 'I', 'L' };
+static const unsigned int c_input_log_version = 2;
+
+InputLog::InputLog ()
+	: m_file(NULL), m_recording(false), m_headerWritten(false), m_seed(0), m_delta(1.0f), m_replayPosition(0)
+{
+}
+
+InputLog::~InputLog () {
+	Close();
+}
+
+bool InputLog::OpenRecord (const std::string& fileName, float delta) {
+	Close();
+
+	m_file = fopen(fileName.c_str(), "wb");
+
+	if (m_file == NULL) {
+		printf("InputLog::OpenRecord: Error opening %s.\n", fileName.c_str());
+		return false;
+	}
+
+	m_recording = true;
+	m_headerWritten = false;
+	m_delta = delta;
+
+	return true;
+}
+
+bool InputLog::OpenReplay (const std::string& fileName) {
+	Close();
+
+	FILE* file = fopen(fileName.c_str(), "rb");
+
+	if (file == NULL) {
+		printf("InputLog::OpenReplay: Error opening %s.\n", fileName.c_str());
+		return false;
+	}
+
+	char magic[4];
+	unsigned int version;
+
+	bool valid = fread(magic, sizeof(magic), 1, file) == 1 &&
+				 fread(&version, sizeof(version), 1, file) == 1 &&
+				 fread(&m_seed, sizeof(m_seed), 1, file) == 1 &&
+				 fread(&m_delta, sizeof(m_delta), 1, file) == 1;
+
+	if (!valid || memcmp(magic, c_input_log_magic, sizeof(magic)) != 0 || version != c_input_log_version) {
+		printf("InputLog::OpenReplay: %s is not a valid input log.\n", fileName.c_str());
+		fclose(file);
+		return false;
+	}
+
+	unsigned char buffer[4096];
+	size_t count;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		m_ticks.insert(m_ticks.end(), buffer, buffer + count);
+
+	fclose(file);
+
+	m_replayPosition = 0;
+	return true;
+}
+
+void InputLog::Close () {
+	if (m_file != NULL) {
+		fclose(m_file);
+		m_file = NULL;
+	}
+
+	m_recording = false;
+	m_ticks.clear();
+	m_replayPosition = 0;
+}
+
+void InputLog::Record (unsigned char keyState) {
+	if (!m_recording)
+		return;
+
+	if (!m_headerWritten) {
+		fwrite(c_input_log_magic, sizeof(c_input_log_magic), 1, m_file);
+		fwrite(&c_input_log_version, sizeof(c_input_log_version), 1, m_file);
+		fwrite(&m_seed, sizeof(m_seed), 1, m_file);
+		fwrite(&m_delta, sizeof(m_delta), 1, m_file);
+		m_headerWritten = true;
+	}
+
+	fputc(keyState, m_file);
+}
+
+bool InputLog::Replay (unsigned char& keyState) {
+	if (m_recording || m_replayPosition >= m_ticks.size())
+		return false;
+
+	keyState = m_ticks[m_replayPosition++];
+	return true;
+}
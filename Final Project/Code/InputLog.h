@@ -0,0 +1,69 @@
+#ifndef __INPUTLOG_H__
+#define __INPUTLOG_H__
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Bits of the per tick key state stored in an input log
+enum InputKey {
+	e_InputKeyW = 1 << 0,
+	e_InputKeyA = 1 << 1,
+	e_InputKeyS = 1 << 2,
+	e_InputKeyD = 1 << 3,
+	e_InputKeyJ = 1 << 4,
+	e_InputKeyL = 1 << 5,
+	e_InputKeyAuto = 1 << 6,
+	e_InputKeyPause = 1 << 7
+};
+
+/*
+Binary log of the simulation seed and the key state of every tick.
+
+Layout (little endian):
+	char[4]		"GHIL"
+	uint32		version
+	uint32		seed
+	float		tick delta the session was recorded and is replayed at
+	uint8		key state, one per tick until the end of the file
+
+Pausing is stored as the paused state of each tick.  Resetting the game ends
+the session and the log with it, so a replay stops where the reset was.
+
+The header is written with the first tick and ticks go straight to a stdio
+stream, so a session that ends through exit() still leaves a usable log.
+*/
+class InputLog
+{
+public:
+	InputLog ();
+	~InputLog ();
+
+	bool OpenRecord (const std::string& fileName, float delta);
+	bool OpenReplay (const std::string& fileName);
+	void Close ();
+
+	bool IsRecording () const { return m_recording; }
+	bool IsReplaying () const { return !m_recording && m_replayPosition < m_ticks.size(); }
+
+	void SetSeed (unsigned int seed) { m_seed = seed; }
+	unsigned int GetSeed () const { return m_seed; }
+	float GetDelta () const { return m_delta; }
+	unsigned int GetTickCount () const { return m_ticks.size(); }
+
+	void Record (unsigned char keyState);
+	bool Replay (unsigned char& keyState);
+
+private:
+	FILE* m_file;
+	bool m_recording;
+	bool m_headerWritten;
+
+	unsigned int m_seed;
+	float m_delta;
+
+	std::vector<unsigned char> m_ticks;
+	unsigned int m_replayPosition;
+};
+
+#endif
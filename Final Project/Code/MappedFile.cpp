@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <windows.h>
+
+MappedFile::MappedFile ()
+	: m_data(NULL), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+{
+}
+
+bool MappedFile::Open (const std::string& fileName) {
+	Close();
+
+	m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	m_size = GetFileSize(m_file, NULL);
+	if (m_size == 0 || m_size == INVALID_FILE_SIZE) {
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping == NULL) {
+		Close();
+		return false;
+	}
+
+	m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_data == NULL) {
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close () {
+	if (m_data != NULL)
+		UnmapViewOfFile(m_data);
+
+	if (m_mapping != NULL)
+		CloseHandle(m_mapping);
+
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_data = NULL;
+	m_size = 0;
+	m_mapping = NULL;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+//***********************************unix specific*********************************
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+MappedFile::MappedFile ()
+	: m_data(NULL), m_size(0), m_file(-1)
+{
+}
+
+bool MappedFile::Open (const std::string& fileName) {
+	Close();
+
+	m_file = open(fileName.c_str(), O_RDONLY);
+	if (m_file < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(m_file, &fileStat) != 0 || fileStat.st_size == 0) {
+		Close();
+		return false;
+	}
+
+	m_size = (unsigned int)fileStat.st_size;
+
+	void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+	if (data == MAP_FAILED) {
+		Close();
+		return false;
+	}
+
+	m_data = (const char*)data;
+	return true;
+}
+
+void MappedFile::Close () {
+	if (m_data != NULL)
+		munmap((void*)m_data, m_size);
+
+	if (m_file >= 0)
+		close(m_file);
+
+	m_data = NULL;
+	m_size = 0;
+	m_file = -1;
+}
+
+#endif // unix
+
+MappedFile::~MappedFile () {
+	Close();
+}
+
+bool GetFileStamp (const std::string& fileName, long long& size, long long& time) {
+	struct stat fileStat;
+
+	if (stat(fileName.c_str(), &fileStat) != 0)
+		return false;
+
+	size = fileStat.st_size;
+	time = fileStat.st_mtime;
+	return true;
+}
@@ -0,0 +1,39 @@
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+#include <string>
+
+// Read only memory mapping of a whole file.  The contents stay valid until
+// Close() or the MappedFile is destroyed.
+class MappedFile
+{
+public:
+	MappedFile ();
+	~MappedFile ();
+
+	bool Open (const std::string& fileName);
+	void Close ();
+
+	const char* GetData () const { return m_data; }
+	unsigned int GetSize () const { return m_size; }
+
+private:
+	// Not copyable, the mapping is owned
+	MappedFile (const MappedFile&);
+	MappedFile& operator= (const MappedFile&);
+
+	const char* m_data;
+	unsigned int m_size;
+
+#ifdef WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+};
+
+// Size and modification time of a file, for telling when cooked data is stale
+bool GetFileStamp (const std::string& fileName, long long& size, long long& time);
+
+#endif
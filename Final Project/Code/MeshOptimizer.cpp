@@ -0,0 +1,743 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <queue>
+
+namespace {
+
+// Orders corners by their vertex data across every frame
+struct CornerLess
+{
+	CornerLess (const std::vector<std::vector<Vertex> >& frames)
+		: m_frames(frames)
+	{}
+
+	bool operator() (GLuint a, GLuint b) const {
+		int order = Compare(a, b);
+		return order != 0 ? order < 0 : a < b;
+	}
+
+	int Compare (GLuint a, GLuint b) const {
+		for (unsigned int i = 0; i < m_frames.size(); ++i) {
+			int order = memcmp(&m_frames[i][a], &m_frames[i][b], sizeof(Vertex));
+			if (order != 0)
+				return order;
+		}
+		return 0;
+	}
+
+	const std::vector<std::vector<Vertex> >& m_frames;
+};
+
+// Tuning values from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+const int c_cache_size = 32;
+const float c_cache_decay_power = 1.5f;
+const float c_last_triangle_score = 0.75f;
+const float c_valence_boost_scale = 2.0f;
+const float c_valence_boost_power = 0.5f;
+
+struct OptimizerVertex
+{
+	OptimizerVertex ()
+		: m_cachePosition(-1), m_score(0.0f), m_activeTriangles(0), m_firstTriangle(0)
+	{}
+
+	int m_cachePosition;
+	float m_score;
+	unsigned int m_activeTriangles;
+	unsigned int m_firstTriangle;
+};
+
+float VertexScore (const OptimizerVertex& vertex) {
+	if (vertex.m_activeTriangles == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+
+	if (vertex.m_cachePosition >= 0) {
+		if (vertex.m_cachePosition < 3) {
+			// The last triangle's vertexes score the same no matter the order
+			score = c_last_triangle_score;
+		}
+		else {
+			float scaler = 1.0f / (c_cache_size - 3);
+			score = pow(1.0f - (vertex.m_cachePosition - 3) * scaler, c_cache_decay_power);
+		}
+	}
+
+	// Favour finishing off vertexes with few triangles left
+	score += c_valence_boost_scale * pow((float)vertex.m_activeTriangles, -c_valence_boost_power);
+	return score;
+}
+
+}
+
+void IndexTriangles (const std::vector<std::vector<Vertex> >& frames, std::vector<std::vector<Vertex> >& indexedFrames, std::vector<GLuint>& indexes) {
+	indexedFrames.clear();
+	indexes.clear();
+
+	if (frames.empty())
+		return;
+
+	unsigned int numCorners = frames[0].size();
+
+	std::vector<GLuint> sortedCorners(numCorners);
+	for (unsigned int i = 0; i < numCorners; ++i)
+		sortedCorners[i] = i;
+
+	CornerLess cornerLess(frames);
+	std::sort(sortedCorners.begin(), sortedCorners.end(), cornerLess);
+
+	// Point every corner at the first corner with the same data
+	std::vector<GLuint> firstCorner(numCorners);
+	for (unsigned int i = 0; i < numCorners; ) {
+		unsigned int groupEnd = i + 1;
+		while (groupEnd < numCorners && cornerLess.Compare(sortedCorners[i], sortedCorners[groupEnd]) == 0)
+			++groupEnd;
+
+		// Sorting tie breaks on the corner, so the group starts with the lowest
+		for (unsigned int j = i; j < groupEnd; ++j)
+			firstCorner[sortedCorners[j]] = sortedCorners[i];
+
+		i = groupEnd;
+	}
+
+	std::vector<GLuint> vertexIndex(numCorners);
+	unsigned int numVertex = 0;
+
+	indexes.reserve(numCorners);
+	for (unsigned int i = 0; i < numCorners; ++i) {
+		if (firstCorner[i] == i)
+			vertexIndex[i] = numVertex++;
+
+		indexes.push_back(vertexIndex[firstCorner[i]]);
+	}
+
+	indexedFrames.resize(frames.size());
+	for (unsigned int frame = 0; frame < frames.size(); ++frame) {
+		indexedFrames[frame].reserve(numVertex);
+
+		for (unsigned int i = 0; i < numCorners; ++i) {
+			if (firstCorner[i] == i)
+				indexedFrames[frame].push_back(frames[frame][i]);
+		}
+	}
+}
+
+void OptimizeVertexCache (std::vector<GLuint>& indexes, unsigned int numVertex) {
+	if (indexes.size() < 3)
+		return;
+
+	unsigned int numTriangles = indexes.size() / 3;
+
+	std::vector<OptimizerVertex> vertexes(numVertex);
+
+	// Build vertex to triangle adjacency
+	for (unsigned int i = 0; i < numTriangles * 3; ++i)
+		++vertexes[indexes[i]].m_activeTriangles;
+
+	unsigned int offset = 0;
+	for (unsigned int i = 0; i < numVertex; ++i) {
+		vertexes[i].m_firstTriangle = offset;
+		offset += vertexes[i].m_activeTriangles;
+		vertexes[i].m_activeTriangles = 0;
+	}
+
+	std::vector<GLuint> adjacency(numTriangles * 3);
+	for (unsigned int i = 0; i < numTriangles * 3; ++i) {
+		OptimizerVertex& vertex = vertexes[indexes[i]];
+		adjacency[vertex.m_firstTriangle + vertex.m_activeTriangles++] = i / 3;
+	}
+
+	for (unsigned int i = 0; i < numVertex; ++i)
+		vertexes[i].m_score = VertexScore(vertexes[i]);
+
+	std::vector<float> triangleScores(numTriangles);
+	std::vector<bool> triangleEmitted(numTriangles, false);
+
+	for (unsigned int i = 0; i < numTriangles; ++i) {
+		triangleScores[i] = vertexes[indexes[i * 3]].m_score + 
+							vertexes[indexes[i * 3 + 1]].m_score + 
+							vertexes[indexes[i * 3 + 2]].m_score;
+	}
+
+	std::vector<GLuint> optimized;
+	optimized.reserve(numTriangles * 3);
+
+	int cache[c_cache_size + 3];
+	int cacheUsed = 0;
+
+	unsigned int fallbackCursor = 0;
+	int bestTriangle = -1;
+
+	for (unsigned int emitted = 0; emitted < numTriangles; ++emitted) {
+		// Nothing connected to the cache, take the next triangle in file order
+		if (bestTriangle < 0) {
+			while (triangleEmitted[fallbackCursor])
+				++fallbackCursor;
+			bestTriangle = fallbackCursor;
+		}
+
+		const GLuint* triangle = &indexes[bestTriangle * 3];
+		triangleEmitted[bestTriangle] = true;
+
+		int newCache[c_cache_size + 3];
+		int newCacheUsed = 0;
+
+		for (int i = 0; i < 3; ++i) {
+			optimized.push_back(triangle[i]);
+			newCache[newCacheUsed++] = triangle[i];
+
+			// Remove the triangle from the vertex's active list
+			OptimizerVertex& vertex = vertexes[triangle[i]];
+			GLuint* triangles = &adjacency[vertex.m_firstTriangle];
+			for (unsigned int j = 0; j < vertex.m_activeTriangles; ++j) {
+				if (triangles[j] == (GLuint)bestTriangle) {
+					triangles[j] = triangles[vertex.m_activeTriangles - 1];
+					break;
+				}
+			}
+			--vertex.m_activeTriangles;
+		}
+
+		// Push the triangle's vertexes to the front of the LRU cache
+		for (int i = 0; i < cacheUsed; ++i) {
+			int cached = cache[i];
+			if (cached != (int)triangle[0] && cached != (int)triangle[1] && cached != (int)triangle[2])
+				newCache[newCacheUsed++] = cached;
+		}
+
+		for (int i = 0; i < newCacheUsed; ++i) {
+			OptimizerVertex& vertex = vertexes[newCache[i]];
+			vertex.m_cachePosition = i < c_cache_size ? i : -1;
+			vertex.m_score = VertexScore(vertex);
+		}
+
+		cacheUsed = newCacheUsed < c_cache_size ? newCacheUsed : c_cache_size;
+		memcpy(cache, newCache, cacheUsed * sizeof(int));
+
+		// Rescore the triangles touching the cache and pick the best of them
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+
+		for (int i = 0; i < cacheUsed; ++i) {
+			const OptimizerVertex& vertex = vertexes[cache[i]];
+			const GLuint* triangles = &adjacency[vertex.m_firstTriangle];
+
+			for (unsigned int j = 0; j < vertex.m_activeTriangles; ++j) {
+				GLuint candidate = triangles[j];
+				float score = vertexes[indexes[candidate * 3]].m_score + 
+							  vertexes[indexes[candidate * 3 + 1]].m_score + 
+							  vertexes[indexes[candidate * 3 + 2]].m_score;
+				triangleScores[candidate] = score;
+
+				if (score > bestScore) {
+					bestScore = score;
+					bestTriangle = candidate;
+				}
+			}
+		}
+	}
+
+	indexes.swap(optimized);
+}
+
+void OptimizeVertexFetch (std::vector<std::vector<Vertex> >& frames, std::vector<GLuint>& indexes) {
+	if (frames.empty())
+		return;
+
+	unsigned int numVertex = frames[0].size();
+
+	// Renumber vertexes in first use order
+	std::vector<GLuint> remap(numVertex, (GLuint)-1);
+	unsigned int nextVertex = 0;
+
+	for (unsigned int i = 0; i < indexes.size(); ++i) {
+		if (remap[indexes[i]] == (GLuint)-1)
+			remap[indexes[i]] = nextVertex++;
+		indexes[i] = remap[indexes[i]];
+	}
+
+	for (unsigned int frame = 0; frame < frames.size(); ++frame) {
+		std::vector<Vertex> reordered(frames[frame]);
+
+		// Vertexes no triangle uses would keep their old slot, there are none
+		// coming out of IndexTriangles
+		for (unsigned int i = 0; i < numVertex; ++i) {
+			if (remap[i] != (GLuint)-1)
+				reordered[remap[i]] = frames[frame][i];
+		}
+
+		frames[frame].swap(reordered);
+	}
+}
+
+namespace {
+
+// Orders vertexes by their position across every frame
+struct PositionLess
+{
+	PositionLess (const std::vector<std::vector<Vertex> >& frames)
+		: m_frames(frames)
+	{}
+
+	bool operator() (GLuint a, GLuint b) const {
+		int order = Compare(a, b);
+		return order != 0 ? order < 0 : a < b;
+	}
+
+	int Compare (GLuint a, GLuint b) const {
+		for (unsigned int i = 0; i < m_frames.size(); ++i) {
+			int order = memcmp(&m_frames[i][a].position, &m_frames[i][b].position, sizeof(vec3));
+			if (order != 0)
+				return order;
+		}
+		return 0;
+	}
+
+	const std::vector<std::vector<Vertex> >& m_frames;
+};
+
+// Symmetric 4x4 plane quadric, upper triangle only
+struct Quadric
+{
+	Quadric () {
+		memset(m_values, 0, sizeof(m_values));
+	}
+
+	void AddPlane (double a, double b, double c, double d, double weight) {
+		m_values[0] += weight * a * a;
+		m_values[1] += weight * a * b;
+		m_values[2] += weight * a * c;
+		m_values[3] += weight * a * d;
+		m_values[4] += weight * b * b;
+		m_values[5] += weight * b * c;
+		m_values[6] += weight * b * d;
+		m_values[7] += weight * c * c;
+		m_values[8] += weight * c * d;
+		m_values[9] += weight * d * d;
+	}
+
+	void Add (const Quadric& other) {
+		for (int i = 0; i < 10; ++i)
+			m_values[i] += other.m_values[i];
+	}
+
+	double Evaluate (const vec3& p) const {
+		double x = p.x;
+		double y = p.y;
+		double z = p.z;
+
+		return m_values[0] * x * x + 2.0 * m_values[1] * x * y + 2.0 * m_values[2] * x * z + 2.0 * m_values[3] * x + 
+			   m_values[4] * y * y + 2.0 * m_values[5] * y * z + 2.0 * m_values[6] * y + 
+			   m_values[7] * z * z + 2.0 * m_values[8] * z + 
+			   m_values[9];
+	}
+
+	double m_values[10];
+};
+
+// Between position groups
+struct Collapse
+{
+	double m_cost;
+	unsigned int m_from;
+	unsigned int m_to;
+	unsigned int m_fromVersion;
+	unsigned int m_toVersion;
+
+	// Cheapest collapse on top of the priority queue
+	bool operator< (const Collapse& other) const { return m_cost > other.m_cost; }
+};
+
+// Vertexes split only by texture coordinates or normals share a position
+// group.  A collapse moves every member of the source group onto a neighbouring
+// member of the target group, so both sides of a seam move together and no
+// crack opens.
+struct Simplifier
+{
+	Simplifier (const std::vector<std::vector<Vertex> >& frames, const std::vector<GLuint>& indexes)
+		: m_frames(frames), m_triangles(indexes)
+	{}
+
+	const vec3& Position (unsigned int frame, GLuint vertex) const { return m_frames[frame][vertex].position; }
+
+	// Cost of moving from's group onto to's position, over every frame
+	double CollapseCost (GLuint from, GLuint to) const {
+		const std::vector<GLuint>& fromGroup = m_groups[m_groupOf[from]];
+		const std::vector<GLuint>& toGroup = m_groups[m_groupOf[to]];
+
+		double cost = 0.0;
+
+		for (unsigned int frame = 0; frame < m_frames.size(); ++frame) {
+			const vec3& position = Position(frame, to);
+
+			for (unsigned int i = 0; i < fromGroup.size(); ++i)
+				cost += m_quadrics[frame * m_numVertex + fromGroup[i]].Evaluate(position);
+
+			for (unsigned int i = 0; i < toGroup.size(); ++i)
+				cost += m_quadrics[frame * m_numVertex + toGroup[i]].Evaluate(position);
+		}
+
+		return cost;
+	}
+
+	void PushCollapse (GLuint from, GLuint to) {
+		if (m_locked[m_groupOf[from]] || m_groupOf[from] == m_groupOf[to])
+			return;
+
+		Collapse collapse;
+		collapse.m_cost = CollapseCost(from, to);
+		collapse.m_from = m_groupOf[from];
+		collapse.m_to = m_groupOf[to];
+		collapse.m_fromVersion = m_versions[collapse.m_from];
+		collapse.m_toVersion = m_versions[collapse.m_to];
+
+		m_collapses.push(collapse);
+	}
+
+	void GetNeighbours (GLuint vertex, std::vector<GLuint>& neighbours) const {
+		neighbours.clear();
+
+		for (unsigned int i = 0; i < m_vertexTriangles[vertex].size(); ++i) {
+			unsigned int triangle = m_vertexTriangles[vertex][i];
+
+			if (m_triangleRemoved[triangle])
+				continue;
+
+			for (int j = 0; j < 3; ++j) {
+				GLuint other = m_triangles[triangle * 3 + j];
+
+				if (other != vertex && std::find(neighbours.begin(), neighbours.end(), other) == neighbours.end())
+					neighbours.push_back(other);
+			}
+		}
+	}
+
+	bool CanCollapseVertex (GLuint from, GLuint to) {
+		GetNeighbours(from, m_fromNeighbours);
+		GetNeighbours(to, m_toNeighbours);
+
+		// Link condition, the edge may only share the two opposite vertexes
+		unsigned int shared = 0;
+		for (unsigned int i = 0; i < m_fromNeighbours.size(); ++i) {
+			if (std::find(m_toNeighbours.begin(), m_toNeighbours.end(), m_fromNeighbours[i]) != m_toNeighbours.end())
+				++shared;
+		}
+
+		if (shared > 2)
+			return false;
+
+		// No remaining triangle may flip in any frame
+		for (unsigned int i = 0; i < m_vertexTriangles[from].size(); ++i) {
+			unsigned int triangle = m_vertexTriangles[from][i];
+
+			if (m_triangleRemoved[triangle])
+				continue;
+
+			const GLuint* corners = &m_triangles[triangle * 3];
+
+			if (corners[0] == to || corners[1] == to || corners[2] == to)
+				continue;
+
+			for (unsigned int frame = 0; frame < m_frames.size(); ++frame) {
+				vec3 before[3];
+				vec3 after[3];
+
+				for (int j = 0; j < 3; ++j) {
+					before[j] = Position(frame, corners[j]);
+					after[j] = Position(frame, corners[j] == from ? to : corners[j]);
+				}
+
+				vec3 normalBefore = cross(before[1] - before[0], before[2] - before[0]);
+				vec3 normalAfter = cross(after[1] - after[0], after[2] - after[0]);
+
+				if (dot(normalBefore, normalAfter) <= 0.0f)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Pairs every member of the from group with a neighbouring member of the
+	// to group, fails if any member has none
+	bool CanCollapse (unsigned int fromGroup, unsigned int toGroup) {
+		m_pairs.clear();
+
+		const std::vector<GLuint>& fromMembers = m_groups[fromGroup];
+		const std::vector<GLuint>& toMembers = m_groups[toGroup];
+
+		for (unsigned int i = 0; i < fromMembers.size(); ++i) {
+			GetNeighbours(fromMembers[i], m_fromNeighbours);
+
+			GLuint to = (GLuint)-1;
+			for (unsigned int j = 0; j < toMembers.size() && to == (GLuint)-1; ++j) {
+				if (std::find(m_fromNeighbours.begin(), m_fromNeighbours.end(), toMembers[j]) != m_fromNeighbours.end())
+					to = toMembers[j];
+			}
+
+			if (to == (GLuint)-1 || !CanCollapseVertex(fromMembers[i], to))
+				return false;
+
+			m_pairs.push_back(std::make_pair(fromMembers[i], to));
+		}
+
+		return true;
+	}
+
+	void CollapseVertex (GLuint from, GLuint to) {
+		for (unsigned int i = 0; i < m_vertexTriangles[from].size(); ++i) {
+			unsigned int triangle = m_vertexTriangles[from][i];
+
+			if (m_triangleRemoved[triangle])
+				continue;
+
+			GLuint* corners = &m_triangles[triangle * 3];
+
+			if (corners[0] == to || corners[1] == to || corners[2] == to) {
+				m_triangleRemoved[triangle] = true;
+				--m_liveTriangles;
+				continue;
+			}
+
+			for (int j = 0; j < 3; ++j) {
+				if (corners[j] == from)
+					corners[j] = to;
+			}
+
+			m_vertexTriangles[to].push_back(triangle);
+		}
+
+		m_vertexTriangles[from].clear();
+
+		for (unsigned int frame = 0; frame < m_frames.size(); ++frame)
+			m_quadrics[frame * m_numVertex + to].Add(m_quadrics[frame * m_numVertex + from]);
+	}
+
+	void DoCollapse (unsigned int fromGroup, unsigned int toGroup) {
+		for (unsigned int i = 0; i < m_pairs.size(); ++i)
+			CollapseVertex(m_pairs[i].first, m_pairs[i].second);
+
+		m_groups[fromGroup].clear();
+		m_groupRemoved[fromGroup] = true;
+
+		// Every queued collapse touching the target group is stale now
+		++m_versions[toGroup];
+
+		const std::vector<GLuint>& toMembers = m_groups[toGroup];
+
+		for (unsigned int i = 0; i < toMembers.size(); ++i) {
+			GetNeighbours(toMembers[i], m_toNeighbours);
+
+			for (unsigned int j = 0; j < m_toNeighbours.size(); ++j) {
+				PushCollapse(toMembers[i], m_toNeighbours[j]);
+				PushCollapse(m_toNeighbours[j], toMembers[i]);
+			}
+		}
+	}
+
+	void BuildGroups () {
+		std::vector<GLuint> sorted(m_numVertex);
+		for (unsigned int i = 0; i < m_numVertex; ++i)
+			sorted[i] = i;
+
+		PositionLess positionLess(m_frames);
+		std::sort(sorted.begin(), sorted.end(), positionLess);
+
+		m_groupOf.assign(m_numVertex, 0);
+		m_groups.clear();
+
+		for (unsigned int i = 0; i < m_numVertex; ) {
+			unsigned int end = i + 1;
+			while (end < m_numVertex && positionLess.Compare(sorted[i], sorted[end]) == 0)
+				++end;
+
+			m_groups.push_back(std::vector<GLuint>(sorted.begin() + i, sorted.begin() + end));
+
+			for (unsigned int j = i; j < end; ++j)
+				m_groupOf[sorted[j]] = m_groups.size() - 1;
+
+			i = end;
+		}
+	}
+
+	void Run (unsigned int targetTriangles, std::vector<GLuint>& simplified) {
+		m_numVertex = m_frames[0].size();
+
+		unsigned int numTriangles = m_triangles.size() / 3;
+
+		BuildGroups();
+
+		m_liveTriangles = numTriangles;
+		m_triangleRemoved.assign(numTriangles, false);
+		m_groupRemoved.assign(m_groups.size(), false);
+		m_locked.assign(m_groups.size(), false);
+		m_versions.assign(m_groups.size(), 0);
+		m_vertexTriangles.assign(m_numVertex, std::vector<unsigned int>());
+		m_quadrics.assign(m_frames.size() * m_numVertex, Quadric());
+
+		std::vector<std::pair<unsigned int, unsigned int> > edges;
+		edges.reserve(numTriangles * 3);
+
+		for (unsigned int triangle = 0; triangle < numTriangles; ++triangle) {
+			const GLuint* corners = &m_triangles[triangle * 3];
+
+			for (int j = 0; j < 3; ++j) {
+				unsigned int a = m_groupOf[corners[j]];
+				unsigned int b = m_groupOf[corners[(j + 1) % 3]];
+
+				m_vertexTriangles[corners[j]].push_back(triangle);
+				edges.push_back(std::make_pair(a < b ? a : b, a < b ? b : a));
+			}
+
+			// Area weighted plane quadrics
+			for (unsigned int frame = 0; frame < m_frames.size(); ++frame) {
+				vec3 p0 = Position(frame, corners[0]);
+				vec3 normal = cross(Position(frame, corners[1]) - p0, Position(frame, corners[2]) - p0);
+
+				double area = sqrt(dot(normal, normal));
+				if (area <= 0.0)
+					continue;
+
+				double a = normal.x / area;
+				double b = normal.y / area;
+				double c = normal.z / area;
+				double d = -(a * p0.x + b * p0.y + c * p0.z);
+
+				for (int j = 0; j < 3; ++j)
+					m_quadrics[frame * m_numVertex + corners[j]].AddPlane(a, b, c, d, area * 0.5);
+			}
+		}
+
+		// Anything but a welded edge shared by exactly two triangles is a real
+		// border or non manifold and pins its vertexes
+		std::sort(edges.begin(), edges.end());
+
+		for (unsigned int i = 0; i < edges.size(); ) {
+			unsigned int end = i + 1;
+			while (end < edges.size() && edges[end] == edges[i])
+				++end;
+
+			if (end - i != 2) {
+				m_locked[edges[i].first] = true;
+				m_locked[edges[i].second] = true;
+			}
+
+			i = end;
+		}
+
+		for (unsigned int triangle = 0; triangle < numTriangles; ++triangle) {
+			const GLuint* corners = &m_triangles[triangle * 3];
+
+			for (int j = 0; j < 3; ++j) {
+				PushCollapse(corners[j], corners[(j + 1) % 3]);
+				PushCollapse(corners[(j + 1) % 3], corners[j]);
+			}
+		}
+
+		while (m_liveTriangles > targetTriangles && !m_collapses.empty()) {
+			Collapse collapse = m_collapses.top();
+			m_collapses.pop();
+
+			if (m_groupRemoved[collapse.m_from] || m_groupRemoved[collapse.m_to] || 
+				m_versions[collapse.m_from] != collapse.m_fromVersion || m_versions[collapse.m_to] != collapse.m_toVersion)
+				continue;
+
+			if (CanCollapse(collapse.m_from, collapse.m_to))
+				DoCollapse(collapse.m_from, collapse.m_to);
+		}
+
+		simplified.clear();
+		simplified.reserve(m_liveTriangles * 3);
+
+		for (unsigned int triangle = 0; triangle < numTriangles; ++triangle) {
+			if (!m_triangleRemoved[triangle])
+				simplified.insert(simplified.end(), m_triangles.begin() + triangle * 3, m_triangles.begin() + triangle * 3 + 3);
+		}
+	}
+
+	const std::vector<std::vector<Vertex> >& m_frames;
+	std::vector<GLuint> m_triangles;
+
+	unsigned int m_numVertex;
+	unsigned int m_liveTriangles;
+
+	std::vector<unsigned int> m_groupOf;
+	std::vector<std::vector<GLuint> > m_groups;
+
+	std::vector<bool> m_triangleRemoved;
+	std::vector<bool> m_groupRemoved;
+	std::vector<bool> m_locked;
+	std::vector<unsigned int> m_versions;
+	std::vector<std::vector<unsigned int> > m_vertexTriangles;
+	std::vector<Quadric> m_quadrics;
+
+	std::priority_queue<Collapse> m_collapses;
+
+	std::vector<std::pair<GLuint, GLuint> > m_pairs;
+	std::vector<GLuint> m_fromNeighbours;
+	std::vector<GLuint> m_toNeighbours;
+};
+}
+
+void SimplifyTriangles (const std::vector<std::vector<Vertex> >& frames, const std::vector<GLuint>& indexes, unsigned int targetTriangles, std::vector<GLuint>& simplified) {
+	if (frames.empty() || indexes.size() < 3) {
+		simplified = indexes;
+		return;
+	}
+
+	Simplifier simplifier(frames, indexes);
+	simplifier.Run(targetTriangles, simplified);
+}
+
+void ComputeBoundingSphere (const std::vector<std::vector<Vertex> >& frames, vec3& center, float& radius) {
+	vec3 minimum(FLT_MAX, FLT_MAX, FLT_MAX);
+	vec3 maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	for (unsigned int frame = 0; frame < frames.size(); ++frame) {
+		for (unsigned int i = 0; i < frames[frame].size(); ++i) {
+			const vec3& position = frames[frame][i].position;
+
+			for (int j = 0; j < 3; ++j) {
+				minimum[j] = position[j] < minimum[j] ? position[j] : minimum[j];
+				maximum[j] = position[j] > maximum[j] ? position[j] : maximum[j];
+			}
+		}
+	}
+
+	// Box centre, not the tightest sphere but close enough for culling and
+	// level of detail
+	center = (minimum + maximum) * 0.5f;
+	radius = 0.0f;
+
+	for (unsigned int frame = 0; frame < frames.size(); ++frame) {
+		for (unsigned int i = 0; i < frames[frame].size(); ++i) {
+			float distance = length(frames[frame][i].position - center);
+			radius = distance > radius ? distance : radius;
+		}
+	}
+}
+
+float AverageCacheMissRatio (const std::vector<GLuint>& indexes, unsigned int numVertex, unsigned int cacheSize) {
+	if (indexes.size() < 3)
+		return 0.0f;
+
+	// Time stamp each vertex entered the FIFO
+	std::vector<unsigned int> enteredCache(numVertex, 0);
+	unsigned int misses = 0;
+
+	for (unsigned int i = 0; i < indexes.size(); ++i) {
+		unsigned int& entered = enteredCache[indexes[i]];
+
+		if (entered == 0 || misses - entered >= cacheSize) {
+			++misses;
+			entered = misses;
+		}
+	}
+
+	return (float)misses / (indexes.size() / 3);
+}
@@ -0,0 +1,38 @@
+#ifndef __MESHOPTIMIZER_H__
+#define __MESHOPTIMIZER_H__
+
+#include <vector>
+
+#include "Angel.h"
+
+#include "Vertex.h"
+
+// Collapses identical corners of a triangle list into an indexed vertex list.
+// Every frame must hold the same number of vertexes.  Two corners are only
+// merged when they match in every frame, so all keyframes of an animation
+// share one index list.
+void IndexTriangles (const std::vector<std::vector<Vertex> >& frames, std::vector<std::vector<Vertex> >& indexedFrames, std::vector<GLuint>& indexes);
+
+// Reorders triangles for the post transform vertex cache (Tom Forsyth's
+// linear speed optimizer).  Vertexes are left where they are.
+void OptimizeVertexCache (std::vector<GLuint>& indexes, unsigned int numVertex);
+
+// Renumbers the vertexes of every frame in first use order so fetches walk
+// the vertex buffer forwards
+void OptimizeVertexFetch (std::vector<std::vector<Vertex> >& frames, std::vector<GLuint>& indexes);
+
+// Quadric error half edge collapse down to about targetTriangles triangles.
+// Collapses only ever move a vertex onto a neighbour, so the result indexes
+// the same vertex data and keyframes stay valid; the error is summed over
+// every frame so all frames share one simplification.  Vertexes split by a
+// texture or normal seam collapse together so the seam doesn't crack, only
+// vertexes on open or non manifold edges are kept.
+void SimplifyTriangles (const std::vector<std::vector<Vertex> >& frames, const std::vector<GLuint>& indexes, unsigned int targetTriangles, std::vector<GLuint>& simplified);
+
+// Sphere around every vertex of every frame
+void ComputeBoundingSphere (const std::vector<std::vector<Vertex> >& frames, vec3& center, float& radius);
+
+// Average number of vertex shader runs per triangle with a FIFO cache
+float AverageCacheMissRatio (const std::vector<GLuint>& indexes, unsigned int numVertex, unsigned int cacheSize);
+
+#endif
@@ -0,0 +1,94 @@
+#include "Mutex.h"
+
+#ifdef WIN32
+#include <windows.h>
+
+Mutex::Mutex ()
+	: m_mutex(new CRITICAL_SECTION)
+{
+	InitializeCriticalSection((CRITICAL_SECTION*)m_mutex);
+}
+
+Mutex::~Mutex () {
+	DeleteCriticalSection((CRITICAL_SECTION*)m_mutex);
+	delete (CRITICAL_SECTION*)m_mutex;
+}
+
+void Mutex::Lock () {
+	EnterCriticalSection((CRITICAL_SECTION*)m_mutex);
+}
+
+void Mutex::Unlock () {
+	LeaveCriticalSection((CRITICAL_SECTION*)m_mutex);
+}
+
+Condition::Condition ()
+	: m_condition(new CONDITION_VARIABLE)
+{
+	InitializeConditionVariable((CONDITION_VARIABLE*)m_condition);
+}
+
+// Windows condition variables have no destroy call
+Condition::~Condition () {
+	delete (CONDITION_VARIABLE*)m_condition;
+}
+
+void Condition::Wait (Mutex& mutex) {
+	SleepConditionVariableCS((CONDITION_VARIABLE*)m_condition, (CRITICAL_SECTION*)mutex.m_mutex, INFINITE);
+}
+
+void Condition::Signal () {
+	WakeConditionVariable((CONDITION_VARIABLE*)m_condition);
+}
+
+void Condition::Broadcast () {
+	WakeAllConditionVariable((CONDITION_VARIABLE*)m_condition);
+}
+
+#else
+//***********************************unix specific*********************************
+#include <pthread.h>
+
+Mutex::Mutex ()
+	: m_mutex(new pthread_mutex_t)
+{
+	pthread_mutex_init((pthread_mutex_t*)m_mutex, NULL);
+}
+
+Mutex::~Mutex () {
+	pthread_mutex_destroy((pthread_mutex_t*)m_mutex);
+	delete (pthread_mutex_t*)m_mutex;
+}
+
+void Mutex::Lock () {
+	pthread_mutex_lock((pthread_mutex_t*)m_mutex);
+}
+
+void Mutex::Unlock () {
+	pthread_mutex_unlock((pthread_mutex_t*)m_mutex);
+}
+
+Condition::Condition ()
+	: m_condition(new pthread_cond_t)
+{
+	pthread_cond_init((pthread_cond_t*)m_condition, NULL);
+}
+
+Condition::~Condition () {
+	pthread_cond_destroy((pthread_cond_t*)m_condition);
+	delete (pthread_cond_t*)m_condition;
+}
+
+void Condition::Wait (Mutex& mutex) {
+	pthread_cond_wait((pthread_cond_t*)m_condition, (pthread_mutex_t*)mutex.m_mutex);
+}
+
+void Condition::Signal () {
+	pthread_cond_signal((pthread_cond_t*)m_condition);
+}
+
+void Condition::Broadcast () {
+	pthread_cond_broadcast((pthread_cond_t*)m_condition);
+}
+
+#endif // unix
@@ -0,0 +1,66 @@
+#ifndef __MUTEX_H__
+#define __MUTEX_H__
+
+// Thin wrappers over the platform locking primitives, critical sections and
+// condition variables on Windows and pthreads everywhere else.
+class Mutex
+{
+public:
+	Mutex ();
+	~Mutex ();
+
+	void Lock ();
+	void Unlock ();
+
+private:
+	friend class Condition;
+
+	// Not copyable, the lock is owned
+	Mutex (const Mutex&);
+	Mutex& operator= (const Mutex&);
+
+	void* m_mutex;
+};
+
+// Holds a Mutex until the end of the scope
+class MutexLock
+{
+public:
+	MutexLock (Mutex& mutex)
+		: m_mutex(mutex)
+	{
+		m_mutex.Lock();
+	}
+
+	~MutexLock () {
+		m_mutex.Unlock();
+	}
+
+private:
+	MutexLock (const MutexLock&);
+	MutexLock& operator= (const MutexLock&);
+
+	Mutex& m_mutex;
+};
+
+class Condition
+{
+public:
+	Condition ();
+	~Condition ();
+
+	// The mutex must be held, it is released while waiting and held again on
+	// return.  Wakeups can be spurious so always wait in a loop.
+	void Wait (Mutex& mutex);
+
+	void Signal ();
+	void Broadcast ();
+
+private:
+	Condition (const Condition&);
+	Condition& operator= (const Condition&);
+
+	void* m_condition;
+};
+
+#endif
@@ -0,0 +1,165 @@
+// ------------------------
+// OBJ parser microbenchmark
+// ------------------------
+//
+// Times ParseOBJFile against the tokenizing loader GeometryManager used to
+// have, which is kept below as the reference, and checks both produce the same
+// vertexes.  Built by the objbench target in the Makefile.
+//
+//   objbench [-iterations N] file.obj ...
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Angel.h"
+
+#include "OBJParser.h"
+#include "Timer.h"
+#include "Vertex.h"
+
+static void TokenizeString (const std::string& input, const std::string& delims, std::vector<std::string>& tokens) {
+    tokens.clear();
+
+    std::string::size_type beg_index, end_index;
+
+    beg_index = input.find_first_not_of(delims);
+
+    while (beg_index != std::string::npos) {
+        end_index = input.find_first_of(delims, beg_index);
+        
+		if (end_index == std::string::npos) 
+			end_index = input.length();
+
+        tokens.push_back(input.substr(beg_index, end_index - beg_index));
+        beg_index = input.find_first_not_of(delims,end_index);
+    }
+}
+
+template <typename T>
+static T ConvertString (const std::string& string) {
+	std::stringstream ss(string);
+	T result;
+	return ss >> result ? result : 0;
+}
+
+// The original GeometryManager::LoadOBJFile, minus the buffer upload
+static bool LoadOBJFileReference (const std::string& geometryFile, std::vector<Vertex>& geometryData) {
+	std::ifstream is;
+	is.open (geometryFile.c_str(), std::ios::binary);
+
+	if (!is.is_open())
+		return false;
+	
+	std::vector<std::string> tokens;
+	std::string fileLine;
+
+	std::vector<vec3> vertexes;
+	std::vector<vec3> normals;
+	std::vector<vec2> texCoords;
+
+	while (!is.eof()) {
+	    getline(is, fileLine);
+	    TokenizeString(fileLine, " /", tokens);
+
+		if (tokens.size() == 0)
+			continue;
+
+		if (tokens[0] == "v" && tokens.size() == 4) {
+			vertexes.push_back(vec3(ConvertString<float>(tokens[1]), ConvertString<float>(tokens[2]), ConvertString<float>(tokens[3])));
+		}
+		else if (tokens[0] == "vn" && tokens.size() == 4) {
+			normals.push_back(vec3(ConvertString<float>(tokens[1]), ConvertString<float>(tokens[2]), ConvertString<float>(tokens[3])));
+		}
+		else if (tokens[0] == "vt" && tokens.size() > 2) {
+			texCoords.push_back(vec2(ConvertString<float>(tokens[1]), ConvertString<float>(tokens[2])));
+		}
+		else if (tokens[0] == "f" && tokens.size() == 10) {
+			bool invalid = false;
+			unsigned int v[3], vt[3], vn[3];
+
+			for (int i = 0; i < 3; ++i) {
+				v[i] = ConvertString<int>(tokens[1 + i * 3]) - 1;
+				invalid |= v[i] >= vertexes.size();
+				vt[i] = ConvertString<int>(tokens[2 + i * 3]) - 1;
+				invalid |= vt[i] >= texCoords.size();
+				vn[i] = ConvertString<int>(tokens[3 + i * 3]) - 1;
+				invalid |= vn[i] >= normals.size();
+			}
+
+			if (invalid)
+				continue;
+
+			for (int i = 0; i < 3; ++i)
+				geometryData.push_back(Vertex(vertexes[v[i]], normals[vn[i]], texCoords[vt[i]]));
+		}
+	}
+
+	return !geometryData.empty();
+}
+
+static float maxDifference (const std::vector<Vertex>& a, const std::vector<Vertex>& b) {
+	float difference = 0.0f;
+
+	for (unsigned int i = 0; i < a.size() && i < b.size(); ++i) {
+		const GLfloat* x = (const GLfloat*)&a[i];
+		const GLfloat* y = (const GLfloat*)&b[i];
+
+		for (unsigned int j = 0; j < sizeof(Vertex) / sizeof(GLfloat); ++j) {
+			float d = fabs(x[j] - y[j]);
+			if (d > difference)
+				difference = d;
+		}
+	}
+
+	return difference;
+}
+
+int main (int argc, char** argv) {
+	int iterations = 10;
+	std::vector<std::string> files;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+			iterations = atoi(argv[++i]);
+		else
+			files.push_back(argv[i]);
+	}
+
+	if (files.empty()) {
+		printf("usage: %s [-iterations N] file.obj ...\n", argv[0]);
+		return 1;
+	}
+
+	for (std::vector<std::string>::iterator iter = files.begin(); iter != files.end(); ++iter) {
+		std::vector<Vertex> reference;
+		std::vector<Vertex> parsed;
+
+		Timer referenceTimer;
+		for (int i = 0; i < iterations; ++i) {
+			reference.clear();
+			LoadOBJFileReference(*iter, reference);
+		}
+		float referenceTime = referenceTimer.GetElapsedTime() * 1000.0f / iterations;
+
+		Timer parsedTimer;
+		for (int i = 0; i < iterations; ++i) {
+			std::vector<Vertex> vertexData;
+			ParseOBJFile(*iter, vertexData);
+			parsed.swap(vertexData);
+		}
+		float parsedTime = parsedTimer.GetElapsedTime() * 1000.0f / iterations;
+
+		printf("%s\n", iter->c_str());
+		printf("  reference:  %8.2f ms  %u vertexes\n", referenceTime, (unsigned int)reference.size());
+		printf("  streaming:  %8.2f ms  %u vertexes\n", parsedTime, (unsigned int)parsed.size());
+		printf("  speedup:    %8.1fx\n", parsedTime > 0.0f ? referenceTime / parsedTime : 0.0f);
+		printf("  max error:  %g\n", maxDifference(reference, parsed));
+	}
+
+	return 0;
+}
@@ -0,0 +1,327 @@
+#include "OBJParser.h"
+
+#include <cstring>
+
+#include "MappedFile.h"
+
+namespace {
+
+struct FaceCorner
+{
+	int m_position;
+	int m_texCoord;
+	int m_normal;
+};
+
+inline bool IsBlank (char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool IsDigit (char c) {
+	return c >= '0' && c <= '9';
+}
+
+inline const char* SkipBlanks (const char* p, const char* end) {
+	while (p < end && IsBlank(*p))
+		++p;
+	return p;
+}
+
+// Returns the position after the number, or p itself if there is none
+const char* ParseInt (const char* p, const char* end, int& value) {
+	const char* start = p;
+	bool negative = false;
+
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	if (p == end || !IsDigit(*p))
+		return start;
+
+	int result = 0;
+	while (p < end && IsDigit(*p))
+		result = result * 10 + (*p++ - '0');
+
+	value = negative ? -result : result;
+	return p;
+}
+
+// Returns the position after the number, or p itself if there is none
+const char* ParseFloat (const char* p, const char* end, float& value) {
+	static const double c_powers_of_ten[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 
+		1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+	};
+
+	const char* start = p;
+	bool negative = false;
+
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	unsigned long long mantissa = 0;
+	int exponent = 0;
+	int digits = 0;
+	bool anyDigits = false;
+
+	// Digits beyond what fits in the mantissa only shift the exponent
+	while (p < end && IsDigit(*p)) {
+		if (digits < 18) {
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa != 0)
+				++digits;
+		}
+		else {
+			++exponent;
+		}
+		++p;
+		anyDigits = true;
+	}
+
+	if (p < end && *p == '.') {
+		++p;
+		while (p < end && IsDigit(*p)) {
+			if (digits < 18) {
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa != 0)
+					++digits;
+				--exponent;
+			}
+			++p;
+			anyDigits = true;
+		}
+	}
+
+	if (!anyDigits)
+		return start;
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		int fileExponent = 0;
+		const char* exponentEnd = ParseInt(p + 1, end, fileExponent);
+		if (exponentEnd != p + 1) {
+			exponent += fileExponent;
+			p = exponentEnd;
+		}
+	}
+
+	double result = (double)mantissa;
+
+	while (exponent > 18) {
+		result *= c_powers_of_ten[18];
+		exponent -= 18;
+	}
+	while (exponent < -18) {
+		result /= c_powers_of_ten[18];
+		exponent += 18;
+	}
+
+	if (exponent > 0)
+		result *= c_powers_of_ten[exponent];
+	else if (exponent < 0)
+		result /= c_powers_of_ten[-exponent];
+
+	value = (float)(negative ? -result : result);
+	return p;
+}
+
+// Parses up to count floats, returns false if fewer than required were found
+bool ParseFloats (const char* p, const char* end, float* values, int required, int count) {
+	for (int i = 0; i < count; ++i) {
+		p = SkipBlanks(p, end);
+		const char* next = ParseFloat(p, end, values[i]);
+
+		if (next == p)
+			return i >= required;
+
+		p = next;
+	}
+
+	return true;
+}
+
+// Turns a 1 based or negative relative OBJ index into a 0 based one
+inline bool ResolveIndex (int index, unsigned int count, unsigned int& resolved) {
+	if (index > 0)
+		resolved = index - 1;
+	else if (index < 0)
+		resolved = count + index;
+	else
+		return false;
+
+	return resolved < count;
+}
+
+}
+
+bool ParseOBJFile (const std::string& fileName, std::vector<Vertex>& vertexData) {
+	MappedFile file;
+
+	if (!file.Open(fileName)) {
+		printf("ParseOBJFile: Error loading file %s.\n", fileName.c_str());
+		return false;
+	}
+
+	if (!ParseOBJData(file.GetData(), file.GetSize(), vertexData)) {
+		printf("ParseOBJFile: Empty model file %s\n", fileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool ParseOBJData (const char* data, unsigned int size, std::vector<Vertex>& vertexData) {
+	const char* end = data + size;
+
+	std::vector<vec3> positions;
+	std::vector<vec3> normals;
+	std::vector<vec2> texCoords;
+	std::vector<FaceCorner> corners;
+
+	// Size the arrays up front from the line prefixes so nothing regrows
+	{
+		unsigned int numPositions = 0;
+		unsigned int numNormals = 0;
+		unsigned int numTexCoords = 0;
+		unsigned int numFaces = 0;
+
+		for (const char* line = data; line < end; ) {
+			const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+			if (lineEnd == NULL)
+				lineEnd = end;
+
+			if (lineEnd - line > 1) {
+				if (line[0] == 'v' && IsBlank(line[1]))
+					++numPositions;
+				else if (line[0] == 'v' && line[1] == 'n')
+					++numNormals;
+				else if (line[0] == 'v' && line[1] == 't')
+					++numTexCoords;
+				else if (line[0] == 'f' && IsBlank(line[1]))
+					++numFaces;
+			}
+
+			line = lineEnd + 1;
+		}
+
+		positions.reserve(numPositions);
+		normals.reserve(numNormals);
+		texCoords.reserve(numTexCoords);
+		vertexData.reserve(vertexData.size() + numFaces * 3);
+	}
+
+	for (const char* line = data; line < end; ) {
+		const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+		if (lineEnd == NULL)
+			lineEnd = end;
+
+		const char* p = SkipBlanks(line, lineEnd);
+		const char* next = lineEnd + 1;
+
+		if (lineEnd - p < 2) {
+			line = next;
+			continue;
+		}
+
+		float values[3];
+
+		if (p[0] == 'v' && IsBlank(p[1])) {
+			if (ParseFloats(p + 2, lineEnd, values, 3, 3))
+				positions.push_back(vec3(values[0], values[1], values[2]));
+		}
+		else if (p[0] == 'v' && p[1] == 'n' && IsBlank(p[2])) {
+			if (ParseFloats(p + 3, lineEnd, values, 3, 3))
+				normals.push_back(vec3(values[0], values[1], values[2]));
+		}
+		else if (p[0] == 'v' && p[1] == 't' && IsBlank(p[2])) {
+			if (ParseFloats(p + 3, lineEnd, values, 2, 2))
+				texCoords.push_back(vec2(values[0], values[1]));
+		}
+		else if (p[0] == 'f' && IsBlank(p[1])) {
+			corners.clear();
+			p += 2;
+
+			bool invalid = false;
+
+			while (true) {
+				p = SkipBlanks(p, lineEnd);
+				if (p == lineEnd)
+					break;
+
+				FaceCorner corner = { 0, 0, 0 };
+
+				const char* cornerEnd = ParseInt(p, lineEnd, corner.m_position);
+				invalid |= cornerEnd == p;
+				p = cornerEnd;
+
+				if (p < lineEnd && *p == '/') {
+					++p;
+					if (p < lineEnd && *p != '/')
+						p = ParseInt(p, lineEnd, corner.m_texCoord);
+					if (p < lineEnd && *p == '/')
+						p = ParseInt(p + 1, lineEnd, corner.m_normal);
+				}
+
+				if (p < lineEnd && !IsBlank(*p)) {
+					invalid = true;
+					break;
+				}
+
+				corners.push_back(corner);
+			}
+
+			invalid |= corners.size() < 3;
+
+			// Resolve every corner before emitting anything for the face
+			unsigned int cornerCount = corners.size();
+			for (unsigned int i = 0; i < cornerCount && !invalid; ++i) {
+				FaceCorner& corner = corners[i];
+				unsigned int resolved = 0;
+
+				invalid |= !ResolveIndex(corner.m_position, positions.size(), resolved);
+				corner.m_position = resolved;
+
+				if (corner.m_texCoord != 0) {
+					invalid |= !ResolveIndex(corner.m_texCoord, texCoords.size(), resolved);
+					corner.m_texCoord = resolved;
+				}
+				else {
+					corner.m_texCoord = -1;
+				}
+
+				if (corner.m_normal != 0) {
+					invalid |= !ResolveIndex(corner.m_normal, normals.size(), resolved);
+					corner.m_normal = resolved;
+				}
+				else {
+					corner.m_normal = -1;
+				}
+			}
+
+			if (invalid) {
+				printf("ParseOBJData: Invalid face\n");
+			}
+			else {
+				vec3 faceNormal = cross(positions[corners[1].m_position] - positions[corners[0].m_position],
+										positions[corners[2].m_position] - positions[corners[0].m_position]);
+				faceNormal = length(faceNormal) > 0.0f ? normalize(faceNormal) : vec3(0.0f, 1.0f, 0.0f);
+
+				// Fan triangulate polygons around the first corner
+				for (unsigned int i = 1; i + 1 < cornerCount; ++i) {
+					const unsigned int triangle[3] = { 0, i, i + 1 };
+
+					for (int j = 0; j < 3; ++j) {
+						const FaceCorner& corner = corners[triangle[j]];
+
+						vertexData.push_back(Vertex(positions[corner.m_position], 
+													corner.m_normal >= 0 ? normals[corner.m_normal] : faceNormal,
+													corner.m_texCoord >= 0 ? texCoords[corner.m_texCoord] : vec2(0.0f, 0.0f)));
+					}
+				}
+			}
+		}
+
+		line = next;
+	}
+
+	return !vertexData.empty();
+}
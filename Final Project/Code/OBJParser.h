@@ -0,0 +1,24 @@
+#ifndef __OBJPARSER_H__
+#define __OBJPARSER_H__
+
+#include <string>
+#include <vector>
+
+#include "Angel.h"
+
+#include "Vertex.h"
+
+// Parses a Wavefront OBJ file into a triangle list of expanded vertexes.
+//
+// The file is memory mapped and scanned once with numbers parsed in place, so
+// no strings are built per line or per token.  Faces may be triangles, quads
+// or larger polygons (fan triangulated), indexes may be negative (relative to
+// the end of the list so far), and corners may be written v, v/vt, v//vn or
+// v/vt/vn.  Corners without a texture coordinate get (0, 0) and faces without
+// normals get their flat face normal.
+bool ParseOBJFile (const std::string& fileName, std::vector<Vertex>& vertexData);
+
+// Same as ParseOBJFile for a buffer that is already in memory
+bool ParseOBJData (const char* data, unsigned int size, std::vector<Vertex>& vertexData);
+
+#endif
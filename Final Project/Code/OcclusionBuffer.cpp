@@ -0,0 +1,252 @@
+#include "OcclusionBuffer.h"
+
+#include <float.h>
+#include <math.h>
+
+// Texels a test may read at a finer level after the coarse one it starts at
+// wasn't conclusive
+static const unsigned int c_max_test_texels = 16;
+
+// Corner i of a box is at the maximum x when bit 0 is set, y for bit 1 and z
+// for bit 2.  Each face is a quad, counter clockwise seen from outside.
+static const unsigned int c_box_faces[6][4] = {
+	{ 0, 4, 6, 2 },
+	{ 1, 3, 7, 5 },
+	{ 0, 1, 5, 4 },
+	{ 2, 6, 7, 3 },
+	{ 0, 2, 3, 1 },
+	{ 4, 5, 7, 6 }
+};
+
+OcclusionBuffer::OcclusionBuffer (unsigned int width, unsigned int height) {
+	unsigned int start = 0;
+
+	for (;;) {
+		Level level;
+		level.m_width = width > 0 ? width : 1;
+		level.m_height = height > 0 ? height : 1;
+		level.m_start = start;
+
+		m_levels.push_back(level);
+		start += level.m_width * level.m_height;
+
+		if (level.m_width == 1 && level.m_height == 1)
+			break;
+
+		width = (level.m_width + 1) / 2;
+		height = (level.m_height + 1) / 2;
+	}
+
+	m_depth.resize(start);
+	Clear();
+}
+
+void OcclusionBuffer::Clear () {
+	for (unsigned int i = 0; i < m_depth.size(); ++i)
+		m_depth[i] = FLT_MAX;
+}
+
+bool OcclusionBuffer::ProjectBox (const mat4& viewProjectionMatrix, const vec3& minimum, const vec3& maximum, vec3* corners) const {
+	float width = (float)m_levels[0].m_width;
+	float height = (float)m_levels[0].m_height;
+
+	for (unsigned int i = 0; i < 8; ++i) {
+		vec4 corner(i & 1 ? maximum.x : minimum.x, i & 2 ? maximum.y : minimum.y, i & 4 ? maximum.z : minimum.z, 1.0f);
+		vec4 clip = viewProjectionMatrix * corner;
+
+		if (clip.w <= 0.0f || clip.z < -clip.w)
+			return false;
+
+		corners[i] = vec3((clip.x / clip.w * 0.5f + 0.5f) * width, (clip.y / clip.w * 0.5f + 0.5f) * height, clip.z / clip.w);
+	}
+
+	return true;
+}
+
+void OcclusionBuffer::RasterizeBox (const mat4& viewProjectionMatrix, const vec3& minimum, const vec3& maximum) {
+	vec3 corners[8];
+
+	if (!ProjectBox(viewProjectionMatrix, minimum, maximum, corners))
+		return;
+
+	for (unsigned int i = 0; i < 6; ++i) {
+		const unsigned int* face = c_box_faces[i];
+
+		RasterizeTriangle(corners[face[0]], corners[face[1]], corners[face[2]]);
+		RasterizeTriangle(corners[face[0]], corners[face[2]], corners[face[3]]);
+	}
+}
+
+void OcclusionBuffer::RasterizeTriangle (const vec3& v0, const vec3& v1, const vec3& v2) {
+	// Twice the signed area, clockwise triangles face away from the camera
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+
+	if (!(area > 0.0f))
+		return;
+
+	const Level& level = m_levels[0];
+
+	// Bounds clamped to the buffer before they are made integers
+	float minimumX = v0.x < v1.x ? (v0.x < v2.x ? v0.x : v2.x) : (v1.x < v2.x ? v1.x : v2.x);
+	float maximumX = v0.x > v1.x ? (v0.x > v2.x ? v0.x : v2.x) : (v1.x > v2.x ? v1.x : v2.x);
+	float minimumY = v0.y < v1.y ? (v0.y < v2.y ? v0.y : v2.y) : (v1.y < v2.y ? v1.y : v2.y);
+	float maximumY = v0.y > v1.y ? (v0.y > v2.y ? v0.y : v2.y) : (v1.y > v2.y ? v1.y : v2.y);
+
+	minimumX = minimumX > 0.0f ? minimumX : 0.0f;
+	minimumY = minimumY > 0.0f ? minimumY : 0.0f;
+	maximumX = maximumX < (float)level.m_width ? maximumX : (float)level.m_width;
+	maximumY = maximumY < (float)level.m_height ? maximumY : (float)level.m_height;
+
+	// Texels whose centers are inside the bounds
+	int y0 = (int)ceil(minimumY - 0.5f);
+	int y1 = (int)floor(maximumY - 0.5f);
+
+	if (minimumX > maximumX || y0 > y1)
+		return;
+
+	// Depth is linear in screen space
+	float depthX = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	float depthY = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+
+	const vec3* vertexes[3] = { &v0, &v1, &v2 };
+
+	for (int y = y0; y <= y1; ++y) {
+		float centerY = y + 0.5f;
+
+		// Each edge is a line, inside is to its left.  Solving the three edge
+		// functions for x gives the row's span, so the inner loop is a plain
+		// depth compare over consecutive texels.
+		float left = minimumX;
+		float right = maximumX;
+
+		for (unsigned int i = 0; i < 3; ++i) {
+			const vec3& a = *vertexes[i];
+			const vec3& b = *vertexes[(i + 1) % 3];
+
+			// edge(x) = slope * x + offset
+			float slope = a.y - b.y;
+			float offset = (b.x - a.x) * (centerY - a.y) - slope * a.x;
+
+			if (slope > 0.0f) {
+				float x = -offset / slope;
+				left = x > left ? x : left;
+			}
+			else if (slope < 0.0f) {
+				float x = -offset / slope;
+				right = x < right ? x : right;
+			}
+			else if (offset < 0.0f) {
+				right = -1.0f;
+			}
+		}
+
+		if (left > right)
+			continue;
+
+		int x0 = (int)ceil(left - 0.5f);
+		int x1 = (int)floor(right - 0.5f);
+		x1 = x1 < (int)level.m_width - 1 ? x1 : (int)level.m_width - 1;
+
+		float* row = &m_depth[level.m_start + y * level.m_width];
+		float rowDepth = v0.z + depthX * (0.5f - v0.x) + depthY * (centerY - v0.y);
+
+		for (int x = x0; x <= x1; ++x) {
+			float depth = rowDepth + depthX * x;
+			row[x] = depth < row[x] ? depth : row[x];
+		}
+	}
+}
+
+void OcclusionBuffer::BuildHierarchy () {
+	for (unsigned int i = 1; i < m_levels.size(); ++i) {
+		const Level& source = m_levels[i - 1];
+		const Level& level = m_levels[i];
+
+		for (unsigned int y = 0; y < level.m_height; ++y) {
+			// Odd sizes repeat the last row or column
+			unsigned int y0 = y * 2;
+			unsigned int y1 = y0 + 1 < source.m_height ? y0 + 1 : y0;
+
+			const float* row0 = &m_depth[source.m_start + y0 * source.m_width];
+			const float* row1 = &m_depth[source.m_start + y1 * source.m_width];
+			float* row = &m_depth[level.m_start + y * level.m_width];
+
+			for (unsigned int x = 0; x < level.m_width; ++x) {
+				unsigned int x0 = x * 2;
+				unsigned int x1 = x0 + 1 < source.m_width ? x0 + 1 : x0;
+
+				float depth0 = row0[x0] > row0[x1] ? row0[x0] : row0[x1];
+				float depth1 = row1[x0] > row1[x1] ? row1[x0] : row1[x1];
+
+				row[x] = depth0 > depth1 ? depth0 : depth1;
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::IsRectOccluded (unsigned int level, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, float depth) const {
+	const Level& rectLevel = m_levels[level];
+
+	for (unsigned int y = y0; y <= y1; ++y) {
+		const float* row = &m_depth[rectLevel.m_start + y * rectLevel.m_width];
+
+		for (unsigned int x = x0; x <= x1; ++x) {
+			if (!(row[x] < depth))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool OcclusionBuffer::IsOccluded (const mat4& viewProjectionMatrix, const vec3& minimum, const vec3& maximum) const {
+	vec3 corners[8];
+
+	if (!ProjectBox(viewProjectionMatrix, minimum, maximum, corners))
+		return false;
+
+	// The box's nearest depth is at one of its corners
+	vec3 rectMinimum = corners[0];
+	vec3 rectMaximum = corners[0];
+
+	for (unsigned int i = 1; i < 8; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			rectMinimum[j] = corners[i][j] < rectMinimum[j] ? corners[i][j] : rectMinimum[j];
+			rectMaximum[j] = corners[i][j] > rectMaximum[j] ? corners[i][j] : rectMaximum[j];
+		}
+	}
+
+	const Level& level = m_levels[0];
+
+	// Off the buffer is for the frustum test to decide
+	if (rectMaximum.x < 0.0f || rectMaximum.y < 0.0f || rectMinimum.x >= (float)level.m_width || rectMinimum.y >= (float)level.m_height)
+		return false;
+
+	// Every texel the rectangle touches and one more around it.  Occluders
+	// only cover the texels whose centers they cover, so the texels along
+	// their edges are partly open.
+	unsigned int x0 = rectMinimum.x > 1.0f ? (unsigned int)rectMinimum.x - 1 : 0;
+	unsigned int y0 = rectMinimum.y > 1.0f ? (unsigned int)rectMinimum.y - 1 : 0;
+	unsigned int x1 = rectMaximum.x < (float)(level.m_width - 2) ? (unsigned int)rectMaximum.x + 1 : level.m_width - 1;
+	unsigned int y1 = rectMaximum.y < (float)(level.m_height - 2) ? (unsigned int)rectMaximum.y + 1 : level.m_height - 1;
+
+	// Start at the finest level where the rectangle is 2x2 texels at most
+	unsigned int test = 0;
+	while (test + 1 < m_levels.size() && ((x1 >> test) - (x0 >> test) > 1 || (y1 >> test) - (y0 >> test) > 1))
+		++test;
+
+	for (;;) {
+		if (IsRectOccluded(test, x0 >> test, y0 >> test, x1 >> test, y1 >> test, rectMinimum.z))
+			return true;
+
+		if (test == 0)
+			return false;
+
+		// A finer level has less of the surroundings mixed in, but its texels
+		// cost more to read
+		--test;
+
+		if (((x1 >> test) - (x0 >> test) + 1) * ((y1 >> test) - (y0 >> test) + 1) > c_max_test_texels)
+			return false;
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef __OCCLUSIONBUFFER_H__
+#define __OCCLUSIONBUFFER_H__
+
+#include <vector>
+
+#include "Angel.h"
+
+// Low resolution depth buffer that occluder boxes are rasterized into on the
+// CPU and occludees are tested against.  Depth is clip space z / w and the
+// nearest occluder wins.  Each coarser level holds the farthest depth of a
+// 2x2 block of the one before, so a test only reads a few texels whatever
+// the occludee's size on screen.
+class OcclusionBuffer
+{
+public:
+	OcclusionBuffer (unsigned int width, unsigned int height);
+
+	// Every texel of every level at infinite depth
+	void Clear ();
+
+	// Front faces of the box.  Boxes reaching in front of the near plane are
+	// skipped rather than clipped, they can only hide less.
+	void RasterizeBox (const mat4& viewProjectionMatrix, const vec3& minimum, const vec3& maximum);
+
+	// Fills the coarser levels, once the last occluder is rasterized
+	void BuildHierarchy ();
+
+	// Whether the box is behind occluders everywhere it covers, boxes that
+	// reach in front of the near plane never are
+	bool IsOccluded (const mat4& viewProjectionMatrix, const vec3& minimum, const vec3& maximum) const;
+
+	unsigned int GetWidth () const { return m_levels[0].m_width; }
+	unsigned int GetHeight () const { return m_levels[0].m_height; }
+
+private:
+	struct Level
+	{
+		unsigned int m_width;
+		unsigned int m_height;
+
+		// Of the level's first texel in m_depth
+		unsigned int m_start;
+	};
+
+	// Corners in buffer texels with their depth, false when one is in front
+	// of the near plane
+	bool ProjectBox (const mat4& viewProjectionMatrix, const vec3& minimum, const vec3& maximum, vec3* corners) const;
+
+	// Counter clockwise triangles only, in buffer texels
+	void RasterizeTriangle (const vec3& v0, const vec3& v1, const vec3& v2);
+
+	// Whether every texel of the inclusive rectangle is nearer than depth
+	bool IsRectOccluded (unsigned int level, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, float depth) const;
+
+	std::vector<Level> m_levels;
+
+	// Every level one after the other, rows bottom up like GL's
+	std::vector<float> m_depth;
+};
+
+#endif
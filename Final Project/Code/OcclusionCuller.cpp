@@ -0,0 +1,68 @@
+#include "OcclusionCuller.h"
+
+#include "Timer.h"
+
+OcclusionCuller::OcclusionCuller (WorkerPool& workerPool, unsigned int width, unsigned int height)
+	: m_workerPool(workerPool), m_buffer(width, height), m_numRasterized(0), m_rasterizeTime(0.0f), m_running(false)
+{
+}
+
+OcclusionCuller::~OcclusionCuller () {
+	Finish();
+}
+
+void OcclusionCuller::AddOccluder (const vec3& minimum, const vec3& maximum) {
+	// The job reads the list
+	Finish();
+
+	Occluder occluder;
+	occluder.m_minimum = minimum;
+	occluder.m_maximum = maximum;
+
+	m_occluders.push_back(occluder);
+}
+
+void OcclusionCuller::Begin (const mat4& viewProjectionMatrix) {
+	Finish();
+
+	m_viewProjectionMatrix = viewProjectionMatrix;
+	m_frustum = ViewFrustum(viewProjectionMatrix);
+
+	m_running = true;
+	m_workerPool.Submit(this);
+}
+
+bool OcclusionCuller::Finish () {
+	if (!m_running)
+		return false;
+
+	m_workerPool.Wait();
+	m_running = false;
+
+	return true;
+}
+
+void OcclusionCuller::Run () {
+	Timer rasterizeTimer;
+
+	m_buffer.Clear();
+	m_numRasterized = 0;
+
+	for (unsigned int i = 0; i < m_occluders.size(); ++i) {
+		const Occluder& occluder = m_occluders[i];
+
+		if (!m_frustum.IntersectsSphere((occluder.m_minimum + occluder.m_maximum) * 0.5f, length(occluder.m_maximum - occluder.m_minimum) * 0.5f))
+			continue;
+
+		m_buffer.RasterizeBox(m_viewProjectionMatrix, occluder.m_minimum, occluder.m_maximum);
+		++m_numRasterized;
+	}
+
+	m_buffer.BuildHierarchy();
+
+	m_rasterizeTime = rasterizeTimer.GetElapsedTime();
+}
+
+bool OcclusionCuller::IsOccluded (const vec3& center, float radius) const {
+	return m_buffer.IsOccluded(m_viewProjectionMatrix, center - vec3(radius), center + vec3(radius));
+}
@@ -0,0 +1,67 @@
+#ifndef __OCCLUSIONCULLER_H__
+#define __OCCLUSIONCULLER_H__
+
+#include <vector>
+
+#include "Angel.h"
+
+#include "OcclusionBuffer.h"
+#include "ViewFrustum.h"
+#include "WorkerPool.h"
+
+// Rasterizes a frame's occluders into an OcclusionBuffer on the worker pool
+// while the rest of the frame is submitted, so the buffer is only waited for
+// once the queued batches are tested against it.
+class OcclusionCuller : public WorkerJob
+{
+public:
+	OcclusionCuller (WorkerPool& workerPool, unsigned int width, unsigned int height);
+
+	// Waits for a rasterization still in flight
+	~OcclusionCuller ();
+
+	// Only boxes that are solid from every side, an occluder hides whatever
+	// is behind any part of it
+	void AddOccluder (const vec3& minimum, const vec3& maximum);
+
+	// Starts rasterizing the occluders in view of the matrix
+	void Begin (const mat4& viewProjectionMatrix);
+
+	// Waits for the rasterization Begin started, false when there is none
+	bool Finish ();
+
+	// Valid from Finish until the next Begin
+	bool IsOccluded (const vec3& center, float radius) const;
+
+	unsigned int GetNumOccluders () const { return m_occluders.size(); }
+
+	// Of the last rasterization, the occluders in view and the seconds it took
+	unsigned int GetNumRasterized () const { return m_numRasterized; }
+	float GetRasterizeTime () const { return m_rasterizeTime; }
+
+private:
+	OcclusionCuller (const OcclusionCuller&);
+	OcclusionCuller& operator= (const OcclusionCuller&);
+
+	virtual void Run ();
+
+	struct Occluder
+	{
+		vec3 m_minimum;
+		vec3 m_maximum;
+	};
+
+	WorkerPool& m_workerPool;
+	std::vector<Occluder> m_occluders;
+
+	// Only the job touches these between Begin and Finish
+	OcclusionBuffer m_buffer;
+	mat4 m_viewProjectionMatrix;
+	ViewFrustum m_frustum;
+	unsigned int m_numRasterized;
+	float m_rasterizeTime;
+
+	bool m_running;
+};
+
+#endif
@@ -3,6 +3,8 @@
 #include "Angel.h"
 
 #include "GraphicsSettings.h"
+#include "GLStateCache.h"
+#include "UniformBlocks.h"
 #include "Vertex.h"
 
 PostProcessShader::PostProcessShader (const std::string& vertShader, const std::string& fragShader)
@@ -14,11 +16,10 @@ PostProcessShader::PostProcessShader (const std::string& vertShader, const std::
 	b_blurY = glGetUniformLocation(m_program, "b_blurY");
 	b_depthOfField = glGetUniformLocation(m_program, "b_depthOfField");
 
-	m_colorCorrection = glGetUniformLocation(m_program, "colorCorrection");
 	m_randSeed = glGetUniformLocation(m_program, "randSeed");
 
-	m_windowWidth = glGetUniformLocation(m_program, "windowWidth");
-	m_windowHeight = glGetUniformLocation(m_program, "windowHeight");
+	// The color correction and window size come from the frame block
+	BindUniformBlock("FrameUniforms", e_UniformBlockFrame);
 
 	// bind samplers to texture units
 	glUniform1i(glGetUniformLocation(m_program, "renderPassSource0"), e_TextureChannelRenderPassSource0 - e_TextureChannelFirst);
@@ -31,19 +32,28 @@ PostProcessShader::~PostProcessShader () {
 
 void PostProcessShader::SetShaderState (const ShaderState* shaderState) {
 	const PostProcessShaderState* postProcessShaderState = (PostProcessShaderState*)shaderState;
+	GLStateCache& stateCache = GLStateCache::Get();
 
-	glUniform1i(b_blurX, postProcessShaderState->b_blurX);
-	glUniform1i(b_blurY, postProcessShaderState->b_blurY);
-	glUniform1i(b_depthOfField, postProcessShaderState->b_depthOfField);
+	SetUniform(b_blurX, postProcessShaderState->b_blurX, m_currentState.b_blurX);
+	SetUniform(b_blurY, postProcessShaderState->b_blurY, m_currentState.b_blurY);
+	SetUniform(b_depthOfField, postProcessShaderState->b_depthOfField, m_currentState.b_depthOfField);
 
-	glUniformMatrix4fv(m_colorCorrection, 1, GL_TRUE, (GLfloat*)&postProcessShaderState->m_colorCorrection);
+	// Different for every pass
 	glUniform1i(m_randSeed, postProcessShaderState->m_randSeed);
-	
-	glUniform1f(m_windowWidth, (GLfloat)Settings::Get().s_windowWidth);
-	glUniform1f(m_windowHeight, (GLfloat)Settings::Get().s_windowHeight);
+	stateCache.CountIssued();
 
- 	glEnableVertexAttribArray(m_vPosition);
-	glVertexAttribPointer(m_vPosition, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), BUFFER_OFFSET(postProcessShaderState->m_attributeLocation.m_position0));
+	stateCache.SetVertexAttribArray(m_vPosition, true);
+	stateCache.SetVertexAttribPointer(m_vPosition, postProcessShaderState->m_attributeLocation.m_vertexBuffer, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), postProcessShaderState->m_attributeLocation.m_position0);
+}
+
+void PostProcessShader::SetUniform (GLuint location, int value, static_branch& current) {
+	if (value == current) {
+		GLStateCache::Get().CountElided();
+		return;
+	}
+
+	glUniform1i(location, value);
+	GLStateCache::Get().CountIssued();
 
-	m_currentState = *postProcessShaderState;
+	current = value;
 }
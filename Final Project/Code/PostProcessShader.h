@@ -12,21 +12,21 @@ public:
 	~PostProcessShader ();
 
 	void SetShaderState (const ShaderState* shaderState);
-	void HandleShaderFlags (std::vector<std::string> shaderFlags);
+	void HandleShaderFlags (const std::vector<std::string>& shaderFlags);
 
 private:
+	// Uniforms keep their values in the program, which links them as 0 like
+	// m_currentState starts out
+	void SetUniform (GLuint location, int value, static_branch& current);
+
 	GLuint m_vPosition;
 
 	GLuint b_blurX;
 	GLuint b_blurY;
 	GLuint b_depthOfField;
 
-	GLuint m_colorCorrection;
 	GLuint m_randSeed;
 
-	GLuint m_windowWidth;
-	GLuint m_windowHeight;
-
 	PostProcessShaderState m_currentState;
 };
 
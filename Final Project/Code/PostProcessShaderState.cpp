@@ -1,7 +1,7 @@
 #include "PostProcessShaderState.h"
 
-void PostProcessShaderState::HandleShaderFlags (std::vector<std::string> shaderFlags) {
-	for (std::vector<std::string>::iterator flagIter = shaderFlags.begin(); flagIter != shaderFlags.end(); ++flagIter) {
+void PostProcessShaderState::HandleShaderFlags (const std::vector<std::string>& shaderFlags) {
+	for (std::vector<std::string>::const_iterator flagIter = shaderFlags.begin(); flagIter != shaderFlags.end(); ++flagIter) {
 		if (*flagIter == "blurX") {
 			b_blurX = true;
 		}
@@ -18,6 +18,5 @@ void PostProcessShaderState::HandleShaderFlags (std::vector<std::string> shaderF
 }
 
 void PostProcessShaderState::CalculateShaderState (const RenderParameters& renderParameters, const EffectParameters& effectParameters) {
-	m_colorCorrection = renderParameters.m_colorCorrection;
 	m_randSeed = rand();
 }
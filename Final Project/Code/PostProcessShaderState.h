@@ -12,14 +12,13 @@ struct PostProcessShaderState : public ShaderState
 		: b_blurX(false), b_blurY(false), b_depthOfField(false)
 	{}
 
-	void HandleShaderFlags (std::vector<std::string> shaderFlags);
+	void HandleShaderFlags (const std::vector<std::string>& shaderFlags);
 	void CalculateShaderState (const RenderParameters& renderParameters, const EffectParameters& effectParameters);
 
 	static_branch b_blurX;
 	static_branch b_blurY;
 	static_branch b_depthOfField;
 
-	mat4 m_colorCorrection;
 	int m_randSeed;
 };
 
@@ -0,0 +1,33 @@
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+// Pseudo random numbers for the game simulation.
+//
+// The simulation used to share rand() with the renderer, which draws from it
+// every frame for the post process noise, and rand() produces a different
+// sequence on every C runtime.  Keeping a separate generator means a seed
+// always produces the same world and the same monster spawns, which the
+// input record/replay logs rely on.  The generator is the same LCG the MSVC
+// runtime uses, so Windows builds see the sequence they always have.
+
+const int c_random_max = 0x7fff;
+
+class Random
+{
+public:
+	static void Seed (unsigned int seed) { State() = seed; }
+
+	// Returns a value between 0 and c_random_max, like rand()
+	static int Next () {
+		State() = State() * 214013u + 2531011u;
+		return (State() >> 16) & c_random_max;
+	}
+
+private:
+	static unsigned int& State () {
+		static unsigned int s_state = 1;
+		return s_state;
+	}
+};
+
+#endif
@@ -1,13 +1,12 @@
 #ifndef __RENDERBATCH_H__
 #define __RENDERBATCH_H__
 
-#include <string>
-
+#include "AssetID.h"
 #include "EffectParameters.h"
 
 struct RenderBatch
 {
-	std::string m_geometryID;
+	AssetID m_geometryID;
 	EffectParameters m_effectParameters;
 };
 
@@ -0,0 +1,298 @@
+#include "RenderGraph.h"
+
+#include <set>
+#include <stdio.h>
+
+#include "FrameBufferTexture.h"
+
+// colorAttach0 of the passes that draw to the window
+static const char* c_screen_buffer = "screen";
+
+static bool HasFlag (const RenderPass& pass, const char* flag) {
+	for (unsigned int i = 0; i < pass.m_flags.size(); ++i) {
+		if (pass.m_flags[i] == flag)
+			return true;
+	}
+
+	return false;
+}
+
+RenderGraph::RenderGraph ()
+	: m_numErrors(0)
+{}
+
+void RenderGraph::AddBuffer (const std::string& name, const std::string& format, float widthRatio, float heightRatio) {
+	if (name == c_screen_buffer || m_buffers.find(name) != m_buffers.end()) {
+		printf("RenderGraph::AddBuffer: Buffer %s is already declared.\n", name.c_str());
+		++m_numErrors;
+		return;
+	}
+
+	if (FrameBufferTexture::GetBytesPerPixel(format) == 0) {
+		printf("RenderGraph::AddBuffer: Buffer %s has invalid format %s.\n", name.c_str(), format.c_str());
+		++m_numErrors;
+		return;
+	}
+
+	if (!(widthRatio > 0.0f) || !(heightRatio > 0.0f)) {
+		printf("RenderGraph::AddBuffer: Buffer %s has no size.\n", name.c_str());
+		++m_numErrors;
+		return;
+	}
+
+	Buffer buffer;
+	buffer.m_format = format;
+	buffer.m_widthRatio = widthRatio;
+	buffer.m_heightRatio = heightRatio;
+
+	m_buffers[name] = buffer;
+}
+
+void RenderGraph::AddPass (const RenderPass& pass) {
+	m_declaredPasses.push_back(pass);
+}
+
+bool RenderGraph::Compile (unsigned int windowWidth, unsigned int windowHeight) {
+	m_passes.clear();
+	m_targets.clear();
+	m_bufferTargets.clear();
+
+	unsigned int declaredBytes = 0;
+
+	for (std::map<std::string, Buffer>::iterator iter = m_buffers.begin(); iter != m_buffers.end(); ++iter) {
+		Buffer& buffer = iter->second;
+
+		unsigned int width = (unsigned int)(windowWidth * buffer.m_widthRatio);
+		unsigned int height = (unsigned int)(windowHeight * buffer.m_heightRatio);
+
+		buffer.m_width = width > 0 ? width : 1;
+		buffer.m_height = height > 0 ? height : 1;
+		buffer.m_firstPass = -1;
+		buffer.m_lastPass = -1;
+		buffer.m_target = -1;
+
+		declaredBytes += buffer.m_width * buffer.m_height * FrameBufferTexture::GetBytesPerPixel(buffer.m_format);
+	}
+
+	unsigned int numErrors = m_numErrors;
+
+	for (unsigned int i = 0; i < m_declaredPasses.size(); ++i)
+		numErrors += ValidatePass(m_declaredPasses[i]);
+
+	std::vector<bool> needed;
+
+	if (numErrors > 0 || !CullPasses(needed)) {
+		printf("RenderGraph::Compile: The effect has errors, no passes will run.\n");
+		return false;
+	}
+
+	for (unsigned int i = 0; i < m_declaredPasses.size(); ++i) {
+		if (needed[i])
+			m_passes.push_back(m_declaredPasses[i]);
+		else
+			printf("RenderGraph::Compile: Culled pass %s, nothing on screen uses what it draws.\n", m_declaredPasses[i].m_name.c_str());
+	}
+
+	AssignTargets();
+
+	unsigned int targetBytes = 0;
+
+	for (unsigned int i = 0; i < m_targets.size(); ++i)
+		targetBytes += m_targets[i].m_width * m_targets[i].m_height * FrameBufferTexture::GetBytesPerPixel(m_targets[i].m_format);
+
+	printf("RenderGraph::Compile: %u of %u passes, %u of %u buffers in %u render targets, %.2f MB instead of %.2f MB.\n",
+		(unsigned int)m_passes.size(), (unsigned int)m_declaredPasses.size(), (unsigned int)m_bufferTargets.size(), (unsigned int)m_buffers.size(), (unsigned int)m_targets.size(),
+		targetBytes / (1024.0f * 1024.0f), declaredBytes / (1024.0f * 1024.0f));
+
+	return true;
+}
+
+const RenderGraph::Buffer* RenderGraph::FindBuffer (const std::string& name) const {
+	std::map<std::string, Buffer>::const_iterator iter = m_buffers.find(name);
+
+	if (iter == m_buffers.end())
+		return NULL;
+	else
+		return &iter->second;
+}
+
+unsigned int RenderGraph::ValidatePass (const RenderPass& pass) const {
+	const char* name = pass.m_name.c_str();
+	unsigned int numErrors = 0;
+
+	if (pass.m_shaderType == e_ShaderTypeCount) {
+		printf("RenderGraph::Compile: Pass %s has no valid shader.\n", name);
+		++numErrors;
+	}
+
+	if (pass.m_geometryType == e_GeometryTypeCount) {
+		printf("RenderGraph::Compile: Pass %s has no valid geometry.\n", name);
+		++numErrors;
+	}
+
+	const Buffer* color = NULL;
+
+	if (pass.m_colorAttach0 != c_screen_buffer) {
+		color = FindBuffer(pass.m_colorAttach0);
+
+		if (color == NULL) {
+			printf("RenderGraph::Compile: Pass %s has colorAttach0 %s, which is not a buffer.\n", name, pass.m_colorAttach0.c_str());
+			++numErrors;
+		}
+		else if (FrameBufferTexture::IsDepthFormat(color->m_format)) {
+			printf("RenderGraph::Compile: Pass %s has depth buffer %s as colorAttach0.\n", name, pass.m_colorAttach0.c_str());
+			++numErrors;
+		}
+	}
+
+	if (!pass.m_depthAttach.empty()) {
+		const Buffer* depth = FindBuffer(pass.m_depthAttach);
+
+		if (pass.m_colorAttach0 == c_screen_buffer) {
+			printf("RenderGraph::Compile: Pass %s draws to the screen, which takes no depthAttach.\n", name);
+			++numErrors;
+		}
+		else if (depth == NULL) {
+			printf("RenderGraph::Compile: Pass %s has depthAttach %s, which is not a buffer.\n", name, pass.m_depthAttach.c_str());
+			++numErrors;
+		}
+		else if (!FrameBufferTexture::IsDepthFormat(depth->m_format)) {
+			printf("RenderGraph::Compile: Pass %s has color buffer %s as depthAttach.\n", name, pass.m_depthAttach.c_str());
+			++numErrors;
+		}
+		else if (color != NULL && (depth->m_width != color->m_width || depth->m_height != color->m_height)) {
+			printf("RenderGraph::Compile: Pass %s has attachments of different sizes.\n", name);
+			++numErrors;
+		}
+	}
+
+	const std::string* sources[2] = { &pass.m_source0, &pass.m_source1 };
+
+	for (unsigned int i = 0; i < 2; ++i) {
+		const std::string& source = *sources[i];
+
+		if (source.empty())
+			continue;
+
+		if (FindBuffer(source) == NULL) {
+			printf("RenderGraph::Compile: Pass %s has source%u %s, which is not a buffer.\n", name, i, source.c_str());
+			++numErrors;
+		}
+		else if (source == pass.m_colorAttach0 || source == pass.m_depthAttach) {
+			printf("RenderGraph::Compile: Pass %s reads %s while it draws to it.\n", name, source.c_str());
+			++numErrors;
+		}
+	}
+
+	return numErrors;
+}
+
+bool RenderGraph::CullPasses (std::vector<bool>& needed) const {
+	needed.assign(m_declaredPasses.size(), false);
+
+	// Buffers the passes after the current one read before anything
+	// overwrites them
+	std::set<std::string> reads;
+
+	for (unsigned int i = m_declaredPasses.size(); i-- > 0; ) {
+		const RenderPass& pass = m_declaredPasses[i];
+
+		if (pass.m_colorAttach0 == c_screen_buffer)
+			needed[i] = true;
+		else
+			needed[i] = reads.count(pass.m_colorAttach0) > 0 || reads.count(pass.m_depthAttach) > 0;
+
+		if (!needed[i])
+			continue;
+
+		// A screen quad without blending or a depth test covers every pixel,
+		// anything else draws over what the attachment already holds
+		bool overwritesColor = HasFlag(pass, "clearColor") ||
+			(pass.m_geometryType == e_GeometryTypeScreenQuad && pass.m_depthAttach.empty() && !HasFlag(pass, "blend"));
+		bool overwritesDepth = HasFlag(pass, "clearDepth");
+
+		if (pass.m_colorAttach0 != c_screen_buffer) {
+			if (overwritesColor)
+				reads.erase(pass.m_colorAttach0);
+			else
+				reads.insert(pass.m_colorAttach0);
+		}
+
+		if (!pass.m_depthAttach.empty()) {
+			if (overwritesDepth)
+				reads.erase(pass.m_depthAttach);
+			else
+				reads.insert(pass.m_depthAttach);
+		}
+
+		if (!pass.m_source0.empty())
+			reads.insert(pass.m_source0);
+
+		if (!pass.m_source1.empty())
+			reads.insert(pass.m_source1);
+	}
+
+	for (std::set<std::string>::iterator iter = reads.begin(); iter != reads.end(); ++iter)
+		printf("RenderGraph::Compile: Buffer %s is read before any pass draws all of it.\n", iter->c_str());
+
+	return reads.empty();
+}
+
+void RenderGraph::AssignTargets () {
+	for (unsigned int i = 0; i < m_passes.size(); ++i) {
+		const RenderPass& pass = m_passes[i];
+		const std::string* names[4] = { &pass.m_colorAttach0, &pass.m_depthAttach, &pass.m_source0, &pass.m_source1 };
+
+		for (unsigned int j = 0; j < 4; ++j) {
+			std::map<std::string, Buffer>::iterator iter = m_buffers.find(*names[j]);
+
+			if (iter == m_buffers.end())
+				continue;
+
+			if (iter->second.m_firstPass < 0)
+				iter->second.m_firstPass = i;
+
+			iter->second.m_lastPass = i;
+		}
+	}
+
+	// Last pass that uses each target so far
+	std::vector<int> targetLastPass;
+
+	// Buffers in the order they are first drawn to take the first target of
+	// their format and size that no buffer uses from that pass on.  A pass's
+	// own buffers are still in use, so it never reads and draws one target.
+	for (unsigned int i = 0; i < m_passes.size(); ++i) {
+		const RenderPass& pass = m_passes[i];
+		const std::string* names[2] = { &pass.m_colorAttach0, &pass.m_depthAttach };
+
+		for (unsigned int j = 0; j < 2; ++j) {
+			std::map<std::string, Buffer>::iterator iter = m_buffers.find(*names[j]);
+
+			if (iter == m_buffers.end() || iter->second.m_target >= 0)
+				continue;
+
+			Buffer& buffer = iter->second;
+
+			for (unsigned int target = 0; target < m_targets.size() && buffer.m_target < 0; ++target) {
+				if (targetLastPass[target] < (int)i && m_targets[target].m_format == buffer.m_format &&
+					m_targets[target].m_width == buffer.m_width && m_targets[target].m_height == buffer.m_height)
+					buffer.m_target = target;
+			}
+
+			if (buffer.m_target < 0) {
+				RenderTarget target;
+				target.m_format = buffer.m_format;
+				target.m_width = buffer.m_width;
+				target.m_height = buffer.m_height;
+
+				buffer.m_target = m_targets.size();
+				m_targets.push_back(target);
+				targetLastPass.push_back(-1);
+			}
+
+			targetLastPass[buffer.m_target] = buffer.m_lastPass;
+			m_bufferTargets[iter->first] = buffer.m_target;
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef __RENDERGRAPH_H__
+#define __RENDERGRAPH_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "RenderPass.h"
+
+// Texture that one or more buffers of an effect are drawn into
+struct RenderTarget
+{
+	std::string m_format;
+	unsigned int m_width;
+	unsigned int m_height;
+};
+
+// The buffers and passes of an effect file compiled into the passes the
+// screen depends on and the render targets they need.  A buffer only holds
+// memory from the pass that first writes it to the pass that last uses it,
+// so buffers of the same format and size whose lifetimes don't overlap share
+// a target and buffers no remaining pass uses get none.
+class RenderGraph
+{
+public:
+	RenderGraph ();
+
+	// In file order, passes run in the order they are added
+	void AddBuffer (const std::string& name, const std::string& format, float widthRatio, float heightRatio);
+	void AddPass (const RenderPass& pass);
+
+	// Validates every buffer and pass, drops the passes whose output never
+	// reaches the screen and assigns the buffers to targets.  Every error is
+	// printed and false is returned if there was any.
+	bool Compile (unsigned int windowWidth, unsigned int windowHeight);
+
+	// Valid after Compile
+	const std::vector<RenderPass>& GetPasses () const { return m_passes; }
+	const std::vector<RenderTarget>& GetTargets () const { return m_targets; }
+
+	// Index into GetTargets of each buffer a pass uses
+	const std::map<std::string, int>& GetBufferTargets () const { return m_bufferTargets; }
+
+private:
+	struct Buffer
+	{
+		std::string m_format;
+		float m_widthRatio;
+		float m_heightRatio;
+
+		// Set by Compile, passes are indexes into m_passes and -1 is none
+		unsigned int m_width;
+		unsigned int m_height;
+		int m_firstPass;
+		int m_lastPass;
+		int m_target;
+	};
+
+	const Buffer* FindBuffer (const std::string& name) const;
+
+	// Prints the pass's errors and returns how many there were
+	unsigned int ValidatePass (const RenderPass& pass) const;
+
+	// Whether each pass is needed, walking back from the passes that draw
+	// to the screen.  False when a needed pass reads a buffer no pass
+	// before it writes.
+	bool CullPasses (std::vector<bool>& needed) const;
+
+	void AssignTargets ();
+
+	std::map<std::string, Buffer> m_buffers;
+	std::vector<RenderPass> m_declaredPasses;
+
+	// Errors found while adding buffers
+	unsigned int m_numErrors;
+
+	std::vector<RenderPass> m_passes;
+	std::vector<RenderTarget> m_targets;
+	std::map<std::string, int> m_bufferTargets;
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include "Angel.h"
 
 #include "GraphicsSettings.h"
+#include "AssetID.h"
 
 struct RenderParameters
 {
@@ -16,7 +17,7 @@ struct RenderParameters
 	vec3 m_lightAmbient;
 	vec3 m_lightDiffuse;
 	vec3 m_lightSpecular;
-	std::string m_environmentMap;
+	AssetID m_environmentMap;
 	mat4 m_colorCorrection;
 
 	// Point Light Parameters
@@ -2,11 +2,24 @@
 #define __RENDERPASS_H__
 
 #include <string>
+#include <vector>
 
-enum ShaderType { e_ShaderTypeForward, e_ShaderTypePostProcess };
+#include "Angel.h"
+
+#include "GraphicsSettings.h"
+
+enum ShaderType { e_ShaderTypeForward, e_ShaderTypePostProcess, e_ShaderTypeCount };
 
 struct RenderPass
 {
+	// A pass that names no shader or geometry, or one that doesn't exist,
+	// keeps the counts so RenderGraph can reject it
+	RenderPass ()
+		: m_shaderType(e_ShaderTypeCount), m_geometryType(e_GeometryTypeCount), m_clearFlags(0), m_blend(false), m_alphaTest(false)
+	{}
+
+	std::string m_name;
+
 	ShaderType m_shaderType;
 	GeometryType m_geometryType;
 
@@ -17,6 +30,12 @@ struct RenderPass
 	std::string m_source1;
 
 	std::vector<std::string> m_flags; 
+
+	// The flags GraphicsManager handles itself, parsed once when the effect
+	// is loaded.  The others go to the pass's shader state.
+	unsigned int m_clearFlags;
+	bool m_blend;
+	bool m_alphaTest;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "RenderQueue.h"
+
+#include <string.h>
+
+static const unsigned int c_type_shift = 62;
+
+static const unsigned int c_depth_bits = 24;
+static const unsigned int c_texture_bits = 12;
+static const unsigned int c_geometry_bits = 13;
+
+static SortKey GetField (unsigned int value, unsigned int bits) {
+	return (SortKey)(value & ((1u << bits) - 1));
+}
+
+// Positive floats order the same as their bit patterns, the top 24 of the 31
+// bits keep the exponent and most of the mantissa
+static SortKey GetDepthField (float depth) {
+	if (!(depth > 0.0f))
+		return 0;
+
+	unsigned int bits;
+	memcpy(&bits, &depth, 4);
+
+	return (SortKey)(bits >> (31 - c_depth_bits));
+}
+
+// cull 1 | diffuse 12 | normal 12 | geometry 13
+static SortKey GetStateField (const DrawState& state) {
+	SortKey key = state.m_twoSided ? 1 : 0;
+
+	key = (key << c_texture_bits) | GetField(state.m_diffuseTexture, c_texture_bits);
+	key = (key << c_texture_bits) | GetField(state.m_normalMap, c_texture_bits);
+	key = (key << c_geometry_bits) | GetField(state.m_geometry, c_geometry_bits);
+
+	return key;
+}
+
+// Bits of the key that hold the type and the draw state
+static SortKey GetStateMask (SortKey sortKey) {
+	SortKey typeMask = (SortKey)3 << c_type_shift;
+
+	switch (sortKey >> c_type_shift) {
+		case e_GeometryTypeOpaque:
+			return ~(((SortKey)1 << c_depth_bits) - 1);
+
+		case e_GeometryTypeTransparent:
+			return typeMask | (((SortKey)1 << (c_type_shift - c_depth_bits)) - 1);
+	}
+
+	// Ordered keys are unique
+	return ~(SortKey)0;
+}
+
+void StateChanges::Count (const DrawState& previous, const DrawState& next) {
+	m_textures += previous.m_diffuseTexture != next.m_diffuseTexture ? 1 : 0;
+	m_textures += previous.m_normalMap != next.m_normalMap ? 1 : 0;
+	m_geometry += previous.m_geometry != next.m_geometry ? 1 : 0;
+	m_cullMode += previous.m_twoSided != next.m_twoSided ? 1 : 0;
+}
+
+void StateChanges::Add (const StateChanges& other) {
+	m_textures += other.m_textures;
+	m_geometry += other.m_geometry;
+	m_cullMode += other.m_cullMode;
+}
+
+void RenderQueue::Add (SortKey sortKey, unsigned int batch) {
+	DrawPacket packet;
+	packet.m_sortKey = sortKey;
+	packet.m_batch = batch;
+
+	m_allocations += m_packets.size() == m_packets.capacity() ? 1 : 0;
+	m_packets.push_back(packet);
+}
+
+void RenderQueue::RemoveBatches (const std::vector<bool>& removed) {
+	unsigned int numKept = 0;
+
+	for (unsigned int i = 0; i < m_packets.size(); ++i) {
+		if (!removed[m_packets[i].m_batch])
+			m_packets[numKept++] = m_packets[i];
+	}
+
+	m_packets.resize(numKept);
+}
+
+void RenderQueue::Sort () {
+	unsigned int numPackets = m_packets.size();
+
+	m_allocations += m_sorted.capacity() < numPackets ? 1 : 0;
+	m_sorted.resize(numPackets);
+
+	for (unsigned int shift = 0; shift < 64; shift += 8) {
+		unsigned int counts[256];
+		memset(counts, 0, sizeof(counts));
+
+		for (unsigned int i = 0; i < numPackets; ++i)
+			++counts[(m_packets[i].m_sortKey >> shift) & 0xff];
+
+		// Every key has the same byte here, this pass wouldn't move anything
+		if (numPackets == 0 || counts[(m_packets[0].m_sortKey >> shift) & 0xff] == numPackets)
+			continue;
+
+		unsigned int offset = 0;
+		for (unsigned int i = 0; i < 256; ++i) {
+			unsigned int count = counts[i];
+			counts[i] = offset;
+			offset += count;
+		}
+
+		for (unsigned int i = 0; i < numPackets; ++i)
+			m_sorted[counts[(m_packets[i].m_sortKey >> shift) & 0xff]++] = m_packets[i];
+
+		m_packets.swap(m_sorted);
+	}
+}
+
+void RenderQueue::GetRange (GeometryType geometryType, unsigned int& first, unsigned int& last) const {
+	SortKey type = (SortKey)geometryType;
+
+	first = 0;
+	while (first < m_packets.size() && (m_packets[first].m_sortKey >> c_type_shift) < type)
+		++first;
+
+	last = first;
+	while (last < m_packets.size() && (m_packets[last].m_sortKey >> c_type_shift) == type)
+		++last;
+}
+
+unsigned int RenderQueue::GetStateRunEnd (unsigned int packet, unsigned int last) const {
+	SortKey sortKey = m_packets[packet].m_sortKey;
+	SortKey stateMask = GetStateMask(sortKey);
+
+	unsigned int end = packet + 1;
+	while (end < last && ((m_packets[end].m_sortKey ^ sortKey) & stateMask) == 0)
+		++end;
+
+	return end;
+}
+
+SortKey RenderQueue::MakeOpaqueKey (const DrawState& state, float depth) {
+	SortKey key = (SortKey)e_GeometryTypeOpaque << c_type_shift;
+
+	return key | (GetStateField(state) << c_depth_bits) | GetDepthField(depth);
+}
+
+SortKey RenderQueue::MakeTransparentKey (const DrawState& state, float depth) {
+	SortKey key = (SortKey)e_GeometryTypeTransparent << c_type_shift;
+	SortKey invertedDepth = ((1u << c_depth_bits) - 1) - GetDepthField(depth);
+
+	return key | (invertedDepth << (c_type_shift - c_depth_bits)) | GetStateField(state);
+}
+
+SortKey RenderQueue::MakeOrderedKey (GeometryType geometryType, unsigned int order) {
+	return ((SortKey)geometryType << c_type_shift) | order;
+}
+
+GeometryType RenderQueue::GetGeometryType (SortKey sortKey) {
+	return (GeometryType)(sortKey >> c_type_shift);
+}
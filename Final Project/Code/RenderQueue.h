@@ -0,0 +1,105 @@
+#ifndef __RENDERQUEUE_H__
+#define __RENDERQUEUE_H__
+
+#include <vector>
+
+#include "Angel.h"
+
+#include "GraphicsSettings.h"
+
+typedef unsigned long long SortKey;
+
+// The state a draw sets that the next draw of the same pass may not need to
+// set again.  Textures are TextureManager keys and geometry is an AssetID
+// index, 0 for none.
+struct DrawState
+{
+	DrawState ()
+		: m_diffuseTexture(0), m_normalMap(0), m_geometry(0), m_twoSided(false)
+	{}
+
+	unsigned int m_diffuseTexture;
+	unsigned int m_normalMap;
+	unsigned int m_geometry;
+	bool m_twoSided;
+};
+
+// State changes between consecutive draws
+struct StateChanges
+{
+	StateChanges ()
+		: m_textures(0), m_geometry(0), m_cullMode(0)
+	{}
+
+	void Count (const DrawState& previous, const DrawState& next);
+	void Add (const StateChanges& other);
+	unsigned int GetTotal () const { return m_textures + m_geometry + m_cullMode; }
+
+	unsigned int m_textures;
+	unsigned int m_geometry;
+	unsigned int m_cullMode;
+};
+
+// A batch reduced to what ordering needs, the batch itself stays where it was
+// submitted
+struct DrawPacket
+{
+	SortKey m_sortKey;
+	unsigned int m_batch;
+};
+
+// Draw packets of every pass, sorted once a frame so each pass's packets are
+// contiguous and ordered by its key.  From the top bit down the keys are:
+//
+//   opaque       type 2 | cull 1 | diffuse 12 | normal 12 | geometry 13 | depth 24
+//   transparent  type 2 | inverted depth 24 | cull 1 | diffuse 12 | normal 12 | geometry 13
+//   HUD          type 2 | submission order 32
+//
+// so opaque batches group by state and go front to back within it, while
+// transparent ones go strictly back to front and the HUD keeps its order.
+class RenderQueue
+{
+public:
+	RenderQueue ()
+		: m_allocations(0)
+	{}
+
+	void Clear () { m_packets.clear(); m_allocations = 0; }
+
+	void Add (SortKey sortKey, unsigned int batch);
+
+	// Drops the packets of the batches flagged in removed, before Sort
+	void RemoveBatches (const std::vector<bool>& removed);
+
+	// LSD radix sort a byte at a time, bytes every key shares are skipped
+	void Sort ();
+
+	// Packets of one geometry type, valid after Sort
+	void GetRange (GeometryType geometryType, unsigned int& first, unsigned int& last) const;
+
+	// End of the run of packets from packet on, up to last, that share their
+	// draw state.  Opaque packets of a run only differ in depth, transparent
+	// ones are still in depth order and the other types never share a run.
+	unsigned int GetStateRunEnd (unsigned int packet, unsigned int last) const;
+
+	const DrawPacket& GetPacket (unsigned int packet) const { return m_packets[packet]; }
+	unsigned int GetNumPackets () const { return m_packets.size(); }
+
+	// Times the packet arrays had to grow since Clear, they keep their
+	// capacity so this drops to 0 once the frames stop getting bigger
+	unsigned int GetAllocations () const { return m_allocations; }
+
+	// depth is the distance along the view axis
+	static SortKey MakeOpaqueKey (const DrawState& state, float depth);
+	static SortKey MakeTransparentKey (const DrawState& state, float depth);
+	static SortKey MakeOrderedKey (GeometryType geometryType, unsigned int order);
+
+	static GeometryType GetGeometryType (SortKey sortKey);
+
+private:
+	std::vector<DrawPacket> m_packets;
+	std::vector<DrawPacket> m_sorted;
+	unsigned int m_allocations;
+};
+
+#endif
@@ -12,19 +12,30 @@ typedef int static_branch;
 
 struct ShaderState
 {
-	virtual void HandleShaderFlags (std::vector<std::string> shaderFlags) = 0;
+	ShaderState ()
+		: b_instanced(false)
+	{}
+
+	virtual void HandleShaderFlags (const std::vector<std::string>& shaderFlags) = 0;
 	virtual void CalculateShaderState (const RenderParameters& renderParameters, const EffectParameters& effectParameters) = 0;
 	virtual void SetAttributeLocation (const AttributeLocation& attributeLocation) { m_attributeLocation = attributeLocation; }
 
 	// Texture flags
 	static_branch b_useDiffuseTexture;
+	static_branch b_useDiffuseArray;
 	static_branch b_useEnvironmentMap;
 	static_branch b_useNormalMap;
 	static_branch b_source0;
 	static_branch b_source1;
 
+	// Layer of the diffuse texture when it comes from a texture array
+	float m_diffuseLayer;
+
 	// Buffer flags
 	AttributeLocation m_attributeLocation;
+
+	// Per instance values come from the shader's instance buffer instead
+	static_branch b_instanced;
 };
 
 #endif
\ No newline at end of file
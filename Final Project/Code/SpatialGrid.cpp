@@ -0,0 +1,162 @@
+#include "SpatialGrid.h"
+
+#include <float.h>
+#include <math.h>
+
+#include "ViewFrustum.h"
+
+// Cells along each axis at most, bounds this size are only reached by worlds
+// far bigger than the cell size suggests
+static const unsigned int c_max_grid_cells = 1024;
+
+SpatialGrid::SpatialGrid (float cellSize)
+	: m_cellSize(cellSize), m_minimumY(FLT_MAX), m_maximumY(-FLT_MAX), m_builtCellSize(cellSize), m_width(0), m_height(0), m_queryStamp(0)
+{
+}
+
+void SpatialGrid::Clear () {
+	m_entries.clear();
+	m_minimumY = FLT_MAX;
+	m_maximumY = -FLT_MAX;
+	m_cellStarts.clear();
+	m_cellEntries.clear();
+	m_width = 0;
+	m_height = 0;
+}
+
+void SpatialGrid::Add (unsigned int item, const vec3& minimum, const vec3& maximum) {
+	Entry entry;
+	entry.m_item = item;
+	entry.m_minimum = vec2(minimum.x, minimum.z);
+	entry.m_maximum = vec2(maximum.x, maximum.z);
+
+	m_minimumY = minimum.y < m_minimumY ? minimum.y : m_minimumY;
+	m_maximumY = maximum.y > m_maximumY ? maximum.y : m_maximumY;
+
+	m_entries.push_back(entry);
+}
+
+bool SpatialGrid::GetCellRange (const vec2& minimum, const vec2& maximum, unsigned int& x0, unsigned int& z0, unsigned int& x1, unsigned int& z1) const {
+	if (m_width == 0 || m_height == 0)
+		return false;
+
+	float cellX0 = floor((minimum.x - m_origin.x) / m_builtCellSize);
+	float cellZ0 = floor((minimum.y - m_origin.y) / m_builtCellSize);
+	float cellX1 = floor((maximum.x - m_origin.x) / m_builtCellSize);
+	float cellZ1 = floor((maximum.y - m_origin.y) / m_builtCellSize);
+
+	if (cellX1 < 0.0f || cellZ1 < 0.0f || cellX0 >= (float)m_width || cellZ0 >= (float)m_height)
+		return false;
+
+	x0 = cellX0 > 0.0f ? (unsigned int)cellX0 : 0;
+	z0 = cellZ0 > 0.0f ? (unsigned int)cellZ0 : 0;
+	x1 = cellX1 < (float)(m_width - 1) ? (unsigned int)cellX1 : m_width - 1;
+	z1 = cellZ1 < (float)(m_height - 1) ? (unsigned int)cellZ1 : m_height - 1;
+
+	return true;
+}
+
+void SpatialGrid::Build () {
+	m_cellStarts.clear();
+	m_cellEntries.clear();
+	m_width = 0;
+	m_height = 0;
+
+	if (m_entries.empty())
+		return;
+
+	vec2 minimum(FLT_MAX, FLT_MAX);
+	vec2 maximum(-FLT_MAX, -FLT_MAX);
+
+	for (unsigned int i = 0; i < m_entries.size(); ++i) {
+		minimum.x = m_entries[i].m_minimum.x < minimum.x ? m_entries[i].m_minimum.x : minimum.x;
+		minimum.y = m_entries[i].m_minimum.y < minimum.y ? m_entries[i].m_minimum.y : minimum.y;
+		maximum.x = m_entries[i].m_maximum.x > maximum.x ? m_entries[i].m_maximum.x : maximum.x;
+		maximum.y = m_entries[i].m_maximum.y > maximum.y ? m_entries[i].m_maximum.y : maximum.y;
+	}
+
+	float extent = maximum.x - minimum.x > maximum.y - minimum.y ? maximum.x - minimum.x : maximum.y - minimum.y;
+
+	m_origin = minimum;
+	m_builtCellSize = m_cellSize;
+	if (extent / m_builtCellSize > (float)c_max_grid_cells)
+		m_builtCellSize = extent / (float)c_max_grid_cells;
+
+	m_width = (unsigned int)floor((maximum.x - minimum.x) / m_builtCellSize) + 1;
+	m_height = (unsigned int)floor((maximum.y - minimum.y) / m_builtCellSize) + 1;
+
+	// Counting sort, the cells' counts first and then their entries
+	m_cellStarts.assign(m_width * m_height + 1, 0);
+
+	for (int pass = 0; pass < 2; ++pass) {
+		for (unsigned int i = 0; i < m_entries.size(); ++i) {
+			unsigned int x0, z0, x1, z1;
+			GetCellRange(m_entries[i].m_minimum, m_entries[i].m_maximum, x0, z0, x1, z1);
+
+			for (unsigned int z = z0; z <= z1; ++z) {
+				for (unsigned int x = x0; x <= x1; ++x) {
+					if (pass == 0)
+						++m_cellStarts[z * m_width + x + 1];
+					else
+						m_cellEntries[m_cellStarts[z * m_width + x]++] = i;
+				}
+			}
+		}
+
+		if (pass == 0) {
+			for (unsigned int cell = 0; cell < m_width * m_height; ++cell)
+				m_cellStarts[cell + 1] += m_cellStarts[cell];
+
+			m_cellEntries.resize(m_cellStarts.back());
+		}
+	}
+
+	// Filling moved every start up to the next cell's
+	for (unsigned int cell = m_width * m_height; cell > 0; --cell)
+		m_cellStarts[cell] = m_cellStarts[cell - 1];
+	m_cellStarts[0] = 0;
+
+	m_queryStamps.assign(m_entries.size(), 0);
+	m_queryStamp = 0;
+}
+
+void SpatialGrid::Query (const vec2& minimum, const vec2& maximum, std::vector<unsigned int>& items) const {
+	unsigned int x0, z0, x1, z1;
+
+	if (!GetCellRange(minimum, maximum, x0, z0, x1, z1))
+		return;
+
+	// Wrapping around would make old stamps look current
+	if (++m_queryStamp == 0) {
+		m_queryStamps.assign(m_entries.size(), 0);
+		m_queryStamp = 1;
+	}
+
+	for (unsigned int z = z0; z <= z1; ++z) {
+		for (unsigned int x = x0; x <= x1; ++x) {
+			unsigned int cell = z * m_width + x;
+
+			for (unsigned int i = m_cellStarts[cell]; i < m_cellStarts[cell + 1]; ++i) {
+				unsigned int entryIndex = m_cellEntries[i];
+				const Entry& entry = m_entries[entryIndex];
+
+				if (m_queryStamps[entryIndex] == m_queryStamp)
+					continue;
+
+				m_queryStamps[entryIndex] = m_queryStamp;
+
+				if (entry.m_minimum.x <= maximum.x && entry.m_maximum.x >= minimum.x &&
+					entry.m_minimum.y <= maximum.y && entry.m_maximum.y >= minimum.y)
+					items.push_back(entry.m_item);
+			}
+		}
+	}
+}
+
+void SpatialGrid::Query (const ViewFrustum& frustum, std::vector<unsigned int>& items) const {
+	vec2 minimum;
+	vec2 maximum;
+
+	if (!m_entries.empty() && frustum.GetGroundBounds(m_minimumY, m_maximumY, minimum, maximum))
+		Query(minimum, maximum, items);
+}
@@ -0,0 +1,73 @@
+#ifndef __SPATIALGRID_H__
+#define __SPATIALGRID_H__
+
+#include <vector>
+
+#include "Angel.h"
+
+struct ViewFrustum;
+
+// Uniform grid over the ground plane for finding what overlaps a region.
+// Items are boxes, named by an index the caller picks, and are stored in
+// every cell their x and z bounds overlap.  The grid covers the bounds of
+// whatever was added, so it works for any world size and insertion order.
+class SpatialGrid
+{
+public:
+	SpatialGrid (float cellSize);
+
+	void Clear ();
+
+	// The item is found by Query after the next Build
+	void Add (unsigned int item, const vec3& minimum, const vec3& maximum);
+
+	// Sorts the items into the cells they overlap
+	void Build ();
+
+	// Appends each item whose bounds overlap the rectangle once, x and z are
+	// in the vec2s' x and y
+	void Query (const vec2& minimum, const vec2& maximum, std::vector<unsigned int>& items) const;
+
+	// Items in the rectangle the frustum covers between the lowest and
+	// highest item, the caller still tests them against the frustum itself
+	void Query (const ViewFrustum& frustum, std::vector<unsigned int>& items) const;
+
+	unsigned int GetNumItems () const { return m_entries.size(); }
+
+private:
+	struct Entry
+	{
+		unsigned int m_item;
+		vec2 m_minimum;
+		vec2 m_maximum;
+	};
+
+	// Cells the rectangle overlaps, false when it misses the grid
+	bool GetCellRange (const vec2& minimum, const vec2& maximum, unsigned int& x0, unsigned int& z0, unsigned int& x1, unsigned int& z1) const;
+
+	float m_cellSize;
+
+	// Heights of the items added since Clear
+	float m_minimumY;
+	float m_maximumY;
+
+	// Set by Build, the cell size grows when the bounds would need too many
+	// cells
+	vec2 m_origin;
+	float m_builtCellSize;
+	unsigned int m_width;
+	unsigned int m_height;
+
+	std::vector<Entry> m_entries;
+
+	// Entries of cell i are m_cellEntries[m_cellStarts[i]] up to the start of
+	// cell i + 1
+	std::vector<unsigned int> m_cellStarts;
+	std::vector<unsigned int> m_cellEntries;
+
+	// Entry stamps so an entry found in several cells is only returned once
+	mutable std::vector<unsigned int> m_queryStamps;
+	mutable unsigned int m_queryStamp;
+};
+
+#endif
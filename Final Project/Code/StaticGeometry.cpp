@@ -0,0 +1,206 @@
+#include "StaticGeometry.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+
+#include <map>
+#include <utility>
+
+#include "Geometry.h"
+#include "GeometryManager.h"
+#include "Timer.h"
+
+namespace {
+
+// A copy of one source geometry's vertexes, read back once per Build
+struct SourceMesh
+{
+	SourceMesh ()
+		: m_read(false), m_valid(false)
+	{}
+
+	bool m_read;
+	bool m_valid;
+	std::vector<Vertex> m_vertexes;
+	std::vector<GLuint> m_indexes;
+	std::vector<GeometryLOD> m_lods;
+};
+
+// A source mesh placed in a chunk, from the chunk's firstVertex on
+typedef std::pair<const SourceMesh*, GLuint> ChunkPart;
+
+// Everything but the transform and animation has to match to share a draw.
+// Layers of one texture array still split, the layer is a draw uniform.
+bool IsSameMaterial (const EffectParameters& first, const EffectParameters& second) {
+	return first.m_twoSided == second.m_twoSided && first.m_HUDRender == second.m_HUDRender &&
+		first.m_diffuseTexture == second.m_diffuseTexture && first.m_normalMap == second.m_normalMap &&
+		first.m_materialAmbient == second.m_materialAmbient && first.m_materialDiffuse == second.m_materialDiffuse &&
+		first.m_materialSpecular == second.m_materialSpecular && first.m_materialSpecularExponent == second.m_materialSpecularExponent &&
+		first.m_materialGloss == second.m_materialGloss && first.m_materialOpacity == second.m_materialOpacity;
+}
+
+// Chunk x, chunk z and material, in the order chunks are baked
+typedef std::pair<std::pair<int, int>, unsigned int> ChunkKey;
+
+}
+
+StaticGeometry::StaticGeometry (float chunkSize)
+	: m_chunkSize(chunkSize), m_chunkGrid(chunkSize)
+{
+}
+
+void StaticGeometry::Add (const RenderBatch& batch) {
+	m_batches.push_back(batch);
+}
+
+void StaticGeometry::Build (GeometryManager& geometryManager) {
+	Timer buildTimer;
+
+	for (unsigned int i = 0; i < m_chunks.size(); ++i) {
+		for (unsigned int j = 0; j < m_chunks[i].m_batches.size(); ++j)
+			geometryManager.ReleaseGeometry(m_chunks[i].m_batches[j].m_geometryID);
+	}
+
+	m_chunks.clear();
+
+	std::vector<EffectParameters> materials;
+	std::map<ChunkKey, std::vector<unsigned int> > chunkBatches;
+
+	for (unsigned int i = 0; i < m_batches.size(); ++i) {
+		const EffectParameters& effectParameters = m_batches[i].m_effectParameters;
+
+		unsigned int material = 0;
+		while (material < materials.size() && !IsSameMaterial(materials[material], effectParameters))
+			++material;
+
+		if (material == materials.size())
+			materials.push_back(effectParameters);
+
+		// The model matrix is row major, its last column is the position
+		const mat4& model = effectParameters.m_modelviewMatrix;
+		int chunkX = (int)floor(model[0][3] / m_chunkSize);
+		int chunkZ = (int)floor(model[2][3] / m_chunkSize);
+
+		chunkBatches[ChunkKey(std::make_pair(chunkX, chunkZ), material)].push_back(i);
+	}
+
+	std::map<AssetID, SourceMesh> sourceMeshes;
+	std::pair<int, int> currentChunk;
+
+	unsigned int numVertex = 0;
+	unsigned int numDraws = 0;
+
+	for (std::map<ChunkKey, std::vector<unsigned int> >::iterator iter = chunkBatches.begin(); iter != chunkBatches.end(); ++iter) {
+		std::vector<Vertex> vertexes;
+		std::vector<ChunkPart> parts;
+		unsigned int numLevels = 0;
+
+		for (unsigned int i = 0; i < iter->second.size(); ++i) {
+			const RenderBatch& batch = m_batches[iter->second[i]];
+
+			SourceMesh& sourceMesh = sourceMeshes[batch.m_geometryID];
+
+			if (!sourceMesh.m_read) {
+				sourceMesh.m_valid = geometryManager.ReadGeometry(batch.m_geometryID, sourceMesh.m_vertexes, sourceMesh.m_indexes, sourceMesh.m_lods);
+				sourceMesh.m_read = true;
+			}
+
+			if (!sourceMesh.m_valid)
+				continue;
+
+			const mat4& model = batch.m_effectParameters.m_modelviewMatrix;
+			GLuint firstVertex = vertexes.size();
+
+			for (unsigned int j = 0; j < sourceMesh.m_vertexes.size(); ++j) {
+				const Vertex& vertex = sourceMesh.m_vertexes[j];
+
+				vec4 position = model * vec4(vertex.position, 1.0f);
+				vec4 normal = model * vec4(vertex.normal, 0.0f);
+
+				vertexes.push_back(Vertex(vec3(position.x, position.y, position.z), normalize(vec3(normal.x, normal.y, normal.z)), vertex.texCoord0));
+			}
+
+			parts.push_back(ChunkPart(&sourceMesh, firstVertex));
+			numLevels = sourceMesh.m_lods.size() > numLevels ? sourceMesh.m_lods.size() : numLevels;
+		}
+
+		if (vertexes.empty())
+			continue;
+
+		// Each chunk level holds every part at that level, or at its coarsest
+		// for parts with fewer levels
+		std::vector<GLuint> indexes;
+		std::vector<GeometryLOD> lods(numLevels);
+
+		for (unsigned int level = 0; level < numLevels; ++level) {
+			lods[level].m_firstIndex = indexes.size();
+
+			for (unsigned int i = 0; i < parts.size(); ++i) {
+				const SourceMesh& sourceMesh = *parts[i].first;
+				const GeometryLOD& sourceLevel = sourceMesh.m_lods[level < sourceMesh.m_lods.size() ? level : sourceMesh.m_lods.size() - 1];
+
+				for (unsigned int j = 0; j < sourceLevel.m_numIndex; ++j)
+					indexes.push_back(parts[i].second + sourceMesh.m_indexes[sourceLevel.m_firstIndex + j]);
+			}
+
+			lods[level].m_numIndex = indexes.size() - lods[level].m_firstIndex;
+		}
+
+		char geometryName[32];
+		sprintf(geometryName, "staticChunk%u", numDraws);
+
+		RenderBatch chunkBatch;
+		chunkBatch.m_geometryID = geometryName;
+		chunkBatch.m_effectParameters = materials[iter->first.second];
+		chunkBatch.m_effectParameters.m_modelviewMatrix = mat4();
+		chunkBatch.m_effectParameters.m_animationTime = 0.0f;
+
+		// Chunks are small enough for the packed format's precision
+		if (!geometryManager.LoadGeometry(chunkBatch.m_geometryID, vertexes, indexes, lods, e_VertexFormatPacked))
+			continue;
+
+		if (m_chunks.empty() || iter->first.first != currentChunk) {
+			m_chunks.push_back(Chunk());
+			m_chunks.back().m_minimum = vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+			m_chunks.back().m_maximum = vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			currentChunk = iter->first.first;
+		}
+
+		Chunk& chunk = m_chunks.back();
+
+		for (unsigned int i = 0; i < vertexes.size(); ++i) {
+			const vec3& position = vertexes[i].position;
+
+			for (int j = 0; j < 3; ++j) {
+				chunk.m_minimum[j] = position[j] < chunk.m_minimum[j] ? position[j] : chunk.m_minimum[j];
+				chunk.m_maximum[j] = position[j] > chunk.m_maximum[j] ? position[j] : chunk.m_maximum[j];
+			}
+		}
+
+		chunk.m_batches.push_back(chunkBatch);
+
+		numVertex += vertexes.size();
+		++numDraws;
+	}
+
+	m_chunkGrid.Clear();
+	for (unsigned int i = 0; i < m_chunks.size(); ++i)
+		m_chunkGrid.Add(i, m_chunks[i].m_minimum, m_chunks[i].m_maximum);
+	m_chunkGrid.Build();
+
+	printf("StaticGeometry::Build: Baked %u batches into %u chunks and %u draws, %u vertexes in %.1f ms.\n", 
+		(unsigned int)m_batches.size(), (unsigned int)m_chunks.size(), numDraws, numVertex, buildTimer.GetElapsedTime() * 1000.0f);
+}
+
+void StaticGeometry::GetVisibleBatches (const ViewFrustum& frustum, std::vector<const RenderBatch*>& batches) const {
+	m_visibleChunks.clear();
+	m_chunkGrid.Query(frustum, m_visibleChunks);
+
+	for (unsigned int i = 0; i < m_visibleChunks.size(); ++i) {
+		const Chunk& chunk = m_chunks[m_visibleChunks[i]];
+
+		for (unsigned int j = 0; j < chunk.m_batches.size(); ++j)
+			batches.push_back(&chunk.m_batches[j]);
+	}
+}
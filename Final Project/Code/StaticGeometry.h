@@ -0,0 +1,56 @@
+#ifndef __STATICGEOMETRY_H__
+#define __STATICGEOMETRY_H__
+
+#include <vector>
+
+#include "Angel.h"
+
+#include "RenderBatch.h"
+#include "SpatialGrid.h"
+
+class GeometryManager;
+struct ViewFrustum;
+
+// Scenery that never moves once it is placed.  Its batches are baked into one
+// geometry per square chunk of the world and material, with the vertexes
+// already in world space, so a chunk in view is drawn once per material and
+// the objects themselves are never looked at again.
+class StaticGeometry
+{
+public:
+	StaticGeometry (float chunkSize);
+
+	// The batch is copied, it is baked by the next Build
+	void Add (const RenderBatch& batch);
+
+	// Bakes every batch added so far, replacing what the last Build baked.
+	// Has to run again whenever geometryManager is recreated.
+	void Build (GeometryManager& geometryManager);
+
+	// Batches of the chunks in the region of the ground the frustum covers,
+	// found through a grid of the chunks' baked bounds
+	void GetVisibleBatches (const ViewFrustum& frustum, std::vector<const RenderBatch*>& batches) const;
+
+	bool IsEmpty () const { return m_batches.empty(); }
+
+private:
+	struct Chunk
+	{
+		// Bounds of the baked vertexes
+		vec3 m_minimum;
+		vec3 m_maximum;
+
+		// One per material, with an identity modelview
+		std::vector<RenderBatch> m_batches;
+	};
+
+	float m_chunkSize;
+
+	std::vector<RenderBatch> m_batches;
+	std::vector<Chunk> m_chunks;
+
+	SpatialGrid m_chunkGrid;
+	mutable std::vector<unsigned int> m_visibleChunks;
+};
+
+#endif
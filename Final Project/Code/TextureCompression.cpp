@@ -0,0 +1,544 @@
+#include "TextureCompression.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <utility>
+
+namespace {
+
+unsigned int MakeFourCC (char a, char b, char c, char d) {
+	return (unsigned int)(unsigned char)a | ((unsigned int)(unsigned char)b << 8) | ((unsigned int)(unsigned char)c << 16) | ((unsigned int)(unsigned char)d << 24);
+}
+
+const unsigned int c_dds_magic = 0x20534444;	// "DDS "
+
+const unsigned int c_ddsd_caps = 0x1;
+const unsigned int c_ddsd_height = 0x2;
+const unsigned int c_ddsd_width = 0x4;
+const unsigned int c_ddsd_pixelformat = 0x1000;
+const unsigned int c_ddsd_mipmapcount = 0x20000;
+const unsigned int c_ddsd_linearsize = 0x80000;
+const unsigned int c_ddpf_fourcc = 0x4;
+const unsigned int c_ddscaps_complex = 0x8;
+const unsigned int c_ddscaps_texture = 0x1000;
+const unsigned int c_ddscaps_mipmap = 0x400000;
+
+struct DDSPixelFormat
+{
+	unsigned int m_size;
+	unsigned int m_flags;
+	unsigned int m_fourCC;
+	unsigned int m_rgbBitCount;
+	unsigned int m_rBitMask;
+	unsigned int m_gBitMask;
+	unsigned int m_bBitMask;
+	unsigned int m_aBitMask;
+};
+
+struct DDSHeader
+{
+	unsigned int m_size;
+	unsigned int m_flags;
+	unsigned int m_height;
+	unsigned int m_width;
+	unsigned int m_pitchOrLinearSize;
+	unsigned int m_depth;
+	unsigned int m_mipMapCount;
+	unsigned int m_reserved1[11];
+	DDSPixelFormat m_pixelFormat;
+	unsigned int m_caps;
+	unsigned int m_caps2;
+	unsigned int m_caps3;
+	unsigned int m_caps4;
+	unsigned int m_reserved2;
+};
+
+// The source stamp lives in the unused m_reserved1 words, tagged so DDS
+// files from other tools are never mistaken for fresh ones
+const unsigned int c_dds_stamp_tag = 0x53524353;	// "SCRS"
+
+unsigned int GetFourCC (TextureCompression compression) {
+	switch (compression) {
+		case e_TextureCompressionBC1: return MakeFourCC('D', 'X', 'T', '1');
+		case e_TextureCompressionBC3: return MakeFourCC('D', 'X', 'T', '5');
+		case e_TextureCompressionBC5: return MakeFourCC('A', 'T', 'I', '2');
+		default: return 0;
+	}
+}
+
+TextureCompression GetCompression (unsigned int fourCC) {
+	if (fourCC == MakeFourCC('D', 'X', 'T', '1'))
+		return e_TextureCompressionBC1;
+	if (fourCC == MakeFourCC('D', 'X', 'T', '5'))
+		return e_TextureCompressionBC3;
+	if (fourCC == MakeFourCC('A', 'T', 'I', '2') || fourCC == MakeFourCC('B', 'C', '5', 'U'))
+		return e_TextureCompressionBC5;
+	return e_TextureCompressionNone;
+}
+
+unsigned int GetBlockSize (TextureCompression compression) {
+	return compression == e_TextureCompressionBC1 ? 8 : 16;
+}
+
+void WriteLittleEndian (unsigned char* output, unsigned int value, unsigned int bytes) {
+	for (unsigned int i = 0; i < bytes; ++i)
+		output[i] = (unsigned char)(value >> (i * 8));
+}
+
+unsigned int PackColor565 (const float* color) {
+	int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+	int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+	int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+
+	r = r < 0 ? 0 : (r > 31 ? 31 : r);
+	g = g < 0 ? 0 : (g > 63 ? 63 : g);
+	b = b < 0 ? 0 : (b > 31 ? 31 : b);
+
+	return (r << 11) | (g << 5) | b;
+}
+
+void UnpackColor565 (unsigned int packed, int* color) {
+	int r = (packed >> 11) & 31;
+	int g = (packed >> 5) & 63;
+	int b = packed & 31;
+
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+// Endpoints from the extent of the block along its principal axis, then
+// every pixel takes the nearest of the four palette colors
+void CompressColorBlock (const unsigned char* pixels, unsigned char* output) {
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+
+	for (int i = 0; i < 16; ++i) {
+		for (int j = 0; j < 3; ++j)
+			mean[j] += pixels[i * 4 + j] / 16.0f;
+	}
+
+	float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+	for (int i = 0; i < 16; ++i) {
+		float r = pixels[i * 4 + 0] - mean[0];
+		float g = pixels[i * 4 + 1] - mean[1];
+		float b = pixels[i * 4 + 2] - mean[2];
+
+		covariance[0] += r * r;
+		covariance[1] += r * g;
+		covariance[2] += r * b;
+		covariance[3] += g * g;
+		covariance[4] += g * b;
+		covariance[5] += b * b;
+	}
+
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+
+	for (int iteration = 0; iteration < 8; ++iteration) {
+		float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+		float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+		float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+
+		float length = sqrtf(x * x + y * y + z * z);
+		if (length < 1e-6f)
+			break;
+
+		axis[0] = x / length;
+		axis[1] = y / length;
+		axis[2] = z / length;
+	}
+
+	float minimum = 1e30f;
+	float maximum = -1e30f;
+
+	for (int i = 0; i < 16; ++i) {
+		float t = (pixels[i * 4 + 0] - mean[0]) * axis[0] + (pixels[i * 4 + 1] - mean[1]) * axis[1] + (pixels[i * 4 + 2] - mean[2]) * axis[2];
+		minimum = t < minimum ? t : minimum;
+		maximum = t > maximum ? t : maximum;
+	}
+
+	float endpoint0[3];
+	float endpoint1[3];
+
+	for (int j = 0; j < 3; ++j) {
+		endpoint0[j] = mean[j] + axis[j] * maximum;
+		endpoint1[j] = mean[j] + axis[j] * minimum;
+	}
+
+	unsigned int color0 = PackColor565(endpoint0);
+	unsigned int color1 = PackColor565(endpoint1);
+
+	// color0 > color1 selects the four color mode
+	if (color0 < color1) {
+		unsigned int swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+
+	unsigned int indexes = 0;
+
+	if (color0 != color1) {
+		int palette[4][3];
+		UnpackColor565(color0, palette[0]);
+		UnpackColor565(color1, palette[1]);
+
+		for (int j = 0; j < 3; ++j) {
+			palette[2][j] = (2 * palette[0][j] + palette[1][j]) / 3;
+			palette[3][j] = (palette[0][j] + 2 * palette[1][j]) / 3;
+		}
+
+		for (int i = 0; i < 16; ++i) {
+			int best = 0;
+			int bestDistance = 0x7fffffff;
+
+			for (int k = 0; k < 4; ++k) {
+				int distance = 0;
+				for (int j = 0; j < 3; ++j) {
+					int difference = pixels[i * 4 + j] - palette[k][j];
+					distance += difference * difference;
+				}
+
+				if (distance < bestDistance) {
+					best = k;
+					bestDistance = distance;
+				}
+			}
+
+			indexes |= best << (i * 2);
+		}
+	}
+
+	WriteLittleEndian(output, color0, 2);
+	WriteLittleEndian(output + 2, color1, 2);
+	WriteLittleEndian(output + 4, indexes, 4);
+}
+
+// BC4, eight interpolated values between the block's minimum and maximum
+void CompressChannelBlock (const unsigned char* pixels, int channel, unsigned char* output) {
+	int maximum = 0;
+	int minimum = 255;
+
+	for (int i = 0; i < 16; ++i) {
+		int value = pixels[i * 4 + channel];
+		maximum = value > maximum ? value : maximum;
+		minimum = value < minimum ? value : minimum;
+	}
+
+	output[0] = (unsigned char)maximum;
+	output[1] = (unsigned char)minimum;
+
+	int palette[8];
+	palette[0] = maximum;
+	palette[1] = minimum;
+	for (int k = 2; k < 8; ++k)
+		palette[k] = ((8 - k) * maximum + (k - 1) * minimum) / 7;
+
+	unsigned long long indexes = 0;
+
+	// Equal endpoints leave every index at 0
+	if (maximum != minimum) {
+		for (int i = 0; i < 16; ++i) {
+			int value = pixels[i * 4 + channel];
+			int best = 0;
+			int bestDistance = 256;
+
+			for (int k = 0; k < 8; ++k) {
+				int distance = value > palette[k] ? value - palette[k] : palette[k] - value;
+
+				if (distance < bestDistance) {
+					best = k;
+					bestDistance = distance;
+				}
+			}
+
+			indexes |= (unsigned long long)best << (i * 3);
+		}
+	}
+
+	for (int i = 0; i < 6; ++i)
+		output[2 + i] = (unsigned char)(indexes >> (i * 8));
+}
+
+}
+
+unsigned int GetCompressedSize (TextureCompression compression, unsigned int width, unsigned int height) {
+	unsigned int blocksWide = (width + 3) / 4;
+	unsigned int blocksHigh = (height + 3) / 4;
+
+	return (blocksWide > 0 ? blocksWide : 1) * (blocksHigh > 0 ? blocksHigh : 1) * GetBlockSize(compression);
+}
+
+void DownsampleImage (const TextureImageRGBA& source, bool normalMap, TextureImageRGBA& destination) {
+	destination.m_width = source.m_width > 1 ? source.m_width / 2 : 1;
+	destination.m_height = source.m_height > 1 ? source.m_height / 2 : 1;
+	destination.m_pixels.resize(destination.m_width * destination.m_height * 4);
+
+	for (unsigned int y = 0; y < destination.m_height; ++y) {
+		unsigned int sourceY[2] = { y * 2, y * 2 + 1 < source.m_height ? y * 2 + 1 : source.m_height - 1 };
+
+		for (unsigned int x = 0; x < destination.m_width; ++x) {
+			unsigned int sourceX[2] = { x * 2, x * 2 + 1 < source.m_width ? x * 2 + 1 : source.m_width - 1 };
+
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (int j = 0; j < 2; ++j) {
+				for (int i = 0; i < 2; ++i) {
+					const unsigned char* pixel = &source.m_pixels[(sourceY[j] * source.m_width + sourceX[i]) * 4];
+
+					for (int c = 0; c < 4; ++c)
+						sum[c] += pixel[c] * 0.25f;
+				}
+			}
+
+			// Averaged normals get shorter, put them back on the unit sphere
+			if (normalMap) {
+				float normal[3];
+				for (int c = 0; c < 3; ++c)
+					normal[c] = sum[c] / 127.5f - 1.0f;
+
+				float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+				if (length > 1e-6f) {
+					for (int c = 0; c < 3; ++c)
+						sum[c] = (normal[c] / length + 1.0f) * 127.5f;
+				}
+			}
+
+			unsigned char* pixel = &destination.m_pixels[(y * destination.m_width + x) * 4];
+
+			for (int c = 0; c < 4; ++c)
+				pixel[c] = (unsigned char)(sum[c] + 0.5f > 255.0f ? 255.0f : sum[c] + 0.5f);
+		}
+	}
+}
+
+// Tent filter weights taking a source axis of sourceSize pixels to size
+// pixels, as wide as a destination pixel when shrinking so every source pixel
+// contributes and a source pixel wide when growing, which is bilinear
+static void GetResampleWeights (unsigned int sourceSize, unsigned int size, std::vector<std::vector<std::pair<unsigned int, float> > >& weights) {
+	float scale = (float)sourceSize / size;
+	float radius = scale > 1.0f ? scale : 1.0f;
+
+	weights.resize(size);
+
+	for (unsigned int i = 0; i < size; ++i) {
+		float center = (i + 0.5f) * scale - 0.5f;
+		float total = 0.0f;
+
+		weights[i].clear();
+
+		for (int j = (int)ceilf(center - radius); j <= (int)floorf(center + radius); ++j) {
+			float weight = 1.0f - fabsf(j - center) / radius;
+
+			if (weight <= 0.0f)
+				continue;
+
+			unsigned int source = j < 0 ? 0 : (j >= (int)sourceSize ? sourceSize - 1 : j);
+			weights[i].push_back(std::make_pair(source, weight));
+			total += weight;
+		}
+
+		for (unsigned int j = 0; j < weights[i].size(); ++j)
+			weights[i][j].second /= total;
+	}
+}
+
+void ResampleImage (const TextureImageRGBA& source, unsigned int width, unsigned int height, TextureImageRGBA& destination) {
+	std::vector<std::vector<std::pair<unsigned int, float> > > weightsX;
+	std::vector<std::vector<std::pair<unsigned int, float> > > weightsY;
+
+	GetResampleWeights(source.m_width, width, weightsX);
+	GetResampleWeights(source.m_height, height, weightsY);
+
+	// Rows first into floats, then columns
+	std::vector<float> rows(width * source.m_height * 4, 0.0f);
+
+	for (unsigned int y = 0; y < source.m_height; ++y) {
+		for (unsigned int x = 0; x < width; ++x) {
+			float* pixel = &rows[(y * width + x) * 4];
+
+			for (unsigned int i = 0; i < weightsX[x].size(); ++i) {
+				const unsigned char* sourcePixel = &source.m_pixels[(y * source.m_width + weightsX[x][i].first) * 4];
+
+				for (int c = 0; c < 4; ++c)
+					pixel[c] += sourcePixel[c] * weightsX[x][i].second;
+			}
+		}
+	}
+
+	destination.m_width = width;
+	destination.m_height = height;
+	destination.m_pixels.resize(width * height * 4);
+
+	for (unsigned int y = 0; y < height; ++y) {
+		for (unsigned int x = 0; x < width; ++x) {
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (unsigned int i = 0; i < weightsY[y].size(); ++i) {
+				const float* rowPixel = &rows[(weightsY[y][i].first * width + x) * 4];
+
+				for (int c = 0; c < 4; ++c)
+					sum[c] += rowPixel[c] * weightsY[y][i].second;
+			}
+
+			unsigned char* pixel = &destination.m_pixels[(y * width + x) * 4];
+
+			for (int c = 0; c < 4; ++c)
+				pixel[c] = (unsigned char)(sum[c] + 0.5f > 255.0f ? 255.0f : (sum[c] < 0.0f ? 0.0f : sum[c] + 0.5f));
+		}
+	}
+}
+
+void CompressImage (const TextureImageRGBA& image, TextureCompression compression, std::vector<unsigned char>& blocks) {
+	unsigned int blockSize = GetBlockSize(compression);
+	unsigned int blocksWide = (image.m_width + 3) / 4;
+	unsigned int blocksHigh = (image.m_height + 3) / 4;
+
+	blocks.resize(GetCompressedSize(compression, image.m_width, image.m_height));
+
+	unsigned char pixels[16 * 4];
+
+	for (unsigned int blockY = 0; blockY < blocksHigh; ++blockY) {
+		for (unsigned int blockX = 0; blockX < blocksWide; ++blockX) {
+			for (unsigned int y = 0; y < 4; ++y) {
+				unsigned int sourceY = blockY * 4 + y < image.m_height ? blockY * 4 + y : image.m_height - 1;
+
+				for (unsigned int x = 0; x < 4; ++x) {
+					unsigned int sourceX = blockX * 4 + x < image.m_width ? blockX * 4 + x : image.m_width - 1;
+
+					memcpy(&pixels[(y * 4 + x) * 4], &image.m_pixels[(sourceY * image.m_width + sourceX) * 4], 4);
+				}
+			}
+
+			unsigned char* output = &blocks[(blockY * blocksWide + blockX) * blockSize];
+
+			switch (compression) {
+				case e_TextureCompressionBC1:
+					CompressColorBlock(pixels, output);
+				break;
+
+				case e_TextureCompressionBC3:
+					CompressChannelBlock(pixels, 3, output);
+					CompressColorBlock(pixels, output + 8);
+				break;
+
+				case e_TextureCompressionBC5:
+					CompressChannelBlock(pixels, 0, output);
+					CompressChannelBlock(pixels, 1, output + 8);
+				break;
+
+				default:
+				break;
+			}
+		}
+	}
+}
+
+bool WriteDDSFile (const std::string& fileName, TextureCompression compression, unsigned int width, unsigned int height,
+	const std::vector<std::vector<unsigned char> >& mipBlocks, long long sourceSize, long long sourceTime) {
+	if (compression == e_TextureCompressionNone || mipBlocks.empty())
+		return false;
+
+	DDSHeader header;
+	memset(&header, 0, sizeof(header));
+
+	header.m_size = sizeof(DDSHeader);
+	header.m_flags = c_ddsd_caps | c_ddsd_height | c_ddsd_width | c_ddsd_pixelformat | c_ddsd_mipmapcount | c_ddsd_linearsize;
+	header.m_height = height;
+	header.m_width = width;
+	header.m_pitchOrLinearSize = mipBlocks[0].size();
+	header.m_mipMapCount = mipBlocks.size();
+	header.m_reserved1[0] = c_dds_stamp_tag;
+	header.m_reserved1[1] = (unsigned int)(sourceSize & 0xffffffff);
+	header.m_reserved1[2] = (unsigned int)(sourceSize >> 32);
+	header.m_reserved1[3] = (unsigned int)(sourceTime & 0xffffffff);
+	header.m_reserved1[4] = (unsigned int)(sourceTime >> 32);
+	header.m_pixelFormat.m_size = sizeof(DDSPixelFormat);
+	header.m_pixelFormat.m_flags = c_ddpf_fourcc;
+	header.m_pixelFormat.m_fourCC = GetFourCC(compression);
+	header.m_caps = c_ddscaps_texture | (mipBlocks.size() > 1 ? c_ddscaps_complex | c_ddscaps_mipmap : 0);
+
+	FILE* file = fopen(fileName.c_str(), "wb");
+
+	if (file == NULL) {
+		printf("WriteDDSFile: Error writing %s.\n", fileName.c_str());
+		return false;
+	}
+
+	bool written = fwrite(&c_dds_magic, sizeof(c_dds_magic), 1, file) == 1 &&
+				   fwrite(&header, sizeof(header), 1, file) == 1;
+
+	for (unsigned int i = 0; i < mipBlocks.size() && written; ++i)
+		written = fwrite(&mipBlocks[i][0], 1, mipBlocks[i].size(), file) == mipBlocks[i].size();
+
+	fclose(file);
+
+	// Never leave a partial file behind
+	if (!written) {
+		printf("WriteDDSFile: Error writing %s.\n", fileName.c_str());
+		remove(fileName.c_str());
+	}
+
+	return written;
+}
+
+bool ParseDDSFile (const char* data, unsigned int size, DDSImage& image) {
+	if (size < sizeof(unsigned int) + sizeof(DDSHeader))
+		return false;
+
+	unsigned int magic;
+	DDSHeader header;
+
+	memcpy(&magic, data, sizeof(magic));
+	memcpy(&header, data + sizeof(magic), sizeof(header));
+
+	if (magic != c_dds_magic ||
+		header.m_size != sizeof(DDSHeader) ||
+		header.m_pixelFormat.m_size != sizeof(DDSPixelFormat) ||
+		(header.m_pixelFormat.m_flags & c_ddpf_fourcc) == 0 ||
+		header.m_width == 0 ||
+		header.m_height == 0)
+		return false;
+
+	image.m_compression = GetCompression(header.m_pixelFormat.m_fourCC);
+	image.m_width = header.m_width;
+	image.m_height = header.m_height;
+
+	if (image.m_compression == e_TextureCompressionNone)
+		return false;
+
+	if (header.m_reserved1[0] == c_dds_stamp_tag) {
+		image.m_sourceSize = (long long)header.m_reserved1[1] | ((long long)header.m_reserved1[2] << 32);
+		image.m_sourceTime = (long long)header.m_reserved1[3] | ((long long)header.m_reserved1[4] << 32);
+	}
+	else {
+		image.m_sourceSize = -1;
+		image.m_sourceTime = -1;
+	}
+
+	unsigned int numMips = (header.m_flags & c_ddsd_mipmapcount) && header.m_mipMapCount > 0 ? header.m_mipMapCount : 1;
+	unsigned int offset = sizeof(magic) + sizeof(header);
+	unsigned int width = image.m_width;
+	unsigned int height = image.m_height;
+
+	image.m_mipData.clear();
+	image.m_mipSizes.clear();
+
+	for (unsigned int i = 0; i < numMips; ++i) {
+		unsigned int mipSize = GetCompressedSize(image.m_compression, width, height);
+
+		if (offset + mipSize > size)
+			return false;
+
+		image.m_mipData.push_back(data + offset);
+		image.m_mipSizes.push_back(mipSize);
+
+		offset += mipSize;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return true;
+}
@@ -0,0 +1,59 @@
+#ifndef __TEXTURECOMPRESSION_H__
+#define __TEXTURECOMPRESSION_H__
+
+#include <string>
+#include <vector>
+
+// Block compressed textures cooked offline by texcook into DDS files next to
+// their BMP sources.  Nothing in here touches GL so the cooker builds without
+// it; BMPTexture maps the formats onto GL enums when it uploads.
+enum TextureCompression {
+	e_TextureCompressionNone,
+	e_TextureCompressionBC1,	// DXT1, rgb
+	e_TextureCompressionBC3,	// DXT5, rgba
+	e_TextureCompressionBC5		// two channel, tangent space normal maps
+};
+
+// One 8 bit per channel image, rows in the same bottom up order as the BMP it
+// came from, which is also the order GL expects
+struct TextureImageRGBA
+{
+	unsigned int m_width;
+	unsigned int m_height;
+	std::vector<unsigned char> m_pixels;	// RGBA
+};
+
+// A cooked DDS file, the mip pointers point into the file data it was parsed
+// from
+struct DDSImage
+{
+	TextureCompression m_compression;
+	unsigned int m_width;
+	unsigned int m_height;
+
+	std::vector<const char*> m_mipData;
+	std::vector<unsigned int> m_mipSizes;
+
+	// Size and modification time of the source BMP when it was cooked
+	long long m_sourceSize;
+	long long m_sourceTime;
+};
+
+unsigned int GetCompressedSize (TextureCompression compression, unsigned int width, unsigned int height);
+
+// Next mip level with a 2x2 box filter, normal maps are renormalized
+void DownsampleImage (const TextureImageRGBA& source, bool normalMap, TextureImageRGBA& destination);
+
+// Any size to any size, for layers of a texture array that don't match the
+// array's layer size
+void ResampleImage (const TextureImageRGBA& source, unsigned int width, unsigned int height, TextureImageRGBA& destination);
+
+// Compresses every 4x4 block, edge blocks repeat the last row and column
+void CompressImage (const TextureImageRGBA& image, TextureCompression compression, std::vector<unsigned char>& blocks);
+
+// mipBlocks holds the compressed blocks of every level, largest first
+bool WriteDDSFile (const std::string& fileName, TextureCompression compression, unsigned int width, unsigned int height,
+	const std::vector<std::vector<unsigned char> >& mipBlocks, long long sourceSize, long long sourceTime);
+bool ParseDDSFile (const char* data, unsigned int size, DDSImage& image);
+
+#endif
@@ -0,0 +1,200 @@
+// ------------------------
+// Offline texture cooker
+// ------------------------
+//
+// Compresses every image in a texture library into a DDS file next to its
+// BMP, with the full mip chain precomputed: rgb textures as BC1, rgba as BC3
+// and normal maps as two channel BC5.  Layers of a texture array are resampled
+// to the array's layer size first.  TextureManager prefers a DDS whose
+// stamp still matches its BMP and falls back to the BMP otherwise.  Built and
+// run by the textures target in the Makefile.
+//
+//   texcook [-force] TextureLibrary.txt
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "BMPImage.h"
+#include "MappedFile.h"
+#include "TextureCompression.h"
+#include "Timer.h"
+
+static const char* c_compression_names[] = { "none", "BC1", "BC3", "BC5" };
+
+// Rows are kept bottom up
+static bool ReadBMPFile (const std::string& fileName, TextureImageRGBA& image) {
+	MappedFile file;
+
+	if (!file.Open(fileName)) {
+		printf("texcook: Error opening %s.\n", fileName.c_str());
+		return false;
+	}
+
+	BMPImage bmpImage;
+	std::string error;
+
+	if (!ParseBMPFile(file.GetData(), file.GetSize(), bmpImage, error)) {
+		printf("texcook: Unsupported BMP %s, %s.\n", fileName.c_str(), error.c_str());
+		return false;
+	}
+
+	DecodeBMPImage(bmpImage, image);
+	return true;
+}
+
+enum CookResult { e_CookResultCooked, e_CookResultUpToDate, e_CookResultMissing, e_CookResultFailed };
+
+// Layers of a texture array are cooked at the array's layer size, layerWidth
+// and layerHeight are 0 for everything else
+static CookResult CookImage (const std::string& fileName, TextureCompression compression, unsigned int layerWidth, unsigned int layerHeight,
+							 bool force, unsigned int& rawSize, unsigned int& cookedSize) {
+	std::string ddsFile = fileName.substr(0, fileName.rfind('.')) + ".dds";
+
+	long long sourceSize;
+	long long sourceTime;
+
+	// The game skips missing textures too, so they aren't an error here
+	if (!GetFileStamp(fileName, sourceSize, sourceTime)) {
+		printf("texcook: Skipping missing %s.\n", fileName.c_str());
+		return e_CookResultMissing;
+	}
+
+	if (!force) {
+		MappedFile cooked;
+		DDSImage image;
+
+		if (cooked.Open(ddsFile) && ParseDDSFile(cooked.GetData(), cooked.GetSize(), image) &&
+			image.m_compression == compression && image.m_sourceSize == sourceSize && image.m_sourceTime == sourceTime &&
+			(layerWidth == 0 || (image.m_width == layerWidth && image.m_height == layerHeight))) {
+			return e_CookResultUpToDate;
+		}
+	}
+
+	TextureImageRGBA image;
+
+	if (!ReadBMPFile(fileName, image))
+		return e_CookResultFailed;
+
+	if (layerWidth != 0 && (image.m_width != layerWidth || image.m_height != layerHeight)) {
+		TextureImageRGBA layer;
+		ResampleImage(image, layerWidth, layerHeight, layer);
+		image.m_width = layer.m_width;
+		image.m_height = layer.m_height;
+		image.m_pixels.swap(layer.m_pixels);
+	}
+
+	unsigned int width = image.m_width;
+	unsigned int height = image.m_height;
+
+	std::vector<std::vector<unsigned char> > mipBlocks;
+	unsigned int imageRawSize = 0;
+	unsigned int imageCookedSize = 0;
+
+	for (;;) {
+		mipBlocks.push_back(std::vector<unsigned char>());
+		CompressImage(image, compression, mipBlocks.back());
+
+		imageRawSize += image.m_width * image.m_height * 4;
+		imageCookedSize += mipBlocks.back().size();
+
+		if (image.m_width == 1 && image.m_height == 1)
+			break;
+
+		TextureImageRGBA mip;
+		DownsampleImage(image, compression == e_TextureCompressionBC5, mip);
+		image.m_width = mip.m_width;
+		image.m_height = mip.m_height;
+		image.m_pixels.swap(mip.m_pixels);
+	}
+
+	if (!WriteDDSFile(ddsFile, compression, width, height, mipBlocks, sourceSize, sourceTime))
+		return e_CookResultFailed;
+
+	printf("texcook: %s %ux%u %s, %u mips, %u KB -> %u KB.\n", ddsFile.c_str(), width, height, c_compression_names[compression],
+		(unsigned int)mipBlocks.size(), imageRawSize / 1024, imageCookedSize / 1024);
+
+	rawSize += imageRawSize;
+	cookedSize += imageCookedSize;
+	return e_CookResultCooked;
+}
+
+int main (int argc, char** argv) {
+	bool force = false;
+	bool usage = false;
+	const char* libraryFile = NULL;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-force") == 0)
+			force = true;
+		else if (libraryFile == NULL)
+			libraryFile = argv[i];
+		else
+			usage = true;
+	}
+
+	if (libraryFile == NULL || usage) {
+		printf("usage: %s [-force] TextureLibrary.txt\n", argv[0]);
+		return 1;
+	}
+
+	std::ifstream is;
+	is.open(libraryFile, std::ios::binary);
+
+	if (!is.is_open()) {
+		printf("texcook: Error opening %s.\n", libraryFile);
+		return 1;
+	}
+
+	Timer timer;
+
+	unsigned int results[e_CookResultFailed + 1] = { 0, 0, 0, 0 };
+	unsigned int rawSize = 0;
+	unsigned int cookedSize = 0;
+
+	// Same layout TextureManager reads
+	while (is.good()) {
+		std::string textureType;
+		std::string textureFormat;
+		std::string textureName;
+
+		is >> textureType >> textureFormat >> textureName;
+
+		unsigned int numFiles = 0;
+		unsigned int layerWidth = 0;
+		unsigned int layerHeight = 0;
+
+		if (textureType == "2d")
+			numFiles = 1;
+		else if (textureType == "cube")
+			numFiles = 6;
+		else if (textureType == "array")
+			is >> layerWidth >> layerHeight >> numFiles;
+
+		TextureCompression compression = e_TextureCompressionBC1;
+		if (textureFormat == "rgba")
+			compression = e_TextureCompressionBC3;
+		else if (textureFormat == "normal")
+			compression = e_TextureCompressionBC5;
+
+		while (numFiles--) {
+			std::string layerName;
+			std::string textureFile;
+
+			if (textureType == "array")
+				is >> layerName;
+
+			is >> textureFile;
+
+			++results[CookImage(textureFile, compression, layerWidth, layerHeight, force, rawSize, cookedSize)];
+		}
+	}
+
+	printf("texcook: %u cooked (%u KB -> %u KB), %u up to date, %u missing, %u failed in %.1f s.\n", results[e_CookResultCooked], rawSize / 1024, cookedSize / 1024, 
+		results[e_CookResultUpToDate], results[e_CookResultMissing], results[e_CookResultFailed], timer.GetElapsedTime());
+
+	return results[e_CookResultFailed] > 0 ? 1 : 0;
+}
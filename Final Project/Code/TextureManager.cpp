@@ -1,10 +1,47 @@
 #include "TextureManager.h"
 
 #include <fstream>
+#include <vector>
 
 #include "BMPTexture.h"
+#include "AssetLoader.h"
 
-TextureManager::TextureManager (const std::string& assetLibrary) {
+// Frames a texture can go unused before it drops back to its minimum mips
+static const unsigned int c_texture_idle_frames = 300;
+
+// Bytes of mips streamed in per frame, whatever was asked for
+static const unsigned int c_stream_bytes_per_frame = 2 * 1024 * 1024;
+
+// Reads one image of a texture, cube maps get a job per face
+class TextureLoadJob : public AssetLoadJob
+{
+public:
+	TextureLoadJob (AssetID textureID, BMPTexture* texture, unsigned int image)
+		: AssetLoadJob(textureID.GetName() + " " + texture->GetFileName(image)), m_texture(texture), m_image(image)
+	{}
+
+	virtual bool Load () {
+		return m_texture->ReadImage(m_image);
+	}
+
+	virtual void Upload () {
+		m_texture->UploadImage(m_image);
+	}
+
+	// The texture counts its failed images too, or it would wait for them
+	// forever
+	virtual void LoadFailed () {
+		m_texture->UploadImage(m_image);
+	}
+
+private:
+	BMPTexture* m_texture;
+	unsigned int m_image;
+};
+
+TextureManager::TextureManager (const std::string& assetLibrary, AssetLoader& assetLoader, unsigned int memoryBudget)
+	: m_memoryBudget(memoryBudget), m_reportedBudget(false), m_frame(1)
+{
 	std::ifstream is;
 	is.open (assetLibrary.c_str(), std::ios::binary);
 
@@ -25,8 +62,12 @@ TextureManager::TextureManager (const std::string& assetLibrary) {
 			else if (textureFormatString == "rgba") {
 				textureFormat = e_TextureFormatRGBA;
 			}
+			else if (textureFormatString == "normal") {
+				// Loads like rgb, texcook is what compresses it to two channels
+				textureFormat = e_TextureFormatRGB;
+			}
 
-			std::vector<const std::string> textureFiles;
+			std::vector<std::string> textureFiles;
 
 			if (textureType == "2d") {
 				std::string textureName;
@@ -37,7 +78,7 @@ TextureManager::TextureManager (const std::string& assetLibrary) {
 
 				textureFiles.push_back(textureFile);
 
-				LoadTextureFile(textureName, textureFormat, e_TextureType2d, e_TextureModeTriLinear, textureFiles);      
+				LoadTextureFile(assetLoader, textureName, textureFormat, e_TextureType2d, e_TextureModeTriLinear, textureFiles);      
 			}
 			else if (textureType == "cube") {
 				std::string textureName;
@@ -49,7 +90,43 @@ TextureManager::TextureManager (const std::string& assetLibrary) {
 					textureFiles.push_back(textureFile);
 				}
 
-				LoadTextureFile(textureName, textureFormat, e_TextureTypeCube, e_TextureModeBiLinear, textureFiles);      
+				LoadTextureFile(assetLoader, textureName, textureFormat, e_TextureTypeCube, e_TextureModeBiLinear, textureFiles);      
+			}
+			else if (textureType == "array") {
+				// Every layer is named so batches can keep asking for their
+				// own texture and get the shared array and a layer in it
+				std::string textureName;
+				unsigned int layerWidth = 0;
+				unsigned int layerHeight = 0;
+				unsigned int numLayers = 0;
+
+				is >> textureName >> layerWidth >> layerHeight >> numLayers;
+
+				std::vector<std::string> layerNames;
+
+				for (unsigned int i = 0; i < numLayers; ++i) {
+					std::string layerName;
+					std::string textureFile;
+
+					is >> layerName >> textureFile;
+
+					layerNames.push_back(layerName);
+					textureFiles.push_back(textureFile);
+				}
+
+				if (layerWidth == 0 || layerHeight == 0 || numLayers == 0) {
+					printf("TextureManager::TextureManager: Texture array %s needs a layer size and at least one layer.\n", textureName.c_str());
+					continue;
+				}
+
+				BMPTexture* texture = LoadTextureFile(assetLoader, textureName, textureFormat, e_TextureType2dArray, e_TextureModeTriLinear, textureFiles, layerWidth, layerHeight);
+
+				for (unsigned int i = 0; texture != NULL && i < numLayers; ++i) {
+					if (GetTexture(layerNames[i]) != NULL)
+						printf("TextureManager::TextureManager: Layer %s of %s is already a texture.\n", layerNames[i].c_str(), textureName.c_str());
+					else
+						AddTexture(layerNames[i], texture, i, GetTextureKey(textureName));
+				}
 			}
 		}
 
@@ -58,34 +135,155 @@ TextureManager::TextureManager (const std::string& assetLibrary) {
 }
 
 TextureManager::~TextureManager () {
-	for (std::map<std::string, BMPTexture*>::iterator iter = m_textures.begin(); iter != m_textures.end(); ++iter)
-		delete iter->second;
+	for (unsigned int i = 0; i < m_loadedTextures.size(); ++i)
+		delete m_loadedTextures[i];
 }
 
-bool TextureManager::SetTexture (TextureChannel channel, const std::string& textureName) const {
-	std::map<std::string, BMPTexture*>::const_iterator iter = m_textures.find(textureName);
+bool TextureManager::SetTexture (TextureChannel channel, AssetID textureID, unsigned int screenPixels) {
+	BMPTexture* texture = GetTexture(textureID);
 
-	if (iter == m_textures.end()) 
+	if (texture == NULL) 
 		return false;
 
-	iter->second->Apply(channel);
+	texture->MarkUsed(m_frame, screenPixels);
+	texture->Apply(channel);
 	return true;
 }
 
-bool TextureManager::IsTransparent (const std::string& textureName) const {
-	std::map<std::string, BMPTexture*>::const_iterator iter = m_textures.find(textureName);
+void TextureManager::UpdateResidency () {
+	// Members so their capacity carries over from frame to frame
+	std::vector<BMPTexture*>& streamed = m_streamed;
+	std::vector<unsigned int>& wantedMips = m_wantedMips;
+
+	streamed.clear();
+	wantedMips.clear();
 
-	if (iter == m_textures.end()) 
+	unsigned int pinnedSize = 0;
+	unsigned int wantedSize = 0;
+
+	for (unsigned int i = 0; i < m_loadedTextures.size(); ++i) {
+		BMPTexture* texture = m_loadedTextures[i];
+
+		if (!texture->IsStreamable()) {
+			pinnedSize += texture->GetMemorySize();
+			continue;
+		}
+
+		bool idle = texture->GetLastUseFrame() == 0 || m_frame - texture->GetLastUseFrame() > c_texture_idle_frames;
+		unsigned int wantedMip = idle ? texture->GetMinimumMip() : texture->GetRequestedMip();
+
+		streamed.push_back(texture);
+		wantedMips.push_back(wantedMip);
+		wantedSize += texture->GetMemorySize(wantedMip);
+	}
+
+	if (m_memoryBudget > 0 && pinnedSize > m_memoryBudget && !m_reportedBudget) {
+		printf("TextureManager::UpdateResidency: %u KB of textures can't be streamed, over the %u KB budget on their own.\n", pinnedSize / 1024, m_memoryBudget / 1024);
+		m_reportedBudget = true;
+	}
+
+	// Over budget the least recently used textures give up a mip at a time,
+	// the largest first when they were last used together
+	while (m_memoryBudget > 0 && pinnedSize + wantedSize > m_memoryBudget) {
+		int coldest = -1;
+
+		for (unsigned int i = 0; i < streamed.size(); ++i) {
+			if (wantedMips[i] >= streamed[i]->GetMinimumMip())
+				continue;
+
+			if (coldest < 0 || streamed[i]->GetLastUseFrame() < streamed[coldest]->GetLastUseFrame() ||
+				(streamed[i]->GetLastUseFrame() == streamed[coldest]->GetLastUseFrame() &&
+				 streamed[i]->GetMemorySize(wantedMips[i]) > streamed[coldest]->GetMemorySize(wantedMips[coldest]))) {
+				coldest = i;
+			}
+		}
+
+		if (coldest < 0)
+			break;
+
+		wantedSize -= streamed[coldest]->GetMemorySize(wantedMips[coldest]);
+		++wantedMips[coldest];
+		wantedSize += streamed[coldest]->GetMemorySize(wantedMips[coldest]);
+	}
+
+	// Evicting frees memory straight away so it goes first
+	for (unsigned int i = 0; i < streamed.size(); ++i) {
+		if (wantedMips[i] > streamed[i]->GetResidentMip())
+			streamed[i]->SetResidentMip(wantedMips[i]);
+	}
+
+	// Streaming in goes one mip per texture per frame and stops at the byte
+	// limit, so a burst of requests is spread over several frames.  The
+	// starting texture rotates so none of them waits behind the others.
+	unsigned int streamedBytes = 0;
+
+	for (unsigned int n = 0; n < streamed.size() && streamedBytes < c_stream_bytes_per_frame; ++n) {
+		unsigned int i = (m_frame + n) % streamed.size();
+
+		if (wantedMips[i] >= streamed[i]->GetResidentMip())
+			continue;
+
+		unsigned int mip = streamed[i]->GetResidentMip() - 1;
+
+		streamedBytes += streamed[i]->GetMemorySize(mip);
+		streamed[i]->SetResidentMip(mip);
+	}
+
+	++m_frame;
+}
+
+bool TextureManager::IsTransparent (AssetID textureID) const {
+	BMPTexture* texture = GetTexture(textureID);
+
+	if (texture == NULL) 
 		return false;
 
-	return iter->second->GetFormat() == e_TextureFormatRGBA;
+	return texture->GetFormat() == e_TextureFormatRGBA;
+}
+
+int TextureManager::GetTextureLayer (AssetID textureID) const {
+	if (textureID.GetIndex() >= m_textures.size())
+		return -1;
+
+	return m_textures[textureID.GetIndex()].m_layer;
+}
+
+unsigned int TextureManager::GetTextureKey (AssetID textureID) const {
+	if (textureID.GetIndex() >= m_textures.size())
+		return 0;
+
+	return m_textures[textureID.GetIndex()].m_key;
 }
 
-void TextureManager::LoadTextureFile (const std::string& textureName, TextureFormat textureFormat, TextureType type, TextureMode mode, const std::vector<const std::string>& textureFiles) {
-	std::map<std::string, BMPTexture*>::iterator iter = m_textures.find(textureName);
+BMPTexture* TextureManager::GetTexture (AssetID textureID) const {
+	if (textureID.GetIndex() >= m_textures.size())
+		return NULL;
+
+	return m_textures[textureID.GetIndex()].m_texture;
+}
+
+BMPTexture* TextureManager::LoadTextureFile (AssetLoader& assetLoader, AssetID textureID, TextureFormat textureFormat, TextureType type, TextureMode mode, const std::vector<std::string>& textureFiles,
+											 unsigned int layerWidth, unsigned int layerHeight) {
+	if (GetTexture(textureID) != NULL)
+		return NULL;
+
+	BMPTexture* texture = new BMPTexture(type, mode, textureFormat, textureFiles, layerWidth, layerHeight);
+	m_loadedTextures.push_back(texture);
+
+	// The array's own name is its first layer
+	AddTexture(textureID, texture, type == e_TextureType2dArray ? 0 : -1, m_loadedTextures.size());
+
+	for (unsigned int i = 0; i < texture->GetNumImages(); ++i)
+		assetLoader.Load(new TextureLoadJob(textureID, texture, i));
+
+	return texture;
+}
 
-	if (iter != m_textures.end())
-		return;
+void TextureManager::AddTexture (AssetID textureID, BMPTexture* texture, int layer, unsigned int key) {
+	if (textureID.GetIndex() >= m_textures.size())
+		m_textures.resize(textureID.GetIndex() + 1);
 
-	m_textures[textureName] = new BMPTexture(type, mode, textureFormat, textureFiles);
+	m_textures[textureID.GetIndex()].m_texture = texture;
+	m_textures[textureID.GetIndex()].m_layer = layer;
+	m_textures[textureID.GetIndex()].m_key = key;
 }
\ No newline at end of file
@@ -1,27 +1,78 @@
 #ifndef __TEXTUREMANAGER_H__
 #define __TEXTUREMANAGER_H__
 
+#include <limits.h>
+
 #include <string>
 #include <vector>
-#include <map>
 
 #include "Angel.h"
 
+#include "AssetID.h"
 #include "BMPTexture.h"
 
+class AssetLoader;
+
 class TextureManager
 {
 public:
-	TextureManager (const std::string& assetLibrary);
+	// Textures are queued on assetLoader and stay empty until it has finished.
+	// Streamed textures are kept within memoryBudget bytes where they can be,
+	// 0 is no limit.
+	TextureManager (const std::string& assetLibrary, AssetLoader& assetLoader, unsigned int memoryBudget = 0);
 	~TextureManager ();
 
-	bool SetTexture (TextureChannel channel, const std::string& textureName) const;
-	bool IsTransparent (const std::string& textureName) const;
+	// screenPixels is how much of the screen height the texture is drawn
+	// across, which decides how many of its mips it needs
+	bool SetTexture (TextureChannel channel, AssetID textureID, unsigned int screenPixels = UINT_MAX);
+	bool IsTransparent (AssetID textureID) const;
+
+	// Once a frame after drawing.  Textures that went unused or don't fit the
+	// budget drop mips at once, mips asked for are streamed in a few at a time.
+	void UpdateResidency ();
+
+	// Layer of the texture array textureID names, -1 when it isn't one.  The
+	// array itself is what SetTexture binds.
+	int GetTextureLayer (AssetID textureID) const;
+
+	// Small number for the GL texture textureID binds, the same for every
+	// layer of an array and 0 when there's no such texture.  For sorting.
+	unsigned int GetTextureKey (AssetID textureID) const;
 
 private:
-	void LoadTextureFile (const std::string& textureName, TextureFormat textureFormat, TextureType type, TextureMode mode, const std::vector<const std::string>& textureFiles);
+	// A name resolves to a texture, or to a texture array and a layer in it
+	struct TextureEntry
+	{
+		TextureEntry ()
+			: m_texture(NULL), m_layer(-1), m_key(0)
+		{}
+
+		BMPTexture* m_texture;
+		int m_layer;
+		unsigned int m_key;
+	};
+
+	BMPTexture* LoadTextureFile (AssetLoader& assetLoader, AssetID textureID, TextureFormat textureFormat, TextureType type, TextureMode mode, const std::vector<std::string>& textureFiles,
+		unsigned int layerWidth = 0, unsigned int layerHeight = 0);
+	void AddTexture (AssetID textureID, BMPTexture* texture, int layer, unsigned int key);
+
+	BMPTexture* GetTexture (AssetID textureID) const;
+
+	// Indexed by AssetID, NULL where no texture has that name
+	std::vector<TextureEntry> m_textures;
+
+	// One per library entry, the layers of an array share theirs
+	std::vector<BMPTexture*> m_loadedTextures;
+
+	unsigned int m_memoryBudget;
+	bool m_reportedBudget;
+
+	// Frames start at 1, textures that were never used have a last use of 0
+	unsigned int m_frame;
 
-	std::map<std::string, BMPTexture*> m_textures;
+	// UpdateResidency's streamable textures and the mip each should have
+	std::vector<BMPTexture*> m_streamed;
+	std::vector<unsigned int> m_wantedMips;
 };
 
 #endif
\ No newline at end of file
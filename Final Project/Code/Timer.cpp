@@ -1,6 +1,6 @@
 // Courtesy Alan Gasperini, my roommate
 
-#include "timer.h"
+#include "Timer.h"
 
 #ifdef WIN32
 #pragma comment(lib, "winmm.lib")
@@ -40,14 +40,14 @@ float Timer::GetElapsedTime()
 //***********************************unix specific*********************************
 Timer::Timer()
 {
-	gettimeofday(&cur_time);
+	gettimeofday(&cur_time, NULL);
 }
 
 float Timer::GetElapsedTime()
 {
 	float dif;
 	timeval newtime;
-	gettimeofday(&newtime);
+	gettimeofday(&newtime, NULL);
 	dif=(newtime.tv_sec-cur_time.tv_sec);
 	dif+=(newtime.tv_usec-cur_time.tv_usec)/1000000.0;
 	return dif;
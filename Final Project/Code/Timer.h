@@ -35,6 +35,7 @@ inline void Timer::Reset()
 
 #else
 //*****************************unix stuff****************************
+#include <stddef.h>
 #include <sys/time.h>
 
 class Timer
@@ -52,7 +53,7 @@ private:
 
 inline void Timer::Reset()
 {
-	gettimeofday(&cur_time);
+	gettimeofday(&cur_time, NULL);
 }
 
 
@@ -1,5 +1,7 @@
 #include "UberShader.h"
 
+#include "GLStateCache.h"
+
 UberShader::UberShader (const std::string& vertShader, const std::string& fragShader) {
 	m_program = InitShader(vertShader.c_str(), fragShader.c_str());
     glUseProgram(m_program);
@@ -16,6 +18,13 @@ UberShader::~UberShader () {
 	glDeleteProgram(m_program);		
 }
 
+void UberShader::BindUniformBlock (const char* blockName, GLuint binding) {
+	GLuint blockIndex = glGetUniformBlockIndex(m_program, blockName);
+
+	if (blockIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(m_program, blockIndex, binding);
+}
+
 void UberShader::Apply () {
-	glUseProgram(m_program);
+	GLStateCache::Get().UseProgram(m_program);
 }
\ No newline at end of file
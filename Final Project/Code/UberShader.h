@@ -17,6 +17,10 @@ public:
 	virtual void SetShaderState (const ShaderState* shaderState) = 0;
 
 protected:
+	// Points the program's block at a binding point, blocks the program
+	// doesn't use are skipped
+	void BindUniformBlock (const char* blockName, GLuint binding);
+
 	GLuint m_program;
 };
 
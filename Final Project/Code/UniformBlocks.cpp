@@ -0,0 +1,31 @@
+#include "UniformBlocks.h"
+
+#include "RenderParameters.h"
+
+void CalculateFrameUniforms (const RenderParameters& renderParameters, FrameUniforms& frameUniforms) {
+	frameUniforms.m_projectionMatrix = renderParameters.m_projectionMatrix;
+	frameUniforms.m_colorCorrection = renderParameters.m_colorCorrection;
+
+	frameUniforms.m_eyePosition = vec4(renderParameters.m_eyePosition, 1.0f);
+	frameUniforms.m_windowSize = vec4((float)Settings::Get().s_windowWidth, (float)Settings::Get().s_windowHeight, 0.0f, 0.0f);
+
+	frameUniforms.m_lightDirection = vec4(renderParameters.m_lightDirection, 0.0f);
+	frameUniforms.m_lightAmbient = vec4(renderParameters.m_lightAmbient, 0.0f);
+	frameUniforms.m_lightDiffuse = vec4(renderParameters.m_lightDiffuse, 0.0f);
+	frameUniforms.m_lightSpecular = vec4(renderParameters.m_lightSpecular, 0.0f);
+
+	for (unsigned int i = 0; i < c_num_point_lights; ++i) {
+		bool usePointLight = renderParameters.m_pointLightAmbient[i] != vec3() ||
+							 renderParameters.m_pointLightDiffuse[i] != vec3() ||
+							 renderParameters.m_pointLightSpecular[i] != vec3();
+
+		float falloffRange = renderParameters.m_pointLightRange[i] - renderParameters.m_pointLightFalloff[i];
+		if (falloffRange < c_num_falloff_range)
+			falloffRange = c_num_falloff_range;
+
+		frameUniforms.m_pointLightPosition[i] = vec4(renderParameters.m_pointLightPosition[i], renderParameters.m_pointLightRange[i]);
+		frameUniforms.m_pointLightAmbient[i] = vec4(renderParameters.m_pointLightAmbient[i], 1.0f / falloffRange);
+		frameUniforms.m_pointLightDiffuse[i] = vec4(renderParameters.m_pointLightDiffuse[i], usePointLight ? 1.0f : 0.0f);
+		frameUniforms.m_pointLightSpecular[i] = vec4(renderParameters.m_pointLightSpecular[i], 0.0f);
+	}
+}
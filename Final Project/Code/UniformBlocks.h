@@ -0,0 +1,72 @@
+#ifndef __UNIFORMBLOCKS_H__
+#define __UNIFORMBLOCKS_H__
+
+#include "Angel.h"
+
+#include "GraphicsSettings.h"
+
+struct RenderParameters;
+
+// Binding points of the uniform blocks, the same for every program
+enum UniformBlockBinding {
+	e_UniformBlockFrame = 0,
+	e_UniformBlockDraw = 1
+};
+
+// The structs below mirror the std140 uniform blocks of the shaders.  Every
+// member is a vec4 or mat4, or a run of four scalars, so the C++ layout is
+// the std140 one.  The blocks are declared row_major to match mat4.
+
+// Uploaded when the render parameters change, normally once a frame and
+// once more for the HUD
+struct FrameUniforms
+{
+	mat4 m_projectionMatrix;
+	mat4 m_colorCorrection;
+
+	vec4 m_eyePosition;
+	vec4 m_windowSize;						// width and height in xy
+
+	vec4 m_lightDirection;
+	vec4 m_lightAmbient;
+	vec4 m_lightDiffuse;
+	vec4 m_lightSpecular;
+
+	vec4 m_pointLightPosition[c_num_point_lights];		// range in w
+	vec4 m_pointLightAmbient[c_num_point_lights];		// attenuation multiplier in w
+	vec4 m_pointLightDiffuse[c_num_point_lights];		// 1 in w when the light is on
+	vec4 m_pointLightSpecular[c_num_point_lights];
+};
+
+// Uploaded by every draw, instanced draws take the per instance values from
+// the instance buffer instead
+struct DrawUniforms
+{
+	mat4 m_modelviewMatrix;
+
+	vec4 m_materialAmbient;					// specular exponent in w
+	vec4 m_materialDiffuse;					// gloss in w
+	vec4 m_materialSpecular;				// opacity in w
+
+	// Packed geometry decode
+	vec4 m_positionScale;
+	vec4 m_positionBias;
+	vec4 m_texCoordScaleBias;				// scale in xy, bias in zw
+
+	float m_attributeLerp;
+	float m_diffuseLayer;
+	int b_animatedGeometry;
+	int b_packedGeometry;
+
+	int b_useDiffuseTexture;
+	int b_useDiffuseArray;
+	int b_useEnvironmentMap;
+	int b_useNormalMap;
+
+	int b_instanced;
+	int m_padding[3];
+};
+
+void CalculateFrameUniforms (const RenderParameters& renderParameters, FrameUniforms& frameUniforms);
+
+#endif
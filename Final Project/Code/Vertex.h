@@ -16,4 +16,34 @@ const unsigned int c_positionDataOffset = 0;
 const unsigned int c_normalDataOffset = sizeof(vec3);
 const unsigned int c_texCoord0DataOffset = 2 * sizeof(vec3);
 
+enum VertexFormat { 
+	e_VertexFormatFull,		// Vertex
+	e_VertexFormatPacked	// PackedVertex
+};
+
+// 16-byte quantized data, decoded in forwardVert with the geometry's VertexDecode
+struct PackedVertex
+{
+	short position[4];			// snorm over the geometry bounds, w unused
+	short normal[2];			// snorm octahedral
+	unsigned short texCoord0[2];	// unorm over the geometry's texture coordinate range
+};
+
+const unsigned int c_packedPositionDataOffset = 0;
+const unsigned int c_packedNormalDataOffset = 4 * sizeof(short);
+const unsigned int c_packedTexCoord0DataOffset = 6 * sizeof(short);
+
+// Maps packed attributes back to object space, attribute * scale + bias
+struct VertexDecode
+{
+	VertexDecode ()
+		: m_positionScale(1.0f, 1.0f, 1.0f), m_positionBias(0.0f, 0.0f, 0.0f), m_texCoordScale(1.0f, 1.0f), m_texCoordBias(0.0f, 0.0f)
+	{}
+
+	vec3 m_positionScale;
+	vec3 m_positionBias;
+	vec2 m_texCoordScale;
+	vec2 m_texCoordBias;
+};
+
 #endif
\ No newline at end of file
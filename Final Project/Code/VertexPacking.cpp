@@ -0,0 +1,158 @@
+#include "VertexPacking.h"
+
+#include <cmath>
+
+namespace {
+
+short PackSnorm (float value) {
+	if (value > 1.0f)
+		value = 1.0f;
+	else if (value < -1.0f)
+		value = -1.0f;
+
+	return (short)floor(value * 32767.0f + 0.5f);
+}
+
+unsigned short PackUnorm (float value) {
+	if (value > 1.0f)
+		value = 1.0f;
+	else if (value < 0.0f)
+		value = 0.0f;
+
+	return (unsigned short)floor(value * 65535.0f + 0.5f);
+}
+
+float SignNotZero (float value) {
+	return value < 0.0f ? -1.0f : 1.0f;
+}
+
+// Projects the unit normal onto an octahedron and unfolds the lower half
+void PackOctahedral (const vec3& normal, short* packed) {
+	float length = fabs(normal.x) + fabs(normal.y) + fabs(normal.z);
+
+	if (length == 0.0f) {
+		packed[0] = 0;
+		packed[1] = 0;
+		return;
+	}
+
+	float x = normal.x / length;
+	float y = normal.y / length;
+
+	if (normal.z < 0.0f) {
+		float foldedX = (1.0f - fabs(y)) * SignNotZero(x);
+		float foldedY = (1.0f - fabs(x)) * SignNotZero(y);
+
+		x = foldedX;
+		y = foldedY;
+	}
+
+	packed[0] = PackSnorm(x);
+	packed[1] = PackSnorm(y);
+}
+
+float UnpackSnorm (short value) {
+	float unpacked = value / 32767.0f;
+	return unpacked < -1.0f ? -1.0f : unpacked;
+}
+
+vec3 UnpackOctahedral (const short* packed) {
+	vec3 normal(UnpackSnorm(packed[0]), UnpackSnorm(packed[1]), 0.0f);
+	normal.z = 1.0f - fabs(normal.x) - fabs(normal.y);
+
+	if (normal.z < 0.0f) {
+		float unfoldedX = (1.0f - fabs(normal.y)) * SignNotZero(normal.x);
+		float unfoldedY = (1.0f - fabs(normal.x)) * SignNotZero(normal.y);
+
+		normal.x = unfoldedX;
+		normal.y = unfoldedY;
+	}
+
+	return normalize(normal);
+}
+
+}
+
+void PackVertexes (const std::vector<std::vector<Vertex> >& frames, std::vector<std::vector<PackedVertex> >& packedFrames, VertexDecode& decode) {
+	packedFrames.clear();
+
+	if (frames.empty() || frames[0].empty())
+		return;
+
+	vec3 positionMin = frames[0][0].position;
+	vec3 positionMax = frames[0][0].position;
+	vec2 texCoordMin = frames[0][0].texCoord0;
+	vec2 texCoordMax = frames[0][0].texCoord0;
+
+	for (unsigned int frame = 0; frame < frames.size(); ++frame) {
+		for (unsigned int i = 0; i < frames[frame].size(); ++i) {
+			const Vertex& vertex = frames[frame][i];
+
+			for (int j = 0; j < 3; ++j) {
+				positionMin[j] = vertex.position[j] < positionMin[j] ? vertex.position[j] : positionMin[j];
+				positionMax[j] = vertex.position[j] > positionMax[j] ? vertex.position[j] : positionMax[j];
+			}
+
+			for (int j = 0; j < 2; ++j) {
+				texCoordMin[j] = vertex.texCoord0[j] < texCoordMin[j] ? vertex.texCoord0[j] : texCoordMin[j];
+				texCoordMax[j] = vertex.texCoord0[j] > texCoordMax[j] ? vertex.texCoord0[j] : texCoordMax[j];
+			}
+		}
+	}
+
+	// Flat axes still need a non zero scale to divide by
+	for (int j = 0; j < 3; ++j) {
+		decode.m_positionBias[j] = (positionMin[j] + positionMax[j]) * 0.5f;
+		decode.m_positionScale[j] = (positionMax[j] - positionMin[j]) * 0.5f;
+
+		if (decode.m_positionScale[j] <= 0.0f)
+			decode.m_positionScale[j] = 1.0f;
+	}
+
+	for (int j = 0; j < 2; ++j) {
+		decode.m_texCoordBias[j] = texCoordMin[j];
+		decode.m_texCoordScale[j] = texCoordMax[j] - texCoordMin[j];
+
+		if (decode.m_texCoordScale[j] <= 0.0f)
+			decode.m_texCoordScale[j] = 1.0f;
+	}
+
+	packedFrames.resize(frames.size());
+
+	for (unsigned int frame = 0; frame < frames.size(); ++frame) {
+		std::vector<PackedVertex>& packedFrame = packedFrames[frame];
+		packedFrame.resize(frames[frame].size());
+
+		for (unsigned int i = 0; i < frames[frame].size(); ++i) {
+			const Vertex& vertex = frames[frame][i];
+			PackedVertex& packed = packedFrame[i];
+
+			for (int j = 0; j < 3; ++j)
+				packed.position[j] = PackSnorm((vertex.position[j] - decode.m_positionBias[j]) / decode.m_positionScale[j]);
+			packed.position[3] = 0;
+
+			PackOctahedral(vertex.normal, packed.normal);
+
+			for (int j = 0; j < 2; ++j)
+				packed.texCoord0[j] = PackUnorm((vertex.texCoord0[j] - decode.m_texCoordBias[j]) / decode.m_texCoordScale[j]);
+		}
+	}
+}
+
+void UnpackVertexes (const PackedVertex* packed, unsigned int numVertex, const VertexDecode& decode, std::vector<Vertex>& vertexes) {
+	vertexes.clear();
+	vertexes.reserve(numVertex);
+
+	for (unsigned int i = 0; i < numVertex; ++i) {
+		vec3 position;
+		vec2 texCoord0;
+
+		for (int j = 0; j < 3; ++j)
+			position[j] = UnpackSnorm(packed[i].position[j]) * decode.m_positionScale[j] + decode.m_positionBias[j];
+
+		for (int j = 0; j < 2; ++j)
+			texCoord0[j] = packed[i].texCoord0[j] / 65535.0f * decode.m_texCoordScale[j] + decode.m_texCoordBias[j];
+
+		vertexes.push_back(Vertex(position, UnpackOctahedral(packed[i].normal), texCoord0));
+	}
+}
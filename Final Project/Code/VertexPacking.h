@@ -0,0 +1,17 @@
+#ifndef __VERTEXPACKING_H__
+#define __VERTEXPACKING_H__
+
+#include <vector>
+
+#include "Angel.h"
+
+#include "Vertex.h"
+
+// Quantizes every frame into PackedVertexes.  The bounds used for positions
+// and texture coordinates span all frames so keyframes share one decode.
+void PackVertexes (const std::vector<std::vector<Vertex> >& frames, std::vector<std::vector<PackedVertex> >& packedFrames, VertexDecode& decode);
+
+// Decodes packed vertexes the way forwardVert does
+void UnpackVertexes (const PackedVertex* packed, unsigned int numVertex, const VertexDecode& decode, std::vector<Vertex>& vertexes);
+
+#endif
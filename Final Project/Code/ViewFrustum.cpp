@@ -0,0 +1,110 @@
+#include "ViewFrustum.h"
+
+#include <float.h>
+
+// The point on all three planes
+static vec3 IntersectPlanes (const vec4& first, const vec4& second, const vec4& third) {
+	vec3 n1(first.x, first.y, first.z);
+	vec3 n2(second.x, second.y, second.z);
+	vec3 n3(third.x, third.y, third.z);
+
+	vec3 n2n3 = cross(n2, n3);
+	float denominator = dot(n1, n2n3);
+
+	if (denominator == 0.0f)
+		return vec3(0.0f, 0.0f, 0.0f);
+
+	return -(first.w * n2n3 + second.w * cross(n3, n1) + third.w * cross(n1, n2)) / denominator;
+}
+
+ViewFrustum::ViewFrustum (const mat4& viewProjectionMatrix) {
+	// A point is inside when -w <= x, y, z <= w in clip space, each of those
+	// is a plane in terms of the rows of the matrix
+	const mat4& m = viewProjectionMatrix;
+
+	m_planes[e_FrustumLeft] = m[3] + m[0];
+	m_planes[e_FrustumRight] = m[3] - m[0];
+	m_planes[e_FrustumBottom] = m[3] + m[1];
+	m_planes[e_FrustumTop] = m[3] - m[1];
+	m_planes[e_FrustumNear] = m[3] + m[2];
+	m_planes[e_FrustumFar] = m[3] - m[2];
+
+	for (int i = 0; i < e_FrustumPlaneCount; ++i) {
+		float normalLength = length(vec3(m_planes[i].x, m_planes[i].y, m_planes[i].z));
+
+		if (normalLength > 0.0f)
+			m_planes[i] /= normalLength;
+	}
+}
+
+bool ViewFrustum::IntersectsSphere (const vec3& center, float radius) const {
+	for (int i = 0; i < e_FrustumPlaneCount; ++i) {
+		const vec4& plane = m_planes[i];
+
+		if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius)
+			return false;
+	}
+
+	return true;
+}
+
+bool ViewFrustum::GetGroundBounds (float minimumY, float maximumY, vec2& minimum, vec2& maximum) const {
+	// Corner i is on the right plane when bit 0 is set, the top when bit 1 is
+	// and the far one when bit 2 is
+	vec3 corners[8];
+	for (int i = 0; i < 8; ++i) {
+		corners[i] = IntersectPlanes(m_planes[i & 1 ? e_FrustumRight : e_FrustumLeft],
+			m_planes[i & 2 ? e_FrustumTop : e_FrustumBottom],
+			m_planes[i & 4 ? e_FrustumFar : e_FrustumNear]);
+	}
+
+	minimum = vec2(FLT_MAX, FLT_MAX);
+	maximum = vec2(-FLT_MAX, -FLT_MAX);
+
+	// The frustum cut to the heights is convex, its corners are where its
+	// edges enter and leave the slab between them
+	bool inside = false;
+	for (int i = 0; i < 8; ++i) {
+		for (int axis = 1; axis <= 4; axis <<= 1) {
+			if (i & axis)
+				continue;
+
+			vec3 start = corners[i];
+			vec3 end = corners[i | axis];
+
+			float t0 = 0.0f;
+			float t1 = 1.0f;
+
+			if (start.y == end.y) {
+				if (start.y < minimumY || start.y > maximumY)
+					continue;
+			}
+			else {
+				float tMinimum = (minimumY - start.y) / (end.y - start.y);
+				float tMaximum = (maximumY - start.y) / (end.y - start.y);
+
+				t0 = tMinimum < tMaximum ? tMinimum : tMaximum;
+				t1 = tMinimum < tMaximum ? tMaximum : tMinimum;
+
+				t0 = t0 > 0.0f ? t0 : 0.0f;
+				t1 = t1 < 1.0f ? t1 : 1.0f;
+
+				if (t0 > t1)
+					continue;
+			}
+
+			vec3 points[2] = { start + (end - start) * t0, start + (end - start) * t1 };
+
+			for (int j = 0; j < 2; ++j) {
+				minimum.x = points[j].x < minimum.x ? points[j].x : minimum.x;
+				minimum.y = points[j].z < minimum.y ? points[j].z : minimum.y;
+				maximum.x = points[j].x > maximum.x ? points[j].x : maximum.x;
+				maximum.y = points[j].z > maximum.y ? points[j].z : maximum.y;
+			}
+
+			inside = true;
+		}
+	}
+
+	return inside;
+}
@@ -0,0 +1,28 @@
+#ifndef __VIEWFRUSTUM_H__
+#define __VIEWFRUSTUM_H__
+
+#include "Angel.h"
+
+// The six planes of a view frustum, pointing inwards with unit normals so
+// the plane equation gives the signed distance in world units
+struct ViewFrustum
+{
+	enum { e_FrustumLeft, e_FrustumRight, e_FrustumBottom, e_FrustumTop, e_FrustumNear, e_FrustumFar, e_FrustumPlaneCount };
+
+	ViewFrustum () {}
+
+	// The projection here already holds the camera's LookAt, so the planes
+	// come out in world space
+	ViewFrustum (const mat4& viewProjectionMatrix);
+
+	// False only when the sphere is entirely outside one of the planes
+	bool IntersectsSphere (const vec3& center, float radius) const;
+
+	// x and z bounds of the part of the frustum between the two heights, in
+	// the vec2s' x and y.  False when the frustum doesn't reach between them.
+	bool GetGroundBounds (float minimumY, float maximumY, vec2& minimum, vec2& maximum) const;
+
+	vec4 m_planes[e_FrustumPlaneCount];
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "WorkerPool.h"
+
+#include <stdio.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+WorkerPool::WorkerPool (unsigned int numThreads)
+	: m_numPending(0), m_stopping(false)
+{
+	if (numThreads == 0)
+		numThreads = GetNumCores();
+
+	for (unsigned int i = 0; i < numThreads; ++i)
+		StartThread();
+}
+
+void WorkerPool::Submit (WorkerJob* job) {
+	// Without any threads the caller does the work
+	if (m_threads.empty()) {
+		job->Run();
+		return;
+	}
+
+	MutexLock lock(m_mutex);
+
+	m_jobs.push_back(job);
+	++m_numPending;
+
+	m_jobQueued.Signal();
+}
+
+void WorkerPool::Wait () {
+	MutexLock lock(m_mutex);
+
+	while (m_numPending > 0)
+		m_jobsDone.Wait(m_mutex);
+}
+
+void WorkerPool::RunJobs () {
+	for (;;) {
+		WorkerJob* job;
+
+		{
+			MutexLock lock(m_mutex);
+
+			while (m_jobs.empty() && !m_stopping)
+				m_jobQueued.Wait(m_mutex);
+
+			if (m_jobs.empty())
+				return;
+
+			job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		job->Run();
+
+		{
+			MutexLock lock(m_mutex);
+
+			if (--m_numPending == 0)
+				m_jobsDone.Broadcast();
+		}
+	}
+}
+
+#ifdef WIN32
+
+WorkerPool::~WorkerPool () {
+	{
+		MutexLock lock(m_mutex);
+		m_stopping = true;
+		m_jobQueued.Broadcast();
+	}
+
+	for (unsigned int i = 0; i < m_threads.size(); ++i) {
+		WaitForSingleObject(m_threads[i], INFINITE);
+		CloseHandle(m_threads[i]);
+	}
+}
+
+unsigned int WorkerPool::GetNumCores () {
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+
+	return systemInfo.dwNumberOfProcessors > 0 ? systemInfo.dwNumberOfProcessors : 1;
+}
+
+void WorkerPool::StartThread () {
+	HANDLE thread = CreateThread(NULL, 0, ThreadMain, this, 0, NULL);
+
+	if (thread == NULL) {
+		printf("WorkerPool::StartThread: Error creating thread.\n");
+		return;
+	}
+
+	m_threads.push_back(thread);
+}
+
+unsigned long __stdcall WorkerPool::ThreadMain (void* pool) {
+	((WorkerPool*)pool)->RunJobs();
+	return 0;
+}
+
+#else
+//***********************************unix specific*********************************
+
+WorkerPool::~WorkerPool () {
+	{
+		MutexLock lock(m_mutex);
+		m_stopping = true;
+		m_jobQueued.Broadcast();
+	}
+
+	for (unsigned int i = 0; i < m_threads.size(); ++i) {
+		pthread_join(*(pthread_t*)m_threads[i], NULL);
+		delete (pthread_t*)m_threads[i];
+	}
+}
+
+unsigned int WorkerPool::GetNumCores () {
+	long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return numCores > 0 ? (unsigned int)numCores : 1;
+}
+
+void WorkerPool::StartThread () {
+	pthread_t* thread = new pthread_t;
+
+	if (pthread_create(thread, NULL, ThreadMain, this) != 0) {
+		printf("WorkerPool::StartThread: Error creating thread.\n");
+		delete thread;
+		return;
+	}
+
+	m_threads.push_back(thread);
+}
+
+void* WorkerPool::ThreadMain (void* pool) {
+	((WorkerPool*)pool)->RunJobs();
+	return NULL;
+}
+
+#endif // unix
@@ -0,0 +1,62 @@
+#ifndef __WORKERPOOL_H__
+#define __WORKERPOOL_H__
+
+#include <deque>
+#include <vector>
+
+#include "Mutex.h"
+
+class WorkerJob
+{
+public:
+	virtual ~WorkerJob () {}
+
+	virtual void Run () = 0;
+};
+
+// Fixed set of threads running queued jobs in submission order.  The pool
+// never owns its jobs, they must stay alive until they have run.
+class WorkerPool
+{
+public:
+	// No thread count means one thread per core
+	WorkerPool (unsigned int numThreads = 0);
+
+	// Runs every job still queued before joining the threads
+	~WorkerPool ();
+
+	void Submit (WorkerJob* job);
+
+	// Blocks until every submitted job has run
+	void Wait ();
+
+	unsigned int GetNumThreads () const { return m_threads.size(); }
+
+	static unsigned int GetNumCores ();
+
+private:
+	WorkerPool (const WorkerPool&);
+	WorkerPool& operator= (const WorkerPool&);
+
+	void StartThread ();
+	void RunJobs ();
+
+#ifdef WIN32
+	static unsigned long __stdcall ThreadMain (void* pool);
+#else
+	static void* ThreadMain (void* pool);
+#endif
+
+	// Platform thread handles
+	std::vector<void*> m_threads;
+
+	Mutex m_mutex;
+	Condition m_jobQueued;
+	Condition m_jobsDone;
+
+	std::deque<WorkerJob*> m_jobs;
+	unsigned int m_numPending;
+	bool m_stopping;
+};
+
+#endif
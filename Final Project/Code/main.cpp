@@ -3,6 +3,7 @@
 // ------------------------
 
 #include <stdlib.h>
+#include <string.h>
 #include <fstream>
 
 #include "Timer.h"
@@ -24,6 +25,8 @@ void loadSettings (std::string settingsFile) {
 		Settings::Get().s_fullScreen = false;
 		Settings::Get().s_windowWidth = 800;
 		Settings::Get().s_windowHeight = 600;
+		Settings::Get().s_textureBudget = 0;
+		Settings::Get().s_occlusionCulling = false;
 		return;
 	}
 
@@ -40,6 +43,27 @@ void loadSettings (std::string settingsFile) {
 
 	Settings::Get().s_windowWidth = screenWidth;
 	Settings::Get().s_windowHeight = screenHeight;
+
+	// Optional settings after the screen line
+	Settings::Get().s_textureBudget = 0;
+	Settings::Get().s_occlusionCulling = false;
+
+	std::string settingType;
+
+	while (is >> settingType) {
+		if (settingType == "texture_budget_mb") {
+			unsigned int textureBudget = 0;
+			is >> textureBudget;
+
+			Settings::Get().s_textureBudget = textureBudget * 1024 * 1024;
+		}
+		else if (settingType == "occlusion_culling") {
+			unsigned int occlusionCulling = 0;
+			is >> occlusionCulling;
+
+			Settings::Get().s_occlusionCulling = occlusionCulling != 0;
+		}
+	}
 }
 
 void initGlut (int& argc, char** argv) { 
@@ -117,6 +141,22 @@ int main (int argc, char** argv) {
 	glewInit();
 
 	gameManager = new GameManager();
+
+	// glutInit has already removed its own arguments
+	for (int i = 1; i + 1 < argc; ++i) {
+		bool opened = true;
+
+		if (strcmp(argv[i], "-record") == 0)
+			opened = gameManager->RecordInput(argv[++i]);
+		else if (strcmp(argv[i], "-replay") == 0)
+			opened = gameManager->ReplayInput(argv[++i]);
+
+		if (!opened) {
+			printf("main: Can't use input log %s.\n", argv[i]);
+			return 1;
+		}
+	}
+
 	gameManager->initGame();
 
 	glutMainLoop();